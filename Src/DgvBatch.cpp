@@ -0,0 +1,710 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : DgvBatch.cpp
+***********************************************************************************/
+// Input files of a command and their conversion by a pool of threads
+// Directories are read with FindFirstFileA on Windows, opendir elsewhere, names are matched by DgvBatch_Match on both
+// Watched files are notified by inotify on Linux, found by polling the directories elsewhere
+// Each thread has its own queue of jobs (files, or any indexed work, see DgvBatch_Jobs), filled largest first,
+// and steals from the end of the other queues when empty
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+#include "Const.h"
+#include "DgvBatch.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define DgvBatch_ListStep 256 // Files allocated at once
+#define DgvBatch_WatchDirsMax 1024 // Directories watched by inotify
+#define DgvBatch_EventsSize 16384 // Bytes of inotify events read at once
+
+struct DgvBatchQueue_Struct // Jobs of a thread, owner takes from Head, other threads from Tail
+{
+	std::mutex Lock;
+	uint32_t* JobIs;
+	uint32_t Head;
+	uint32_t Tail;
+};
+
+struct DgvBatchRun_Struct
+{
+	int16_t (*Process)(const void* Context, uint32_t JobI);
+	const void* Context;
+	struct DgvBatchQueue_Struct Queues[DgvBatch_ThreadsMax];
+	uint32_t NThreads;
+	int16_t* NErrs; // Result of each job
+};
+
+#ifdef __linux__
+struct DgvBatchWatch_Struct // Directories watched by inotify
+{
+	int Fd;
+	int Wds[DgvBatch_WatchDirsMax]; // Watch descriptor of each directory
+	char Dirs[DgvBatch_WatchDirsMax][MaxLenString + 1]; // "" or ending with a separator
+	uint16_t NDirs;
+	bool Recursive;
+};
+#endif
+
+struct DgvBatchFiles_Struct // Files of DgvBatch_Run
+{
+	const struct DgvBatchList_Struct* List;
+	int16_t (*Process)(const void* Context, char* FileName);
+	const void* Context;
+};
+
+
+//-------------------------------------------------------------------------
+// Global variables
+//-------------------------------------------------------------------------
+uint16_t DgvBatch_Threads = 0;
+bool DgvBatch_Recursive = false;
+bool DgvBatch_Watching = false;
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+bool DgvBatch_Match(const char* Name, const char* Mask);
+int16_t DgvBatch_Add(struct DgvBatchList_Struct* List, const char* Dir, const char* Name, uint64_t Size, int64_t MTime);
+const char* DgvBatch_Split(const char* Pattern, char* Dir);
+int16_t DgvBatch_Walk(const char* Dir, const char* Mask, bool Recursive, struct DgvBatchList_Struct* List);
+int DgvBatch_CompareNames(const void* File1, const void* File2);
+int16_t DgvBatch_File(const void* Context, uint32_t JobI);
+const struct DgvBatchFile_Struct* DgvBatch_Lookup(const struct DgvBatchList_Struct* List, const char* Name);
+int16_t DgvBatch_Poll(const char* Pattern, bool Recursive, int16_t (*Convert)(const void* Context, const struct DgvBatchList_Struct* Files), const void* Context);
+#ifdef __linux__
+int16_t DgvBatch_WatchDir(struct DgvBatchWatch_Struct* Watch, const char* Dir);
+int16_t DgvBatch_Notify(const char* Pattern, bool Recursive, int16_t (*Convert)(const void* Context, const struct DgvBatchList_Struct* Files), const void* Context);
+#endif
+bool DgvBatch_NextJob(struct DgvBatchRun_Struct* Run, uint32_t ThreadI, uint32_t* JobI);
+void DgvBatch_Thread(struct DgvBatchRun_Struct* Run, uint32_t ThreadI);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// DgvBatch_Options 
+//-------------------------------------------------------------------------
+// Read and remove batch options (DgvBatch_ThreadsOption N or DgvBatch_ThreadsOption+N, DgvBatch_RecursiveOption, DgvBatch_WatchOption)
+// from arguments, before the options argument ('--...') is searched
+// Output : count of remaining arguments
+int DgvBatch_Options(int argc, char** argv)
+{
+	int ArgI;
+	int OutI = 1;
+	const char* Value;
+
+	for (ArgI = 1; ArgI < argc; ArgI++)
+	{
+		if (strcmp(argv[ArgI], DgvBatch_RecursiveOption) == 0)
+		{
+			DgvBatch_Recursive = true;
+			continue;
+		}
+		if (strcmp(argv[ArgI], DgvBatch_WatchOption) == 0)
+		{
+			DgvBatch_Watching = true;
+			continue;
+		}
+		if (strncmp(argv[ArgI], DgvBatch_ThreadsOption, strlen(DgvBatch_ThreadsOption)) == 0)
+		{
+			Value = argv[ArgI] + strlen(DgvBatch_ThreadsOption);
+			if ((*Value == '\0') && (ArgI + 1 < argc)) { Value = argv[++ArgI]; }
+			DgvBatch_Threads = (uint16_t)atoi(Value);
+			if (DgvBatch_Threads > DgvBatch_ThreadsMax) { DgvBatch_Threads = DgvBatch_ThreadsMax; }
+			continue;
+		}
+		argv[OutI++] = argv[ArgI];
+	}
+	return (OutI);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Find 
+//-------------------------------------------------------------------------
+// Files matching Pattern (directory, then name with '*' and '?'), in subdirectories too if Recursive
+// Output : 0 or negative error, List in name order (to be freed by DgvBatch_Free)
+int16_t DgvBatch_Find(const char* Pattern, bool Recursive, struct DgvBatchList_Struct* List)
+{
+	char Dir[MaxLenString + 1];
+	const char* Mask;
+	int16_t NErr;
+
+	memset(List, 0, sizeof(*List));
+	if (strlen(Pattern) > MaxLenString) { return (-InvalidCmdInputErr); }
+	Mask = DgvBatch_Split(Pattern, Dir);
+	NErr = DgvBatch_Walk(Dir, Mask, Recursive, List);
+	if (List->Count > 1) { qsort(List->Files, List->Count, sizeof(struct DgvBatchFile_Struct), DgvBatch_CompareNames); }
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Split 
+//-------------------------------------------------------------------------
+// Directory of Pattern ("" or ending with a separator) in Dir
+// Output : name part of Pattern
+const char* DgvBatch_Split(const char* Pattern, char* Dir)
+{
+	const char* Mask;
+
+	Mask = Pattern + strlen(Pattern);
+	while ((Mask > Pattern) && (Mask[-1] != '/') && (Mask[-1] != '\\')) { Mask--; }
+	memcpy(Dir, Pattern, Mask - Pattern);
+	Dir[Mask - Pattern] = '\0';
+	return (Mask);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Walk 
+//-------------------------------------------------------------------------
+// Files of directory Dir ("" or ending with a separator) matching Mask are added to List
+int16_t DgvBatch_Walk(const char* Dir, const char* Mask, bool Recursive, struct DgvBatchList_Struct* List)
+{
+	char SubDir[MaxLenString + 1];
+	int16_t NErr = 0;
+#ifdef _WIN32
+	WIN32_FIND_DATAA FindData;
+	HANDLE hFind;
+
+	if (strlen(Dir) + 1 > MaxLenString) { return (0); }
+	strcpy(SubDir, Dir);
+	strcat(SubDir, "*");
+	hFind = FindFirstFileA(SubDir, &FindData);
+	if (hFind == INVALID_HANDLE_VALUE) { return (0); }
+	do
+	{
+		if ((strcmp(FindData.cFileName, ".") == 0) || (strcmp(FindData.cFileName, "..") == 0)) continue;
+		if ((FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+		{
+			if ((!Recursive) || (strlen(Dir) + strlen(FindData.cFileName) + 1 > MaxLenString)) continue;
+			snprintf(SubDir, sizeof(SubDir), "%s%s/", Dir, FindData.cFileName);
+			NErr = DgvBatch_Walk(SubDir, Mask, Recursive, List);
+		}
+		else if (DgvBatch_Match(FindData.cFileName, Mask))
+		{
+			NErr = DgvBatch_Add(List, Dir, FindData.cFileName, ((uint64_t)FindData.nFileSizeHigh << 32) | FindData.nFileSizeLow,
+				(int64_t)(((uint64_t)FindData.ftLastWriteTime.dwHighDateTime << 32) | FindData.ftLastWriteTime.dwLowDateTime));
+		}
+	} while ((NErr >= 0) && (FindNextFileA(hFind, &FindData) != 0));
+	FindClose(hFind);
+#else
+	char Path[MaxLenString + 1];
+	struct dirent* Entry;
+	struct stat Stat;
+	DIR* Directory;
+
+	Directory = opendir(Dir[0] == '\0' ? "." : Dir);
+	if (Directory == NULL) { return (0); }
+	while ((NErr >= 0) && ((Entry = readdir(Directory)) != NULL))
+	{
+		if ((strcmp(Entry->d_name, ".") == 0) || (strcmp(Entry->d_name, "..") == 0)) continue;
+		if (snprintf(Path, sizeof(Path), "%s%s", Dir, Entry->d_name) >= (int)sizeof(Path) - 1) continue; // Room left for a separator
+		if (stat(Path, &Stat) != 0) continue;
+		if (S_ISDIR(Stat.st_mode))
+		{
+			if (!Recursive) continue;
+			if (snprintf(SubDir, sizeof(SubDir), "%s/", Path) >= (int)sizeof(SubDir)) continue;
+			NErr = DgvBatch_Walk(SubDir, Mask, Recursive, List);
+		}
+		else if (DgvBatch_Match(Entry->d_name, Mask))
+		{
+			NErr = DgvBatch_Add(List, Dir, Entry->d_name, (uint64_t)Stat.st_size, (int64_t)Stat.st_mtime);
+		}
+	}
+	closedir(Directory);
+#endif
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Match 
+//-------------------------------------------------------------------------
+// Name matches Mask, '*' for any characters and '?' for one, case insensitive (as extensions, see IsSameStringEnd)
+bool DgvBatch_Match(const char* Name, const char* Mask)
+{
+	const char* Star = NULL; // Last '*' of Mask
+	const char* Retry = NULL; // Position in Name matched by this '*'
+
+	while (*Name != '\0')
+	{
+		if (*Mask == '*')
+		{
+			Star = ++Mask;
+			Retry = Name;
+		}
+		else if ((*Mask == '?') || ((*Mask != '\0') && (toupper((unsigned char)*Mask) == toupper((unsigned char)*Name))))
+		{
+			Mask++;
+			Name++;
+		}
+		else if (Star != NULL)
+		{
+			Mask = Star;
+			Name = ++Retry;
+		}
+		else return (false);
+	}
+	while (*Mask == '*') { Mask++; }
+	return (*Mask == '\0');
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Add 
+//-------------------------------------------------------------------------
+int16_t DgvBatch_Add(struct DgvBatchList_Struct* List, const char* Dir, const char* Name, uint64_t Size, int64_t MTime)
+{
+	struct DgvBatchFile_Struct* Files;
+
+	if (List->Count == List->Max)
+	{
+		Files = (struct DgvBatchFile_Struct*)realloc(List->Files, ((size_t)List->Max + DgvBatch_ListStep) * sizeof(struct DgvBatchFile_Struct));
+		if (Files == NULL) { return (-MemAllocErr); }
+		List->Files = Files;
+		List->Max += DgvBatch_ListStep;
+	}
+	sprintf(List->Files[List->Count].Name, "%s%s", Dir, Name);
+	List->Files[List->Count].Size = Size;
+	List->Files[List->Count].MTime = MTime;
+	List->Count++;
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_CompareNames 
+//-------------------------------------------------------------------------
+int DgvBatch_CompareNames(const void* File1, const void* File2)
+{
+	return (strcmp(((const struct DgvBatchFile_Struct*)File1)->Name, ((const struct DgvBatchFile_Struct*)File2)->Name));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Free 
+//-------------------------------------------------------------------------
+void DgvBatch_Free(struct DgvBatchList_Struct* List)
+{
+	free(List->Files);
+	memset(List, 0, sizeof(*List));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Run 
+//-------------------------------------------------------------------------
+// Process(Context, FileName) for each file of List, by DgvBatch_Threads threads (one per core if 0), largest file first
+// Process runs on any thread, its thread_local state is the one of that thread
+// Output : result of the last file in name order, as when files are processed one after the other
+int16_t DgvBatch_Run(const struct DgvBatchList_Struct* List, int16_t (*Process)(const void* Context, char* FileName), const void* Context)
+{
+	struct DgvBatchFiles_Struct Files;
+	uint64_t* Sizes;
+	uint32_t FileI;
+	int16_t NErr;
+
+	if (List->Count == 0) { return (0); }
+	Sizes = (uint64_t*)malloc(List->Count * sizeof(uint64_t));
+	if (Sizes == NULL) { return (-MemAllocErr); }
+	for (FileI = 0; FileI < List->Count; FileI++) { Sizes[FileI] = List->Files[FileI].Size; }
+	Files.List = List;
+	Files.Process = Process;
+	Files.Context = Context;
+	NErr = DgvBatch_Jobs(List->Count, Sizes, DgvBatch_File, &Files);
+	free(Sizes);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_File 
+//-------------------------------------------------------------------------
+int16_t DgvBatch_File(const void* Context, uint32_t JobI)
+{
+	const struct DgvBatchFiles_Struct* Files = (const struct DgvBatchFiles_Struct*)Context;
+	char FileName[MaxLenString + 1];
+
+	strcpy(FileName, Files->List->Files[JobI].Name);
+	return (Files->Process(Files->Context, FileName));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Jobs 
+//-------------------------------------------------------------------------
+// Process(Context, JobI) for each job 0 to NJobs-1, by DgvBatch_Threads threads (one per core if 0), largest Sizes first
+// Process runs on any thread, its thread_local state is the one of that thread
+// Output : result of the last job, as when jobs are processed one after the other
+int16_t DgvBatch_Jobs(uint32_t NJobs, const uint64_t* Sizes, int16_t (*Process)(const void* Context, uint32_t JobI), const void* Context)
+{
+	struct DgvBatchRun_Struct* Run;
+	std::thread* Threads[DgvBatch_ThreadsMax];
+	uint32_t* Order = NULL;
+	uint32_t ThreadI;
+	uint32_t I;
+	int16_t NErr = 0;
+
+	if (NJobs == 0) { return (0); }
+	Run = new (std::nothrow) DgvBatchRun_Struct();
+	if (Run == NULL) { return (-MemAllocErr); }
+	Run->Process = Process;
+	Run->Context = Context;
+	Run->NThreads = (DgvBatch_Threads != 0 ? DgvBatch_Threads : std::thread::hardware_concurrency()); // 0 if unknown
+	if (Run->NThreads < 1) { Run->NThreads = 1; }
+	if (Run->NThreads > DgvBatch_ThreadsMax) { Run->NThreads = DgvBatch_ThreadsMax; }
+	if (Run->NThreads > NJobs) { Run->NThreads = NJobs; }
+	Run->NErrs = (int16_t*)calloc(NJobs, sizeof(int16_t));
+	Order = (uint32_t*)malloc(NJobs * sizeof(uint32_t));
+	for (ThreadI = 0; ThreadI < Run->NThreads; ThreadI++)
+	{
+		Run->Queues[ThreadI].JobIs = (uint32_t*)malloc((NJobs / Run->NThreads + 1) * sizeof(uint32_t));
+		if (Run->Queues[ThreadI].JobIs == NULL) { NErr = -MemAllocErr; }
+	}
+	if ((Run->NErrs == NULL) || (Order == NULL) || (NErr < 0)) { NErr = -MemAllocErr; goto RunExit; }
+
+	// Largest jobs first (equal sizes keep their order), dealt to the queues in turn
+	for (I = 0; I < NJobs; I++) { Order[I] = I; }
+	std::stable_sort(Order, Order + NJobs, [Sizes](uint32_t A, uint32_t B) { return (Sizes[A] > Sizes[B]); });
+	for (I = 0; I < NJobs; I++)
+	{
+		ThreadI = I % Run->NThreads;
+		Run->Queues[ThreadI].JobIs[Run->Queues[ThreadI].Tail++] = Order[I];
+	}
+
+	if (Run->NThreads == 1)
+	{
+		DgvBatch_Thread(Run, 0); // One job at a time, on the calling thread
+	}
+	else
+	{
+		for (ThreadI = 0; ThreadI < Run->NThreads; ThreadI++)
+		{
+			Threads[ThreadI] = NULL;
+			try
+			{
+				Threads[ThreadI] = new std::thread(DgvBatch_Thread, Run, ThreadI);
+			}
+			catch (...)
+			{
+				// Jobs of this queue are stolen by the other threads, or run below
+			}
+		}
+		for (ThreadI = 0; ThreadI < Run->NThreads; ThreadI++)
+		{
+			if (Threads[ThreadI] != NULL)
+			{
+				Threads[ThreadI]->join();
+				delete Threads[ThreadI];
+			}
+		}
+		DgvBatch_Thread(Run, 0); // Jobs left if no thread could be started
+	}
+	NErr = Run->NErrs[NJobs - 1];
+
+RunExit:
+	for (ThreadI = 0; ThreadI < Run->NThreads; ThreadI++) { free(Run->Queues[ThreadI].JobIs); }
+	free(Run->NErrs);
+	free(Order);
+	delete Run;
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_NextJob 
+//-------------------------------------------------------------------------
+// Next job of thread ThreadI : first one of its queue, or last one of the next non empty queue
+// Output : false if all queues are empty, JobI
+bool DgvBatch_NextJob(struct DgvBatchRun_Struct* Run, uint32_t ThreadI, uint32_t* JobI)
+{
+	struct DgvBatchQueue_Struct* Queue;
+	uint32_t QueueI;
+
+	for (QueueI = 0; QueueI < Run->NThreads; QueueI++)
+	{
+		Queue = &Run->Queues[(ThreadI + QueueI) % Run->NThreads];
+		std::lock_guard<std::mutex> Guard(Queue->Lock);
+		if (Queue->Head == Queue->Tail) continue;
+		if (QueueI == 0) { *JobI = Queue->JobIs[Queue->Head++]; }
+		else { *JobI = Queue->JobIs[--Queue->Tail]; }
+		return (true);
+	}
+	return (false);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Thread 
+//-------------------------------------------------------------------------
+void DgvBatch_Thread(struct DgvBatchRun_Struct* Run, uint32_t ThreadI)
+{
+	uint32_t JobI;
+
+	while (DgvBatch_NextJob(Run, ThreadI, &JobI)) { Run->NErrs[JobI] = Run->Process(Run->Context, JobI); }
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Lookup 
+//-------------------------------------------------------------------------
+// Output : file Name of List (in name order), NULL if none
+const struct DgvBatchFile_Struct* DgvBatch_Lookup(const struct DgvBatchList_Struct* List, const char* Name)
+{
+	struct DgvBatchFile_Struct Key;
+
+	if (List->Count == 0) { return (NULL); }
+	strcpy(Key.Name, Name);
+	return ((const struct DgvBatchFile_Struct*)bsearch(&Key, List->Files, List->Count, sizeof(struct DgvBatchFile_Struct), DgvBatch_CompareNames));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Watch 
+//-------------------------------------------------------------------------
+// Convert(Context, Files) with all files matching Pattern (in subdirectories if Recursive), then with each group of files written
+// Files are given when closed after writing or moved in (inotify on Linux), or when unchanged since the previous poll
+// Only returns on error
+int16_t DgvBatch_Watch(const char* Pattern, bool Recursive, int16_t (*Convert)(const void* Context, const struct DgvBatchList_Struct* Files), const void* Context)
+{
+	if (strlen(Pattern) > MaxLenString) { return (-InvalidCmdInputErr); }
+#ifdef __linux__
+	int16_t NErr;
+
+	NErr = DgvBatch_Notify(Pattern, Recursive, Convert, Context);
+	if (NErr != -DirectoryErr) { return (NErr); }
+#endif
+	return (DgvBatch_Poll(Pattern, Recursive, Convert, Context));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_Poll 
+//-------------------------------------------------------------------------
+// DgvBatch_Watch by listing the files every DgvBatch_PollDelay_ms, a file is converted once unchanged (size and time) between two lists
+int16_t DgvBatch_Poll(const char* Pattern, bool Recursive, int16_t (*Convert)(const void* Context, const struct DgvBatchList_Struct* Files), const void* Context)
+{
+	struct DgvBatchList_Struct Done; // Files as converted
+	struct DgvBatchList_Struct Previous;
+	struct DgvBatchList_Struct Current;
+	struct DgvBatchList_Struct Written;
+	const struct DgvBatchFile_Struct* File;
+	const struct DgvBatchFile_Struct* Before;
+	uint32_t FileI;
+	int16_t NErr;
+
+	memset(&Written, 0, sizeof(Written));
+	NErr = DgvBatch_Find(Pattern, Recursive, &Done); if (NErr < 0) { return (NErr); }
+	Convert(Context, &Done);
+	NErr = DgvBatch_Find(Pattern, Recursive, &Previous);
+	printf("Watching %s (every %d ms)\n", Pattern, DgvBatch_PollDelay_ms);
+	fflush(stdout);
+	while (NErr >= 0)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(DgvBatch_PollDelay_ms));
+		NErr = DgvBatch_Find(Pattern, Recursive, &Current); if (NErr < 0) break;
+		for (FileI = 0; (FileI < Current.Count) && (NErr >= 0); FileI++)
+		{
+			File = &Current.Files[FileI];
+			Before = DgvBatch_Lookup(&Previous, File->Name);
+			if ((Before == NULL) || (Before->Size != File->Size) || (Before->MTime != File->MTime)) continue; // Being written
+			Before = DgvBatch_Lookup(&Done, File->Name);
+			if ((Before != NULL) && (Before->Size == File->Size) && (Before->MTime == File->MTime)) continue;
+			NErr = DgvBatch_Add(&Written, "", File->Name, File->Size, File->MTime);
+		}
+		if ((Written.Count > 0) && (NErr >= 0))
+		{
+			Convert(Context, &Written);
+			for (FileI = 0; (FileI < Written.Count) && (NErr >= 0); FileI++) // Converted as they were listed
+			{
+				File = &Written.Files[FileI];
+				Before = DgvBatch_Lookup(&Done, File->Name);
+				if (Before != NULL) { Done.Files[Before - Done.Files] = *File; }
+				else { NErr = DgvBatch_Add(&Done, "", File->Name, File->Size, File->MTime); }
+			}
+			if (Done.Count > 1) { qsort(Done.Files, Done.Count, sizeof(struct DgvBatchFile_Struct), DgvBatch_CompareNames); }
+			Written.Count = 0;
+		}
+		DgvBatch_Free(&Previous);
+		Previous = Current;
+	}
+	DgvBatch_Free(&Done);
+	DgvBatch_Free(&Previous);
+	DgvBatch_Free(&Written);
+	return (NErr);
+}
+
+
+#ifdef __linux__
+//-------------------------------------------------------------------------
+// DgvBatch_Notify 
+//-------------------------------------------------------------------------
+// DgvBatch_Watch by inotify, files written within DgvBatch_SettleDelay_ms are converted together
+// Output : -DirectoryErr if inotify is not available (nothing converted), else only returns on error
+int16_t DgvBatch_Notify(const char* Pattern, bool Recursive, int16_t (*Convert)(const void* Context, const struct DgvBatchList_Struct* Files), const void* Context)
+{
+	struct DgvBatchWatch_Struct* Watch;
+	struct DgvBatchList_Struct Written;
+	struct inotify_event* Event;
+	struct pollfd PollFd;
+	struct stat Stat;
+	char Dir[MaxLenString + 1];
+	char Path[MaxLenString + 1];
+	char* Events = NULL;
+	const char* Mask;
+	const char* EventDir;
+	ssize_t Len;
+	ssize_t Pos;
+	uint32_t FileI;
+	uint16_t DirI;
+	int Ready;
+	int16_t NErr = 0;
+
+	memset(&Written, 0, sizeof(Written));
+	Watch = (struct DgvBatchWatch_Struct*)calloc(1, sizeof(struct DgvBatchWatch_Struct));
+	if (Watch == NULL) { return (-MemAllocErr); }
+	Watch->Recursive = Recursive;
+	Watch->Fd = inotify_init1(IN_CLOEXEC);
+	Events = (char*)malloc(DgvBatch_EventsSize);
+	Mask = DgvBatch_Split(Pattern, Dir);
+	if ((Watch->Fd < 0) || (Events == NULL) || (DgvBatch_WatchDir(Watch, Dir) < 0))
+	{
+		NErr = -DirectoryErr; // Polled instead
+		goto NotifyExit;
+	}
+
+	// Files already there, then the ones written from now
+	NErr = DgvBatch_Find(Pattern, Recursive, &Written); if (NErr < 0) { goto NotifyExit; }
+	Convert(Context, &Written);
+	DgvBatch_Free(&Written);
+	printf("Watching %s\n", Pattern);
+	fflush(stdout);
+	PollFd.fd = Watch->Fd;
+	PollFd.events = POLLIN;
+	while (NErr >= 0)
+	{
+		Ready = poll(&PollFd, 1, (Written.Count > 0 ? DgvBatch_SettleDelay_ms : -1));
+		if ((Ready < 0) && (errno == EINTR)) continue;
+		if (Ready < 0) { NErr = -FileParamErr; break; }
+		if (Ready == 0) // No more events, files written are converted
+		{
+			if (Written.Count > 1) { qsort(Written.Files, Written.Count, sizeof(struct DgvBatchFile_Struct), DgvBatch_CompareNames); }
+			Convert(Context, &Written);
+			Written.Count = 0;
+			continue;
+		}
+		Len = read(Watch->Fd, Events, DgvBatch_EventsSize);
+		if (Len <= 0) continue;
+		for (Pos = 0; (Pos < Len) && (NErr >= 0); Pos += sizeof(struct inotify_event) + Event->len)
+		{
+			Event = (struct inotify_event*)(Events + Pos);
+			if (Event->len == 0) continue;
+			for (DirI = 0; (DirI < Watch->NDirs) && (Watch->Wds[DirI] != Event->wd); DirI++) {}
+			if (DirI == Watch->NDirs) continue;
+			EventDir = Watch->Dirs[DirI];
+			if (snprintf(Path, sizeof(Path), "%s%s", EventDir, Event->name) >= (int)sizeof(Path) - 1) continue; // Room left for a separator
+			if ((Event->mask & IN_ISDIR) != 0) // New subdirectory, its files are converted too when recursive
+			{
+				if (!Watch->Recursive) continue;
+				strcat(Path, "/");
+				if (DgvBatch_WatchDir(Watch, Path) >= 0) { NErr = DgvBatch_Walk(Path, Mask, true, &Written); }
+				continue;
+			}
+			if ((Event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) == 0) continue; // Created, not written yet
+			if ((!DgvBatch_Match(Event->name, Mask)) || (stat(Path, &Stat) != 0)) continue;
+			for (FileI = 0; (FileI < Written.Count) && (strcmp(Written.Files[FileI].Name, Path) != 0); FileI++) {}
+			if (FileI == Written.Count) { NErr = DgvBatch_Add(&Written, EventDir, Event->name, (uint64_t)Stat.st_size, (int64_t)Stat.st_mtime); }
+		}
+	}
+
+NotifyExit:
+	if (Watch->Fd >= 0) { close(Watch->Fd); }
+	DgvBatch_Free(&Written);
+	free(Events);
+	free(Watch);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvBatch_WatchDir 
+//-------------------------------------------------------------------------
+// Files written in directory Dir ("" or ending with a separator) are notified, in its subdirectories too if Watch->Recursive
+// Output : 0 or negative error
+int16_t DgvBatch_WatchDir(struct DgvBatchWatch_Struct* Watch, const char* Dir)
+{
+	char SubDir[MaxLenString + 1];
+	struct dirent* Entry;
+	struct stat Stat;
+	DIR* Directory;
+	int Wd;
+
+	if (Watch->NDirs == DgvBatch_WatchDirsMax) { return (-DirectoryErr); }
+	Wd = inotify_add_watch(Watch->Fd, (Dir[0] == '\0' ? "." : Dir), IN_CLOSE_WRITE | IN_MOVED_TO | (Watch->Recursive ? IN_CREATE : 0));
+	if (Wd < 0) { return (-DirectoryErr); }
+	Watch->Wds[Watch->NDirs] = Wd;
+	strcpy(Watch->Dirs[Watch->NDirs], Dir);
+	Watch->NDirs++;
+	if (!Watch->Recursive) { return (0); }
+
+	Directory = opendir(Dir[0] == '\0' ? "." : Dir);
+	if (Directory == NULL) { return (0); }
+	while ((Entry = readdir(Directory)) != NULL)
+	{
+		if ((strcmp(Entry->d_name, ".") == 0) || (strcmp(Entry->d_name, "..") == 0)) continue;
+		if (snprintf(SubDir, sizeof(SubDir), "%s%s/", Dir, Entry->d_name) >= (int)sizeof(SubDir)) continue;
+		if ((stat(SubDir, &Stat) == 0) && (S_ISDIR(Stat.st_mode))) { DgvBatch_WatchDir(Watch, SubDir); }
+	}
+	closedir(Directory);
+	return (0);
+}
+#endif
@@ -0,0 +1,79 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef DGVBATCH_H
+#define DGVBATCH_H
+#include <stdint.h> 
+#include "Const.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Batch of input files ('Dgv [-r] [-j N] Files.ext Out.ext')
+//	- Files matching the name pattern ('*' and '?', case insensitive) in its directory, all subdirectories with -r
+//	- Files are converted by a pool of threads (-j N, default one per core), largest first, an idle thread steals
+//	  the jobs queued for another one. Outputs which are gathered (playlist, calibration, reports) are written in name order
+#define DgvBatch_ThreadsMax 64
+#define DgvBatch_ThreadsOption "-j" // Followed by the threads count (0 for one per core), 1 converts one file at a time
+#define DgvBatch_RecursiveOption "-r"
+// Watch mode (--watch) : files are converted once, then each time they are written, until the process is stopped
+//	- Linux : files closed after writing or moved in are converted DgvBatch_SettleDelay_ms after the last one
+//	- Others (or inotify not available) : files are converted once unchanged between two lists, done every DgvBatch_PollDelay_ms
+#define DgvBatch_WatchOption "--watch"
+#define DgvBatch_SettleDelay_ms 100
+#define DgvBatch_PollDelay_ms 500
+
+struct DgvBatchFile_Struct
+{
+	char Name[MaxLenString + 1]; // Path from the pattern directory
+	uint64_t Size;
+	int64_t MTime; // Last modification time (system units)
+};
+
+struct DgvBatchList_Struct // Files in name order
+{
+	struct DgvBatchFile_Struct* Files;
+	uint32_t Count;
+	uint32_t Max; // Allocated count of Files
+};
+
+
+//-------------------------------------------------------------------------
+// Global variables 
+//-------------------------------------------------------------------------
+extern uint16_t DgvBatch_Threads; // Set by main thread only
+extern bool DgvBatch_Recursive;
+extern bool DgvBatch_Watching;
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int DgvBatch_Options(int argc, char** argv);
+int16_t DgvBatch_Find(const char* Pattern, bool Recursive, struct DgvBatchList_Struct* List);
+void DgvBatch_Free(struct DgvBatchList_Struct* List);
+int16_t DgvBatch_Run(const struct DgvBatchList_Struct* List, int16_t (*Process)(const void* Context, char* FileName), const void* Context);
+int16_t DgvBatch_Watch(const char* Pattern, bool Recursive, int16_t (*Convert)(const void* Context, const struct DgvBatchList_Struct* Files), const void* Context);
+int16_t DgvBatch_Jobs(uint32_t NJobs, const uint64_t* Sizes, int16_t (*Process)(const void* Context, uint32_t JobI), const void* Context);
+
+#endif
@@ -0,0 +1,552 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : DgvCache.cpp
+***********************************************************************************/
+// Outputs already written are found by the key of their content (FNV-1a 64 bits hash), see DgvCache.h
+// Records are read from DgvCache_FileName on first use and appended when an output is written, by any thread
+// A key being converted is pending : a thread converting the same program waits for it, then links its output
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <unordered_map>
+#include <sys/stat.h>
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavOut.h"
+#include "DgvCache.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define DgvCache_HashInit 0xCBF29CE484222325ULL // FNV-1a 64 bits offset basis
+#define DgvCache_HashPrime 0x00000100000001B3ULL
+#define DgvCache_RecordsStep 256 // Records allocated at once
+#define DgvCache_PendingMax 256
+#define DgvCache_BufferSize 65536 // Bytes read at once to hash or copy a file
+
+struct DgvCacheRecord_Struct
+{
+	uint64_t Key;
+	uint64_t Size;
+	int64_t MTime;
+	char Name[MaxLenString + 1];
+};
+
+
+//-------------------------------------------------------------------------
+// Global variables
+//-------------------------------------------------------------------------
+bool DgvCache_Force = false;
+
+
+//-------------------------------------------------------------------------
+// Local variables
+//-------------------------------------------------------------------------
+// Shared by all threads, under DgvCache_Lock
+std::mutex DgvCache_Lock;
+std::condition_variable DgvCache_Done; // A pending key is stored
+struct DgvCacheRecord_Struct* DgvCache_Records = NULL;
+uint32_t DgvCache_Count = 0;
+uint32_t DgvCache_Max = 0;
+std::unordered_map<std::string, uint32_t> DgvCache_Names; // Record index of each output name
+std::unordered_multimap<uint64_t, uint32_t> DgvCache_Keys; // Record indexes of each key
+bool DgvCache_Loaded = false;
+uint64_t DgvCache_Pending[DgvCache_PendingMax];
+uint16_t DgvCache_NPending = 0;
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+uint64_t DgvCache_Hash(const void* Data, size_t Len, uint64_t Hash);
+void DgvCache_Load(void);
+void DgvCache_Index(void);
+bool DgvCache_Grow(void);
+void DgvCache_Add(uint64_t Key, uint64_t Size, int64_t MTime, const char* Name);
+bool DgvCache_Stat(const char* Name, uint64_t* Size, int64_t* MTime);
+bool DgvCache_Valid(const struct DgvCacheRecord_Struct* Record);
+bool DgvCache_Link(const char* Existing, const char* FileName);
+bool DgvCache_OldName(const char* FileName, char* OldName);
+bool DgvCache_IsPending(uint64_t Key);
+void DgvCache_Release(uint64_t Key);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// DgvCache_Options 
+//-------------------------------------------------------------------------
+// Read and remove cache options (DgvCache_ForceOption) from arguments
+// Output : count of remaining arguments
+int DgvCache_Options(int argc, char** argv)
+{
+	int ArgI;
+	int OutI = 1;
+
+	for (ArgI = 1; ArgI < argc; ArgI++)
+	{
+		if (strcmp(argv[ArgI], DgvCache_ForceOption) == 0)
+		{
+			DgvCache_Force = true;
+			continue;
+		}
+		argv[OutI++] = argv[ArgI];
+	}
+	return (OutI);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Hash 
+//-------------------------------------------------------------------------
+uint64_t DgvCache_Hash(const void* Data, size_t Len, uint64_t Hash)
+{
+	const uint8_t* Bytes = (const uint8_t*)Data;
+	size_t I;
+
+	for (I = 0; I < Len; I++)
+	{
+		Hash ^= Bytes[I];
+		Hash *= DgvCache_HashPrime;
+	}
+	return (Hash);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_FileKey 
+//-------------------------------------------------------------------------
+// Key of the output Tag (ex: ".dai") converted from the content of file FileName
+// Output : 0 or negative error, Key
+int16_t DgvCache_FileKey(const char* FileName, const char* Tag, uint64_t* Key)
+{
+	uint8_t* Buffer;
+	size_t Len;
+	FILE* File;
+
+	*Key = DgvCache_Hash(DgvCache_Version, strlen(DgvCache_Version), DgvCache_HashInit);
+	*Key = DgvCache_Hash(Tag, strlen(Tag) + 1, *Key);
+	File = fopen(FileName, "rb");
+	if (File == NULL) { return (-FileParamErr); }
+	Buffer = (uint8_t*)malloc(DgvCache_BufferSize);
+	if (Buffer == NULL) { fclose(File); return (-MemAllocErr); }
+	while ((Len = fread(Buffer, 1, DgvCache_BufferSize, File)) > 0) { *Key = DgvCache_Hash(Buffer, Len, *Key); }
+	free(Buffer);
+	fclose(File);
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_RasterKey 
+//-------------------------------------------------------------------------
+// Key of the output FileName (only its extension is used) with Format, of the program in memory with the encoder state of the thread
+// Program blocks, profile in use (tuned or loaded included), options and inter calls delays (calibrated included)
+uint64_t DgvCache_RasterKey(const struct WavFormat_Struct* Format, const char* FileName)
+{
+	const struct DaiHardware_Struct* Profile = WavOut_Profile;
+	const char* Ext;
+	uint64_t Key;
+	uint8_t BkI;
+
+	Key = DgvCache_Hash(DgvCache_Version, strlen(DgvCache_Version), DgvCache_HashInit);
+	Ext = strrchr(FileName, '.');
+	if (Ext != NULL) { Key = DgvCache_Hash(Ext, strlen(Ext) + 1, Key); }
+	Key = DgvCache_Hash(&Glob_ProgType, sizeof(Glob_ProgType), Key);
+	for (BkI = 0; BkI < DataBlock_Count; BkI++)
+	{
+		Key = DgvCache_Hash(&DaiBlocksInfo[BkI].Len, sizeof(DaiBlocksInfo[BkI].Len), Key);
+		if (DaiBlocksInfo[BkI].Block != NULL) { Key = DgvCache_Hash(DaiBlocksInfo[BkI].Block, DaiBlocksInfo[BkI].Len, Key); }
+	}
+	// Fields one by one, without padding bytes
+	Key = DgvCache_Hash(Profile->ProfileName, strlen(Profile->ProfileName) + 1, Key);
+	Key = DgvCache_Hash(Profile->DaiBitPeriods_MinLoops, sizeof(Profile->DaiBitPeriods_MinLoops), Key);
+	Key = DgvCache_Hash(Profile->PeriodsOffset_HwDelay, sizeof(Profile->PeriodsOffset_HwDelay), Key);
+	Key = DgvCache_Hash(&Profile->NChannels, sizeof(Profile->NChannels), Key);
+	Key = DgvCache_Hash(&Profile->Bytes_per_sample, sizeof(Profile->Bytes_per_sample), Key);
+	Key = DgvCache_Hash(&Profile->InvertSignal, sizeof(Profile->InvertSignal), Key);
+	Key = DgvCache_Hash(&Profile->SamplingFq, sizeof(Profile->SamplingFq), Key);
+	Key = DgvCache_Hash(&Profile->Leader_ms, sizeof(Profile->Leader_ms), Key);
+	Key = DgvCache_Hash(&Profile->Trailer_ms, sizeof(Profile->Trailer_ms), Key);
+	Key = DgvCache_Hash(&Format->SamplingFq, sizeof(Format->SamplingFq), Key);
+	Key = DgvCache_Hash(&Format->NChannels, sizeof(Format->NChannels), Key);
+	Key = DgvCache_Hash(&Format->Bytes_per_sample, sizeof(Format->Bytes_per_sample), Key);
+	Key = DgvCache_Hash(&Format->InvertSignal, sizeof(Format->InvertSignal), Key);
+	Key = DgvCache_Hash(&Format->AutoRate, sizeof(Format->AutoRate), Key);
+	Key = DgvCache_Hash(&Format->EdgeShape, sizeof(Format->EdgeShape), Key);
+	Key = DgvCache_Hash(&WavOut_MinLeader, sizeof(WavOut_MinLeader), Key);
+	Key = DgvCache_Hash(&WavOut_IntSlack, sizeof(WavOut_IntSlack), Key);
+	Key = DgvCache_Hash(&WavOut_FastPos, sizeof(WavOut_FastPos), Key);
+	Key = DgvCache_Hash(&WavOut_Turbo, sizeof(WavOut_Turbo), Key);
+	Key = DgvCache_Hash(Glob_InBkInterCallsDelays, sizeof(Glob_InBkInterCallsDelays), Key);
+	Key = DgvCache_Hash(Glob_OutBkInterCallsDelays, sizeof(Glob_OutBkInterCallsDelays), Key);
+	return (Key);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Find 
+//-------------------------------------------------------------------------
+// Output file FileName with Key is up to date, or linked from an existing output with Key
+// Output : true if FileName is up to date, else Key is pending until DgvCache_Store is called by the same thread
+// The link (or copy) is made out of DgvCache_Lock, Key is pending meanwhile
+// A previous FileName is renamed with DgvCache_OldExt, it is restored by DgvCache_Store if the new one is not written
+bool DgvCache_Find(uint64_t Key, const char* FileName)
+{
+	std::unique_lock<std::mutex> Guard(DgvCache_Lock);
+	std::unordered_map<std::string, uint32_t>::iterator Named;
+	std::pair<std::unordered_multimap<uint64_t, uint32_t>::iterator, std::unordered_multimap<uint64_t, uint32_t>::iterator> Keyed;
+	char Existing[MaxLenString + 1];
+	char OldName[MaxLenString + 1];
+	uint64_t Size;
+	int64_t MTime;
+	bool Linked;
+
+	DgvCache_Load();
+	while (DgvCache_IsPending(Key)) { DgvCache_Done.wait(Guard); } // Same output being written by another thread
+	Existing[0] = '\0';
+	if (!DgvCache_Force)
+	{
+		Named = DgvCache_Names.find(FileName); // Same file first
+		if ((Named != DgvCache_Names.end()) && (DgvCache_Records[Named->second].Key == Key) && (DgvCache_Valid(&DgvCache_Records[Named->second])))
+		{
+			return (true);
+		}
+		for (Keyed = DgvCache_Keys.equal_range(Key); (Keyed.first != Keyed.second) && (Existing[0] == '\0'); Keyed.first++)
+		{
+			if (DgvCache_Valid(&DgvCache_Records[Keyed.first->second])) { strcpy(Existing, DgvCache_Records[Keyed.first->second].Name); }
+		}
+	}
+	if (DgvCache_NPending < DgvCache_PendingMax) { DgvCache_Pending[DgvCache_NPending++] = Key; }
+	// Written again, not through a link shared with another output
+	if (DgvCache_OldName(FileName, OldName)) { remove(OldName); rename(FileName, OldName); }
+	else { remove(FileName); }
+	if (Existing[0] != '\0')
+	{
+		Guard.unlock();
+		Linked = (DgvCache_Link(Existing, FileName)) && (DgvCache_Stat(FileName, &Size, &MTime));
+		Guard.lock();
+		if (Linked)
+		{
+			DgvCache_Release(Key);
+			DgvCache_Add(Key, Size, MTime, FileName);
+			DgvCache_Done.notify_all();
+			if (DgvCache_OldName(FileName, OldName)) { remove(OldName); }
+			return (true);
+		}
+	}
+	return (false);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Store 
+//-------------------------------------------------------------------------
+// Output file FileName with Key is written (NErr = 0) or not (negative error), Key is no more pending
+// Previous FileName (see DgvCache_Find) is removed, or restored if FileName is not written
+void DgvCache_Store(uint64_t Key, const char* FileName, int16_t NErr)
+{
+	std::lock_guard<std::mutex> Guard(DgvCache_Lock);
+	char OldName[MaxLenString + 1];
+	uint64_t Size;
+	int64_t MTime;
+
+	DgvCache_Release(Key);
+	if ((NErr >= 0) && (DgvCache_Stat(FileName, &Size, &MTime))) { DgvCache_Add(Key, Size, MTime, FileName); }
+	if (DgvCache_OldName(FileName, OldName))
+	{
+		if (NErr >= 0) { remove(OldName); }
+		else if (DgvCache_Stat(OldName, &Size, &MTime)) { remove(FileName); rename(OldName, FileName); } // Partial output replaced by the previous one
+	}
+	DgvCache_Done.notify_all();
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Load 
+//-------------------------------------------------------------------------
+// Records of DgvCache_FileName, the file is written again without the records replaced by later ones
+void DgvCache_Load(void)
+{
+	struct DgvCacheRecord_Struct* Record;
+	char Line[MaxLenString + 64];
+	uint32_t NLines;
+	uint32_t RecordI;
+	size_t Len;
+	unsigned long long Key;
+	unsigned long long Size;
+	long long MTime;
+	int NameStart;
+	FILE* File;
+
+	if (DgvCache_Loaded) { return; }
+	File = fopen(DgvCache_FileName, "r");
+	if (File == NULL) { DgvCache_Loaded = true; return; }
+	while (fgets(Line, sizeof(Line), File) != NULL)
+	{
+		Len = strlen(Line);
+		while ((Len > 0) && ((Line[Len - 1] == '\n') || (Line[Len - 1] == '\r'))) { Line[--Len] = '\0'; }
+		if (sscanf(Line, "%llx %llu %lld %n", &Key, &Size, &MTime, &NameStart) != 3) continue;
+		if ((Line[NameStart] == '\0') || (strlen(Line + NameStart) > MaxLenString)) continue;
+		if (!DgvCache_Grow()) break;
+		Record = &DgvCache_Records[DgvCache_Count++];
+		Record->Key = Key;
+		Record->Size = Size;
+		Record->MTime = MTime;
+		strcpy(Record->Name, Line + NameStart);
+	}
+	fclose(File);
+	NLines = DgvCache_Count;
+	DgvCache_Index();
+	DgvCache_Loaded = true; // Next records are appended
+	if (NLines == DgvCache_Count) { return; }
+	File = fopen(DgvCache_FileName, "w");
+	if (File == NULL) { return; }
+	for (RecordI = 0; RecordI < DgvCache_Count; RecordI++)
+	{
+		Record = &DgvCache_Records[RecordI];
+		fprintf(File, "%016llx %llu %lld %s\n", (unsigned long long)Record->Key, (unsigned long long)Record->Size, (long long)Record->MTime, Record->Name);
+	}
+	fclose(File);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Index 
+//-------------------------------------------------------------------------
+// Index records read from DgvCache_FileName by name and key
+// A record replaces the previous one of its name, at the place of the previous one
+void DgvCache_Index(void)
+{
+	std::unordered_map<std::string, uint32_t>::iterator Named;
+	uint32_t RecordI;
+	uint32_t OutI = 0;
+
+	DgvCache_Names.reserve(DgvCache_Count);
+	for (RecordI = 0; RecordI < DgvCache_Count; RecordI++)
+	{
+		Named = DgvCache_Names.find(DgvCache_Records[RecordI].Name);
+		if (Named != DgvCache_Names.end())
+		{
+			DgvCache_Records[Named->second] = DgvCache_Records[RecordI];
+			continue;
+		}
+		if (OutI != RecordI) { DgvCache_Records[OutI] = DgvCache_Records[RecordI]; }
+		DgvCache_Names.emplace(DgvCache_Records[OutI].Name, OutI);
+		OutI++;
+	}
+	DgvCache_Count = OutI;
+	DgvCache_Keys.reserve(DgvCache_Count);
+	for (RecordI = 0; RecordI < DgvCache_Count; RecordI++) { DgvCache_Keys.emplace(DgvCache_Records[RecordI].Key, RecordI); }
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Grow 
+//-------------------------------------------------------------------------
+// Output : false if there is no room for one more record
+bool DgvCache_Grow(void)
+{
+	struct DgvCacheRecord_Struct* Records;
+
+	if (DgvCache_Count < DgvCache_Max) { return (true); }
+	Records = (struct DgvCacheRecord_Struct*)realloc(DgvCache_Records, ((size_t)DgvCache_Max + DgvCache_RecordsStep) * sizeof(struct DgvCacheRecord_Struct));
+	if (Records == NULL) { return (false); }
+	DgvCache_Records = Records;
+	DgvCache_Max += DgvCache_RecordsStep;
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Add 
+//-------------------------------------------------------------------------
+// Record of output Name, replaces the previous one of this name. Appended to DgvCache_FileName once loaded
+void DgvCache_Add(uint64_t Key, uint64_t Size, int64_t MTime, const char* Name)
+{
+	std::unordered_map<std::string, uint32_t>::iterator Named;
+	std::pair<std::unordered_multimap<uint64_t, uint32_t>::iterator, std::unordered_multimap<uint64_t, uint32_t>::iterator> Keyed;
+	uint32_t RecordI;
+	FILE* File;
+
+	Named = DgvCache_Names.find(Name);
+	if (Named != DgvCache_Names.end())
+	{
+		RecordI = Named->second;
+		for (Keyed = DgvCache_Keys.equal_range(DgvCache_Records[RecordI].Key); Keyed.first != Keyed.second; Keyed.first++)
+		{
+			if (Keyed.first->second == RecordI) { DgvCache_Keys.erase(Keyed.first); break; }
+		}
+	}
+	else
+	{
+		if (!DgvCache_Grow()) { return; } // Not recorded, converted again next time
+		RecordI = DgvCache_Count++;
+		DgvCache_Names.emplace(Name, RecordI);
+	}
+	DgvCache_Keys.emplace(Key, RecordI);
+	DgvCache_Records[RecordI].Key = Key;
+	DgvCache_Records[RecordI].Size = Size;
+	DgvCache_Records[RecordI].MTime = MTime;
+	strcpy(DgvCache_Records[RecordI].Name, Name);
+	if (!DgvCache_Loaded) { return; }
+	File = fopen(DgvCache_FileName, "a");
+	if (File == NULL) { return; }
+	fprintf(File, "%016llx %llu %lld %s\n", (unsigned long long)Key, (unsigned long long)Size, (long long)MTime, Name);
+	fclose(File);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Stat 
+//-------------------------------------------------------------------------
+// Output : false if file Name does not exist, Size and MTime
+bool DgvCache_Stat(const char* Name, uint64_t* Size, int64_t* MTime)
+{
+	struct stat Stat;
+
+	if (stat(Name, &Stat) != 0) { return (false); }
+	*Size = (uint64_t)Stat.st_size;
+	*MTime = (int64_t)Stat.st_mtime;
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Valid 
+//-------------------------------------------------------------------------
+// Output file of Record exists and has not changed since it was written
+bool DgvCache_Valid(const struct DgvCacheRecord_Struct* Record)
+{
+	uint64_t Size;
+	int64_t MTime;
+
+	if (!DgvCache_Stat(Record->Name, &Size, &MTime)) { return (false); }
+	return ((Size == Record->Size) && (MTime == Record->MTime));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Link 
+//-------------------------------------------------------------------------
+// FileName is a hard link to file Existing, or a copy of it when links are not supported (ex: other volume)
+// Output : false if FileName could not be written
+bool DgvCache_Link(const char* Existing, const char* FileName)
+{
+	uint8_t* Buffer;
+	size_t Len;
+	FILE* In;
+	FILE* Out;
+	bool Done = true;
+#ifndef _WIN32
+	struct stat ExistingStat;
+	struct stat Stat;
+
+	if ((stat(Existing, &ExistingStat) == 0) && (stat(FileName, &Stat) == 0) &&
+		(ExistingStat.st_dev == Stat.st_dev) && (ExistingStat.st_ino == Stat.st_ino)) { return (true); } // Already linked
+#endif
+
+	remove(FileName);
+#ifdef _WIN32
+	if (CreateHardLinkA(FileName, Existing, NULL) != 0) { return (true); }
+#else
+	if (link(Existing, FileName) == 0) { return (true); }
+#endif
+	In = fopen(Existing, "rb");
+	if (In == NULL) { return (false); }
+	Out = fopen(FileName, "wb");
+	Buffer = (uint8_t*)malloc(DgvCache_BufferSize);
+	if ((Out == NULL) || (Buffer == NULL)) { Done = false; }
+	while ((Done) && ((Len = fread(Buffer, 1, DgvCache_BufferSize, In)) > 0))
+	{
+		Done = (fwrite(Buffer, 1, Len, Out) == Len);
+	}
+	free(Buffer);
+	fclose(In);
+	if (Out != NULL) { fclose(Out); }
+	if (!Done) { remove(FileName); }
+	return (Done);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_OldName 
+//-------------------------------------------------------------------------
+// Name of the previous output FileName while the new one is written
+// Output : false if the name is too long, previous output is then removed
+bool DgvCache_OldName(const char* FileName, char* OldName)
+{
+	if (strlen(FileName) + strlen(DgvCache_OldExt) > MaxLenString) { return (false); }
+	strcpy(OldName, FileName);
+	strcat(OldName, DgvCache_OldExt);
+	return (true);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_IsPending 
+//-------------------------------------------------------------------------
+bool DgvCache_IsPending(uint64_t Key)
+{
+	uint16_t PendingI;
+
+	for (PendingI = 0; PendingI < DgvCache_NPending; PendingI++)
+	{
+		if (DgvCache_Pending[PendingI] == Key) { return (true); }
+	}
+	return (false);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCache_Release 
+//-------------------------------------------------------------------------
+// Key is no more pending, waiting threads are notified by the caller
+void DgvCache_Release(uint64_t Key)
+{
+	uint16_t PendingI;
+
+	for (PendingI = 0; PendingI < DgvCache_NPending; PendingI++)
+	{
+		if (DgvCache_Pending[PendingI] == Key)
+		{
+			DgvCache_Pending[PendingI] = DgvCache_Pending[--DgvCache_NPending];
+			break;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef DGVCACHE_H
+#define DGVCACHE_H
+#include <stdint.h> 
+#include "Const.h"
+#include "WavIO.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Cache of converted files, an output is not written again if its key is the one of an existing output file
+//	- dai from a wav or csw capture : key of the capture content
+//	- wav or csw from a program : key of the program blocks, profile, format and delays in use (see DgvCache_RasterKey)
+// An identical output under another name (same program in several captures) is hard linked, or copied, from the existing one
+// Outputs are recorded in DgvCache_FileName (current directory) : key, size, modification time and name, one per line
+#define DgvCache_Enabled 1
+#define DgvCache_FileName "Dgv.cache"
+#define DgvCache_Version "Dgv v0.2.0 cache 2" // Part of all keys, to be changed when the encoder or decoder output changes
+#define DgvCache_ForceOption "-f" // Files are converted again (and recorded)
+#define DgvCache_OldExt ".dgvold" // Previous output kept under FileName + DgvCache_OldExt until the new one is written
+
+
+//-------------------------------------------------------------------------
+// Global variables 
+//-------------------------------------------------------------------------
+extern bool DgvCache_Force; // Set by main thread only
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int DgvCache_Options(int argc, char** argv);
+int16_t DgvCache_FileKey(const char* FileName, const char* Tag, uint64_t* Key);
+uint64_t DgvCache_RasterKey(const struct WavFormat_Struct* Format, const char* FileName);
+bool DgvCache_Find(uint64_t Key, const char* FileName);
+void DgvCache_Store(uint64_t Key, const char* FileName, int16_t NErr);
+
+#endif
@@ -35,19 +35,80 @@
 #include "DgvMain.h"
 #include "WavOut.h"
 #include "WavIn.h"
+#include "WavTune.h"
+#include "WavValid.h"
+#include "WavEst.h"
+#include "WavCalib.h"
+#include "WavGrid.h"
+#include "WavList.h"
+#include "WavTurbo.h"
+#include "WavCsw.h"
+#include "DgvBatch.h"
+#include "DgvCache.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+struct DgvCommand_Struct // Command shared by the threads converting its files (see DgvBatch_Run)
+{
+	const char* FileOut;
+	const char* Options;
+	bool WavToStdout;
+	bool Validate;
+	bool Calibrate;
+	bool Estimate;
+	bool CswOut;
+	bool SignalOut; // wav or csw output
+	const char* OutExt;
+	const char* OutAll; // Output name taken from the input one
+	struct WavOutConfig_Struct Config; // Encoder configuration of the command
+};
+
+#define DgvProfiles_Max 16 // Bits of DaiHwI_BitMask
+
+struct DgvProgram_Struct // Program read once for all profiles, its blocks are shared by the threads
+{
+	struct DaiBlock_Struct Blocks[DataBlock_Count];
+	uint8_t ProgType;
+	char DaiFileName[MaxLenString+1];
+	char WavFileName[MaxLenString+1]; // Profile and options are inserted by DgvWavOutFiles
+	int16_t NErr; // Reading error
+};
+
+struct DgvProfiles_Struct // Programs rendered for each profile (see DgvCommandProfiles)
+{
+	struct DgvProgram_Struct* Programs;
+	uint32_t NPrograms;
+	struct WavOutConfig_Struct Configs[DgvProfiles_Max];
+	uint16_t NConfigs;
+};
+
+struct DgvWatch_Struct // Command processing the files written (see DgvCommandWatch)
+{
+	const char* FileOut; // NULL for 'Dgv' without names
+	char* OptionsArg; // Options argument of the profiles
+	struct WavOutConfig_Struct Config; // Encoder configuration of the command
+};
 
 
 //-------------------------------------------------------------------------
 // Global variables
 //-------------------------------------------------------------------------
-int8_t   Glob_PosInFile;
-int8_t   Glob_PosInBlock;
-int8_t   Glob_BlockI;
-uint16_t  Glob_DaiHw;
+thread_local int8_t   Glob_PosInFile;
+thread_local int8_t   Glob_PosInBlock;
+thread_local int8_t   Glob_BlockI;
+thread_local uint16_t  Glob_DaiHw;
 
 //---------------
 // Processed position in program / table information 
-uint16_t Glob_InterK7ReadDelay; // Delay in CpuCycles between return and call of Read Bit function, including Enter & Exit delays
+thread_local uint16_t Glob_InterK7ReadDelay; // Delay in CpuCycles between return and call of Read Bit function, including Enter & Exit delays
+
+//---------------
+// Firmware delays between Read Bit calls in use, InBkInterCallsDelays / OutBkInterCallsDelays or learned ones (see WavCalib)
+// Part of the encoder configuration of each thread (see WavOut_SetConfig)
+thread_local uint16_t Glob_InBkInterCallsDelays[DataBlock_Count][PosInBlock_Count];
+thread_local uint16_t Glob_OutBkInterCallsDelays[ProgType_Count][PosInFile_Count];
 
 //-------------------------------------------------------------------------
 // Local variables
@@ -59,15 +120,19 @@ uint16_t Glob_InterK7ReadDelay; // Delay in CpuCycles between return and call of
 //-------------------------------------------------------------------------
 void PrintHelp(int16_t NErr);
 int16_t DgvCommand(const char* FileSearchIn, const char* FileOut, const char* Options);
+int16_t DgvCommandJob(const void* Context, char* FileName);
+int16_t DgvCommandFile(const struct DgvCommand_Struct* Cmd, char* FileName, bool* Stop);
+int16_t DgvCommandList(const struct DgvBatchList_Struct* List, const char* FileOut, const char* Options);
+int16_t DgvCommandProfiles(const char* FileSearchIn, char* Options);
+int16_t DgvProfilesList(const struct DgvBatchList_Struct* List, char* Options);
+int16_t DgvCommandWatch(const char* FileSearchIn, const char* FileOut, char* Options);
+int16_t DgvCommandWatched(const void* Context, const struct DgvBatchList_Struct* Files);
+int16_t DgvCommandProfile(const void* Context, uint32_t JobI);
+int16_t DgvWavOutFiles(const char* WavFileName, const char* Options, bool WavToStdout);
+int16_t DgvWavOutCached(struct WavRaster_Struct* Rasters, uint8_t NRasters);
 
 
-bool IsSameStringEnd(const char* StringIn, const char* StringEnd);
-void DgvOutVersions(char* FileIn);
-void SetVersion(int16_t Ver);
-
 int16_t StrCmpUp(const char* S1,const char* S2);
-void ChangeFileExt(const char* NewExt, const char* FileNameIn, char* FileNameOut);
-void InsertStringBefExt(const char* InsertS, const char* FileNameIn, char* FileNameOut);
 
 
 //=========================================================================
@@ -77,16 +142,16 @@ void InsertStringBefExt(const char* InsertS, const char* FileNameIn, char* FileN
 int main(int argc, char** argv)
 {
 	int16_t  NErr = 0;
-	uint16_t UpdatedOptionBits = 0;
+	uint32_t UpdatedOptionBits = 0;
 	uint8_t Argi = 0;
 	uint8_t NArgNames = 0;
-	uint16_t DaiHwI ;
-	uint16_t DaiHwI_BitI; 
 	DaiBlocksInfo[0].Block = NULL; // For debug ?
 	DaiBlocksInfo[1].Block = NULL;
 	DaiBlocksInfo[2].Block = NULL;
 	SetWavOutParameters(DaiHW_Default); // Default values 	
 
+	argc = DgvBatch_Options(argc, argv); // Batch options (threads, subdirectories) are removed from arguments
+	argc = DgvCache_Options(argc, argv);
 	if ((argc == 2)&&(strcmp(argv[1], "?") == 0))
 	{
 			NErr = -HelpRequestErr;
@@ -104,37 +169,39 @@ int main(int argc, char** argv)
 	{
 		NArgNames--;
 	}
-	// UpdatedOptionBits = UpdatedOptionBits & (~(uint16_t)OptionBit_OptionArgument); // Useless 
+	// UpdatedOptionBits = UpdatedOptionBits & (~(uint32_t)OptionBit_OptionArgument); // Useless 
 
 	if (NArgNames==0)
 	{
 		// Transform all .wav in .dai, and .dai in .wav
 		UpdatedOptionBits = LoadProgOptionsArgument(argv[Argi]);
 		Update_WavOut_NameOptions(WavOut_NameOptions);
-		NErr = DgvCommand("*.wav", "*.dai", WavOut_NameOptions);
-		// Transform all .dai in _Dgv.wav
-		DaiHwI_BitI = 1;
-		for (DaiHwI = 0; DaiHwI < 16; DaiHwI++)
+		if (DgvBatch_Watching)
 		{
-			if ((DaiHwI_BitI & DaiHwI_BitMask) != 0)
-			{
-				SetWavOutParameters(DaiHwI);
-				UpdatedOptionBits = LoadProgOptionsArgument(argv[Argi]);
-				Update_WavOut_NameOptions(WavOut_NameOptions);
-				NErr = DgvCommand("*.dai", "*.wav", WavOut_NameOptions);
-			}
-			DaiHwI_BitI = DaiHwI_BitI  << 1 ;
+			NErr = DgvCommandWatch("*", NULL, argv[Argi]);
+			goto ExitMain;
 		}
+		NErr = DgvCommand("*.wav", "*.dai", WavOut_NameOptions);
+		// Transform all .dai in _Dgv.wav, for each profile of DaiHwI_BitMask
+		NErr = DgvCommandProfiles("*.dai", argv[Argi]);
 	}
 	else if (NArgNames == 1)
 		{
 			UpdatedOptionBits = LoadProgOptionsArgument(argv[Argi]);
 			Update_WavOut_NameOptions(WavOut_NameOptions);
-			if (IsSameStringEnd(argv[1], ".dai"))
+			if ((IsSameStringEnd(argv[1], ".dai")) && (DgvBatch_Watching))
+			{
+				NErr = DgvCommandWatch(argv[1], "*.wav", argv[Argi]);
+			}
+			else if (IsSameStringEnd(argv[1], ".dai"))
 			{
 				NErr = DgvCommand(argv[1], "*.wav", WavOut_NameOptions);
 			}
-			else if(IsSameStringEnd(argv[1], ".wav"))
+			else if (((IsSameStringEnd(argv[1], ".wav")) || (IsSameStringEnd(argv[1], WavCsw_Ext))) && (DgvBatch_Watching))
+			{
+				NErr = DgvCommandWatch(argv[1], "*.dai", argv[Argi]);
+			}
+			else if ((IsSameStringEnd(argv[1], ".wav")) || (IsSameStringEnd(argv[1], WavCsw_Ext)))
 			{
 				NErr = DgvCommand(argv[1], "*.dai", WavOut_NameOptions);
 			}
@@ -144,7 +211,9 @@ int main(int argc, char** argv)
 	{
 		UpdatedOptionBits = LoadProgOptionsArgument(argv[Argi]); 
 		Update_WavOut_NameOptions(WavOut_NameOptions);
-		NErr = DgvCommand(argv[1], argv[2], WavOut_NameOptions);
+		if (DgvBatch_Watching) { NErr = DgvCommandWatch(argv[1], argv[2], argv[Argi]); }
+		else if (IsSameStringEnd(argv[2], WavEst_Ext)) { NErr = DgvCommand(argv[1], argv[2], (UpdatedOptionBits != 0 ? argv[Argi] : "")); } // Options of every profile
+		else { NErr = DgvCommand(argv[1], argv[2], WavOut_NameOptions); }
 		goto ExitMain;
 	}
 	else 
@@ -164,120 +233,534 @@ ExitMain:
 //-------------------------------------------------------------------------
 // Process file according to valid inputs of a 2 parameters commnad line (with an potentially additional Option parameter)
 // See help below for parameters structure (ex: Option ='--AI2')
+// FileOut = WavOut_StdoutName ("-") streams the wav of the first input file to standard output
+// A csw file (see WavCsw) is read as a wav file. It is written as a wav file from a dai file, and converted from / to a wav file
+// Input files are listed by DgvBatch_Find (see DgvCommandList)
 int16_t DgvCommand (const char * FileSearchIn, const char* FileOut, const char* Options)
 {
 	int16_t  NErr = 0;
-	char WavFileName[MaxLenString+1]; 	
-	char DaiFileName[MaxLenString+1];
+	struct DgvBatchList_Struct List;
 
-	HANDLE hFind;
-	WIN32_FIND_DATAA* FindData = NULL ;
 	if (strlen(FileSearchIn) < 4) // Invalin File in or option
 	{
-		NErr = -InvalidCmdInputErr;
-		goto DgvComErr;
+		return(-InvalidCmdInputErr);
 	}
 	// 2 arguments and possibly options
 	if ( (!IsSameStringEnd(FileSearchIn, ".wav")) &&
- (!IsSameStringEnd(FileSearchIn, ".dai")) ) // Invalid extension for input files
+ (!IsSameStringEnd(FileSearchIn, ".dai")) && (!IsSameStringEnd(FileSearchIn, WavCsw_Ext)) ) // Invalid extension for input files
 	{
-		NErr = -InvalidCmdInputErr ;
-		goto DgvComErr;
+		return(-InvalidCmdInputErr);
 	}
 
-	FindData = (WIN32_FIND_DATAA*)malloc(sizeof(WIN32_FIND_DATAA));
-	if (FindData == NULL) { return(-MemAllocErr); }
-	hFind = FindFirstFileA(FileSearchIn, FindData);
-	if (hFind != INVALID_HANDLE_VALUE)
+	NErr = DgvBatch_Find(FileSearchIn, DgvBatch_Recursive, &List);
+	if (NErr >= 0) { NErr = DgvCommandList(&List, FileOut, Options); }
+	DgvBatch_Free(&List);
+	return(NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCommandList 
+//-------------------------------------------------------------------------
+// Process the files of List (wav, csw or dai, see DgvCommand) to FileOut
+// Files with their own output (FileOut "*.ext") are converted by the threads of DgvBatch_Run,
+// others (single output, playlist, grid, tuning, calibration, validation, estimate) one after the other in name order
+int16_t DgvCommandList(const struct DgvBatchList_Struct* List, const char* FileOut, const char* Options)
+{
+	int16_t  NErr = 0;
+	char WavFileName[MaxLenString+1]; 	
+	char ReportName[MaxLenString+1];
+	struct DgvCommand_Struct Cmd;
+	uint32_t FileI;
+	bool Stop = false;
+	bool Parallel;
+
+	Cmd.FileOut = FileOut;
+	Cmd.Options = Options;
+	Cmd.WavToStdout = (strcmp(FileOut, WavOut_StdoutName) == 0);
+	Cmd.CswOut = IsSameStringEnd(FileOut, WavCsw_Ext);
+	Cmd.SignalOut = ((IsSameStringEnd(FileOut, ".wav")) || (Cmd.CswOut) || (Cmd.WavToStdout));
+	Cmd.OutExt = (Cmd.CswOut ? WavCsw_Ext : ".wav");
+	Cmd.OutAll = (Cmd.CswOut ? "*" WavCsw_Ext : "*.wav");
+	Cmd.Validate = IsSameStringEnd(FileOut, WavValid_Ext);
+	Cmd.Calibrate = IsSameStringEnd(FileOut, WavCalib_Ext);
+	Cmd.Estimate = IsSameStringEnd(FileOut, WavEst_Ext);
+	WavOut_GetConfig(&Cmd.Config);
+
+	// Each output file named from its input file, no state shared between files
+	Parallel = ((List->Count > 1) && (((Cmd.SignalOut) && (IsSameStringEnd(FileOut, Cmd.OutAll))) ||
+		((IsSameStringEnd(FileOut, "*.dai")) && (!IsSameStringEnd(List->Files[0].Name, ".dai")))) &&
+		(!Cmd.WavToStdout) && (!WavOut_Playlist) && (!WavOut_Grid) && (WavOut_TuneMargin == WavOut_TuneOff) &&
+		(!Cmd.Validate) && (!Cmd.Calibrate) && (!Cmd.Estimate) && (DgvBatch_Threads != 1));
+	if (Parallel)
+	{
+		NErr = DgvBatch_Run(List, DgvCommandJob, &Cmd);
+	}
+	else
+	{
+		for (FileI = 0; (FileI < List->Count) && (!Stop); FileI++)
+		{
+			NErr = DgvCommandFile(&Cmd, List->Files[FileI].Name, &Stop);
+		}
+	}
+	if ((WavOut_Playlist) && (Cmd.SignalOut)) // All programs in one wav
+	{
+		strcpy(WavFileName, FileOut);
+		if (IsSameStringEnd(WavFileName, Cmd.OutAll)) { ChangeFileExt(Cmd.OutExt, WavList_DefaultName, WavFileName); }
+		NErr = DgvWavOutFiles(WavFileName, Options, Cmd.WavToStdout);
+	}
+	if (Cmd.Calibrate) // Learned delays of all captures
+	{
+		strcpy(ReportName, FileOut);
+		if (IsSameStringEnd(ReportName, "*" WavCalib_Ext)) { strcpy(ReportName, WavCalib_FileName); }
+		NErr = WavCalib_Write(ReportName);
+	}
+	return(NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCommandJob 
+//-------------------------------------------------------------------------
+// One file of a command on a thread of DgvBatch_Run, with the encoder configuration of the command
+int16_t DgvCommandJob(const void* Context, char* FileName)
+{
+	const struct DgvCommand_Struct* Cmd = (const struct DgvCommand_Struct*)Context;
+	bool Stop;
+
+	WavOut_SetConfig(&Cmd->Config);
+	return (DgvCommandFile(Cmd, FileName, &Stop));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCommandFile 
+//-------------------------------------------------------------------------
+// Process input file FileName of a command
+// Output : 0 or negative error, Stop if next files of the command are not processed
+int16_t DgvCommandFile(const struct DgvCommand_Struct* Cmd, char* FileName, bool* Stop)
+{
+	int16_t  NErr = 0;
+	char WavFileName[MaxLenString+1]; 	
+	char DaiFileName[MaxLenString+1];
+	char ReportName[MaxLenString+1];
+	const char* FileOut = Cmd->FileOut;
+	uint64_t Key;
+
+	*Stop = false;
+	if ((NotDgvFile(FileName)) || (Cmd->Validate)) // Do not process any Dgv file, except to validate it
 	{
-		// For each valid input files with name FindData->cFileName
-		do
+		if ((IsSameStringEnd(FileName, ".wav")) || (IsSameStringEnd(FileName, WavCsw_Ext))) // wav or csw to ...
 		{
-			NErr = 0;
-			if (NotDgvFile(FindData->cFileName)) // Do not process any Dgv file
+			if (Cmd->Validate) // wav validation report
 			{
-				if (IsSameStringEnd(FindData->cFileName, ".wav")) // wav to ...
+				strcpy(ReportName, FileOut);
+				if (IsSameStringEnd(ReportName, "*" WavValid_Ext)) // Input file name will be used (without extension)
 				{
-					if (IsSameStringEnd(FileOut, ".dai")) // wav to dai
-					{
-						strcpy(DaiFileName, FileOut);
-						if (IsSameStringEnd(DaiFileName, "*.dai")) // Input file name will be used (without extension)
-						{
-							ChangeFileExt(".dai", FindData->cFileName, DaiFileName);
-						}
-						NErr = DgvWavIn(FindData->cFileName,1); // Read the program in memory  
-						if (NErr != 0) { NErr = DgvWavIn(FindData->cFileName, 0); } // Try with the alternative parity
-						if (NErr >= 0) // Write .dai file
-						{
-							InsertStringBefExt("_Dgv", DaiFileName, DaiFileName);
-							NErr = WriteDaiFile(DaiFileName);
-						}
-					}
-					else
-					if (IsSameStringEnd(FileOut, ".wav")) // wav to Wav
-					{			
-						strcpy(WavFileName, FileOut);
-						if (IsSameStringEnd(WavFileName, "*.wav")) // Input file name will be used (without extension)
-						{
-							ChangeFileExt(".wav", FindData->cFileName, WavFileName);
-						}
-						NErr = DgvWavIn(FindData->cFileName,1); // Read the program in memory  
-						if (NErr != 0) { NErr = DgvWavIn(FindData->cFileName, 0); } // Try with the alternative parity
-						if (NErr >= 0) // Write .wav file
-						{
-							#if(InsertWavOutOptions)
-								InsertStringBefExt(DaiHW_Profile[Glob_DaiHw].ProfileName, WavFileName, WavFileName); // Insert Type of HW
-								InsertStringBefExt(Options, WavFileName, WavFileName); // Insert User Options
-							#endif
-							NErr = DgvWavOut(WavFileName);
-						}
-					}
-					if (NErr < 0)
-					{
-						printf("Error %000d while processing file: %s", NErr, FindData->cFileName);
-					}
+					ChangeFileExt(WavValid_Ext, FileName, ReportName);
 				}
-				else
-				if ((IsSameStringEnd(FindData->cFileName, ".dai"))&&(IsSameStringEnd(FileOut, ".wav"))) // dai to Wav
+				NErr = DgvWavValid(FileName, ReportName);
+			}
+			else
+			if (Cmd->Calibrate) // wav added to inter calls delays calibration, checked with its .dai file if any
+			{
+				ChangeFileExt(".dai", FileName, DaiFileName);
+				NErr = DgvWavCalib(FileName, DaiFileName);
+			}
+			else
+			if (IsSameStringEnd(FileOut, ".dai")) // wav to dai
+			{
+				strcpy(DaiFileName, FileOut);
+				if (IsSameStringEnd(DaiFileName, "*.dai")) // Input file name will be used (without extension)
 				{
-					strcpy(DaiFileName, FindData->cFileName);
-					if (IsSameStringEnd(DaiFileName, "_Dgv.dai"))
-					{
-						DaiFileName[strlen(DaiFileName) - 8] = '\0';
-						strcat(DaiFileName, ".dai");
-					}
-					strcpy(WavFileName, FileOut);
-					if (IsSameStringEnd(WavFileName,"*.wav")) // Input file name will be used (without extension)
-					{
-						ChangeFileExt(".wav", DaiFileName, WavFileName);
-					}
-					NErr = ReadDaiFile(FindData->cFileName); // Read the program in memory  
-					if (NErr >= 0) // Write .wav file
-					{
-						#if(InsertWavOutOptions)
-							InsertStringBefExt(DaiHW_Profile[Glob_DaiHw].ProfileName, WavFileName, WavFileName); // Insert Type of HW
-							InsertStringBefExt(Options, WavFileName, WavFileName); // Insert User Options
-						#endif
-						NErr = DgvWavOut(WavFileName);
-					}
-					if (NErr < 0)
-					{
-						printf("Error %000d while processing file: %s", NErr, FindData->cFileName);
-					}
+					ChangeFileExt(".dai", FileName, DaiFileName);
 				}
-				else
+				InsertStringBefExt("_Dgv", DaiFileName, DaiFileName);
+				#if(DgvCache_Enabled)
+				NErr = DgvCache_FileKey(FileName, ".dai", &Key);
+				if ((NErr >= 0) && (DgvCache_Find(Key, DaiFileName))) { return (0); } // Capture already read
+				#endif
+				NErr = DgvWavIn(FileName,1); // Read the program in memory  
+				if (NErr != 0) { NErr = DgvWavIn(FileName, 0); } // Try with the alternative parity
+				if (NErr >= 0) // Write .dai file
 				{
-					NErr = -InvalidCmdInputErr; // dai to dai -> error for the time being
-					break;
+					NErr = WriteDaiFile(DaiFileName);
 				}
+				#if(DgvCache_Enabled)
+				DgvCache_Store(Key, DaiFileName, NErr);
+				#endif
 			}
+			else
+			if ((Cmd->CswOut) && (IsSameStringEnd(FileName, ".wav"))) // wav to csw, pulses seen by the firmware model
+			{
+				strcpy(WavFileName, FileOut);
+				if (IsSameStringEnd(WavFileName, Cmd->OutAll)) // Input file name will be used (without extension)
+				{
+					ChangeFileExt(WavCsw_Ext, FileName, WavFileName);
+				}
+				InsertStringBefExt("_Dgv", WavFileName, WavFileName);
+				NErr = WavCsw_FromWav(FileName, WavFileName);
+			}
+			else
+			if ((IsSameStringEnd(FileOut, ".wav")) && (IsSameStringEnd(FileName, WavCsw_Ext))) // csw to wav, same levels
+			{
+				strcpy(WavFileName, FileOut);
+				if (IsSameStringEnd(WavFileName, Cmd->OutAll)) // Input file name will be used (without extension)
+				{
+					ChangeFileExt(".wav", FileName, WavFileName);
+				}
+				InsertStringBefExt("_Dgv", WavFileName, WavFileName);
+				NErr = WavCsw_ToWav(FileName, WavFileName, &WavOut_Formats[0]);
+			}
+			else
+			if (Cmd->SignalOut) // wav to Wav, csw to csw
+			{			
+				strcpy(WavFileName, FileOut);
+				if (IsSameStringEnd(WavFileName, Cmd->OutAll)) // Input file name will be used (without extension)
+				{
+					ChangeFileExt(Cmd->OutExt, FileName, WavFileName);
+				}
+				NErr = DgvWavIn(FileName,1); // Read the program in memory  
+				if (NErr != 0) { NErr = DgvWavIn(FileName, 0); } // Try with the alternative parity
+				if (NErr >= 0) // Write .wav file
+				{
+					NErr = DgvWavOutFiles(WavFileName, Cmd->Options, Cmd->WavToStdout);
+				}
+			}
+			if (NErr < 0)
+			{
+				fprintf(stderr, "Error %000d while processing file: %s", NErr, FileName);
+			}
+		}
+		else
+		if ((IsSameStringEnd(FileName, ".dai"))&&(Cmd->Estimate)) // dai to load time estimate of all profiles
+		{
+			strcpy(ReportName, FileOut);
+			if (IsSameStringEnd(ReportName, "*" WavEst_Ext)) // Input file name will be used (without extension)
+			{
+				ChangeFileExt(WavEst_Ext, FileName, ReportName);
+			}
+			NErr = DgvWavEst(FileName, ReportName, Cmd->Options);
+			if (NErr < 0)
+			{
+				fprintf(stderr, "Error %d while processing file: %s", NErr, FileName);
+			}
+		}
+		else
+		if ((IsSameStringEnd(FileName, ".dai"))&&(Cmd->SignalOut)) // dai to Wav or csw
+		{
+			strcpy(DaiFileName, FileName);
+			if (IsSameStringEnd(DaiFileName, "_Dgv.dai"))
+			{
+				DaiFileName[strlen(DaiFileName) - 8] = '\0';
+				strcat(DaiFileName, ".dai");
+			}
+			strcpy(WavFileName, FileOut);
+			if (IsSameStringEnd(WavFileName, Cmd->OutAll)) // Input file name will be used (without extension)
+			{
+				ChangeFileExt(Cmd->OutExt, DaiFileName, WavFileName);
+			}
+			if (WavOut_Playlist) // Program is added to the playlist, written after all files
+			{
+				NErr = WavList_Add(FileName);
+			}
+			else
+			{
+				NErr = ReadDaiFile(FileName); // Read the program in memory  
+				if (NErr >= 0) // Write .wav file
+				{
+					NErr = DgvWavOutFiles(WavFileName, Cmd->Options, Cmd->WavToStdout);
+				}
+			}
+			if (NErr < 0)
+			{
+				fprintf(stderr, "Error %000d while processing file: %s", NErr, FileName);
+			}
+		}
+		else
+		{
+			*Stop = true;
+			return(-InvalidCmdInputErr); // dai to dai -> error for the time being
+		}
+		if ((Cmd->WavToStdout) && (!WavOut_Playlist)) { *Stop = true; } // Only one wav can be streamed
+	}
+	return(NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCommandProfiles 
+//-------------------------------------------------------------------------
+// Files FileSearchIn (.dai) to wav for each profile of DaiHwI_BitMask with Options ('Dgv' without names)
+int16_t DgvCommandProfiles(const char* FileSearchIn, char* Options)
+{
+	struct DgvBatchList_Struct List;
+	int16_t NErr;
 
-		} while (FindNextFileA(hFind, FindData) != 0);
+	NErr = DgvBatch_Find(FileSearchIn, DgvBatch_Recursive, &List);
+	if (NErr >= 0) { NErr = DgvProfilesList(&List, Options); }
+	DgvBatch_Free(&List);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvProfilesList 
+//-------------------------------------------------------------------------
+// Dai files of List to wav for each profile of DaiHwI_BitMask with Options
+// Each program is read once, then rendered for all profiles by the threads of DgvBatch_Jobs, which share its blocks
+// Commands which gather programs or share a file (playlist, grid, tuning, loaded profile) run profile after profile (see DgvCommandList)
+// Output : result of the last program for the last profile
+int16_t DgvProfilesList(const struct DgvBatchList_Struct* List, char* Options)
+{
+	struct DgvProfiles_Struct* Profiles;
+	struct DgvProgram_Struct* Program;
+	struct WavOutConfig_Struct* Config;
+	uint64_t* Sizes = NULL;
+	uint32_t ProgramI;
+	uint32_t JobI;
+	uint16_t DaiHwI;
+	uint16_t ConfigI;
+	uint8_t BkI;
+	bool Shared = true; // Profiles can be rendered concurrently
+	int16_t NErr = 0;
+
+	Profiles = (struct DgvProfiles_Struct*)calloc(1, sizeof(struct DgvProfiles_Struct));
+	if (Profiles == NULL) { return (-MemAllocErr); }
+	for (DaiHwI = 0; DaiHwI < DgvProfiles_Max; DaiHwI++)
+	{
+		if ((((uint16_t)1 << DaiHwI) & DaiHwI_BitMask) == 0) continue;
+		Config = &Profiles->Configs[Profiles->NConfigs++];
+		WavOut_Config(DaiHwI, Options, Config);
+		if ((Config->Playlist) || (Config->Grid) || (Config->TuneMargin != WavOut_TuneOff) || (Config->LoadTuned)) { Shared = false; }
+	}
+	if (!Shared)
+	{
+		for (ConfigI = 0; ConfigI < Profiles->NConfigs; ConfigI++)
+		{
+			WavOut_SetConfig(&Profiles->Configs[ConfigI]);
+			NErr = DgvCommandList(List, "*.wav", WavOut_NameOptions);
+		}
+		free(Profiles);
+		return (NErr);
 	}
 
-DgvComErr:
-	if (FindData != NULL) free(FindData);
-	return(NErr);
+	// Programs read once
+	Profiles->Programs = (struct DgvProgram_Struct*)calloc(List->Count + 1, sizeof(struct DgvProgram_Struct));
+	if (Profiles->Programs == NULL) { NErr = -MemAllocErr; goto ProfilesExit; }
+	for (ProgramI = 0; ProgramI < List->Count; ProgramI++)
+	{
+		if (!NotDgvFile(List->Files[ProgramI].Name)) continue;
+		Program = &Profiles->Programs[Profiles->NPrograms++];
+		Program->NErr = ReadDaiFile(List->Files[ProgramI].Name);
+		if (Program->NErr < 0)
+		{
+			fprintf(stderr, "Error %d while processing file: %s", Program->NErr, List->Files[ProgramI].Name);
+			continue;
+		}
+		memcpy(Program->Blocks, DaiBlocksInfo, sizeof(Program->Blocks));
+		Program->ProgType = Glob_ProgType;
+		for (BkI = 0; BkI < DataBlock_Count; BkI++) { DaiBlocksInfo[BkI].Block = NULL; } // Owned by the program
+		strcpy(Program->DaiFileName, List->Files[ProgramI].Name);
+		strcpy(Program->WavFileName, List->Files[ProgramI].Name);
+		if (IsSameStringEnd(Program->WavFileName, "_Dgv.dai"))
+		{
+			Program->WavFileName[strlen(Program->WavFileName) - 8] = '\0';
+			strcat(Program->WavFileName, ".dai");
+		}
+		ChangeFileExt(".wav", Program->WavFileName, Program->WavFileName);
+	}
+	if (Profiles->NPrograms == 0) { goto ProfilesExit; }
+
+	// One job per profile and program, profile after profile as in the commands of each profile
+	Sizes = (uint64_t*)malloc((size_t)Profiles->NConfigs * Profiles->NPrograms * sizeof(uint64_t));
+	if (Sizes == NULL) { NErr = -MemAllocErr; goto ProfilesExit; }
+	for (JobI = 0; JobI < (uint32_t)Profiles->NConfigs * Profiles->NPrograms; JobI++)
+	{
+		Program = &Profiles->Programs[JobI % Profiles->NPrograms];
+		Sizes[JobI] = (uint64_t)Program->Blocks[0].Len + Program->Blocks[1].Len + Program->Blocks[2].Len;
+	}
+	NErr = DgvBatch_Jobs((uint32_t)Profiles->NConfigs * Profiles->NPrograms, Sizes, DgvCommandProfile, Profiles);
+
+ProfilesExit:
+	for (ProgramI = 0; ProgramI < Profiles->NPrograms; ProgramI++)
+	{
+		for (BkI = 0; BkI < DataBlock_Count; BkI++) { free(Profiles->Programs[ProgramI].Blocks[BkI].Block); }
+	}
+	free(Profiles->Programs);
+	free(Profiles);
+	free(Sizes);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCommandProfile 
+//-------------------------------------------------------------------------
+// Wav files of one program for one profile, on a thread of DgvBatch_Jobs
+int16_t DgvCommandProfile(const void* Context, uint32_t JobI)
+{
+	const struct DgvProfiles_Struct* Profiles = (const struct DgvProfiles_Struct*)Context;
+	const struct DgvProgram_Struct* Program = &Profiles->Programs[JobI % Profiles->NPrograms];
+	uint8_t BkI;
+	int16_t NErr;
+
+	if (Program->NErr < 0) { return (Program->NErr); }
+	WavOut_SetConfig(&Profiles->Configs[JobI / Profiles->NPrograms]);
+	memcpy(DaiBlocksInfo, Program->Blocks, sizeof(DaiBlocksInfo)); // Blocks are only read while rendering
+	Glob_ProgType = Program->ProgType;
+	NErr = DgvWavOutFiles(Program->WavFileName, WavOut_NameOptions, false);
+	if (NErr < 0)
+	{
+		fprintf(stderr, "Error %d while processing file: %s", NErr, Program->DaiFileName);
+	}
+	for (BkI = 0; BkI < DataBlock_Count; BkI++) { DaiBlocksInfo[BkI].Block = NULL; }
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCommandWatch 
+//-------------------------------------------------------------------------
+// Process files FileSearchIn to FileOut as DgvCommand, then each time they are written, until the process is stopped (see DgvBatch_Watch)
+// FileOut = NULL : wav to dai, and dai to wav for each profile with OptionsArg, as 'Dgv' without names (dai written are converted too)
+// Process stays loaded, the encoder configuration is the one of the command
+// Output : negative error
+int16_t DgvCommandWatch(const char* FileSearchIn, const char* FileOut, char* OptionsArg)
+{
+	struct DgvWatch_Struct Watch;
+
+	if ((FileOut != NULL) && ((strlen(FileSearchIn) < 4) || ((!IsSameStringEnd(FileSearchIn, ".wav")) &&
+		(!IsSameStringEnd(FileSearchIn, ".dai")) && (!IsSameStringEnd(FileSearchIn, WavCsw_Ext)))))
+	{
+		return(-InvalidCmdInputErr);
+	}
+	Watch.FileOut = FileOut;
+	Watch.OptionsArg = OptionsArg;
+	WavOut_GetConfig(&Watch.Config);
+	return (DgvBatch_Watch(FileSearchIn, DgvBatch_Recursive, DgvCommandWatched, &Watch));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvCommandWatched 
+//-------------------------------------------------------------------------
+// Files written, processed by the command of DgvCommandWatch
+int16_t DgvCommandWatched(const void* Context, const struct DgvBatchList_Struct* Files)
+{
+	const struct DgvWatch_Struct* Watch = (const struct DgvWatch_Struct*)Context;
+	struct DgvBatchList_Struct Captures;
+	struct DgvBatchList_Struct Programs;
+	uint32_t FileI;
+	int16_t NErr = 0;
+
+	WavOut_SetConfig(&Watch->Config); // Profiles may have changed it
+	if (Watch->FileOut != NULL) { return (DgvCommandList(Files, Watch->FileOut, WavOut_NameOptions)); }
+
+	Captures.Files = (struct DgvBatchFile_Struct*)malloc((Files->Count + 1) * sizeof(struct DgvBatchFile_Struct));
+	Programs.Files = (struct DgvBatchFile_Struct*)malloc((Files->Count + 1) * sizeof(struct DgvBatchFile_Struct));
+	Captures.Count = Programs.Count = 0;
+	Captures.Max = Programs.Max = Files->Count + 1;
+	if ((Captures.Files == NULL) || (Programs.Files == NULL)) { NErr = -MemAllocErr; goto WatchedExit; }
+	for (FileI = 0; FileI < Files->Count; FileI++)
+	{
+		if (IsSameStringEnd(Files->Files[FileI].Name, ".wav")) { Captures.Files[Captures.Count++] = Files->Files[FileI]; }
+		if (IsSameStringEnd(Files->Files[FileI].Name, ".dai")) { Programs.Files[Programs.Count++] = Files->Files[FileI]; }
+	}
+	if (Captures.Count > 0) { NErr = DgvCommandList(&Captures, "*.dai", WavOut_NameOptions); }
+	if (Programs.Count > 0) { NErr = DgvProfilesList(&Programs, Watch->OptionsArg); }
+
+WatchedExit:
+	DgvBatch_Free(&Captures);
+	DgvBatch_Free(&Programs);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvWavOutFiles 
+//-------------------------------------------------------------------------
+// Write the program in memory in one wav file per wav format (see WavOut_Formats), from a single timing pass
+// Type of HW and format options are inserted in file names (Options for main format), not when streaming to standard output
+// Only main format is streamed to standard output
+int16_t DgvWavOutFiles(const char* WavFileName, const char* Options, bool WavToStdout)
+{
+	struct WavRaster_Struct Rasters[WavOut_FormatsMax];
+	char FormatOptions[OptionsLenMax + 2];
+	uint8_t FormatI;
+	uint8_t RasterI;
+	uint8_t NRasters = 0;
+
+	for (FormatI = 0; FormatI < WavOut_FormatsCount; FormatI++)
+	{
+		Rasters[NRasters].Format = WavOut_Formats[FormatI];
+		strcpy(Rasters[NRasters].FileName, WavFileName);
+		#if(InsertWavOutOptions)
+		if (!WavToStdout)
+		{
+			if (FormatI == 0) { strcpy(FormatOptions, Options); }
+			else { WavFormat_NameOptions(FormatOptions, &WavOut_Formats[FormatI]); }
+			InsertStringBefExt(WavOut_Profile->ProfileName, Rasters[NRasters].FileName, Rasters[NRasters].FileName); // Insert Type of HW
+			InsertStringBefExt(FormatOptions, Rasters[NRasters].FileName, Rasters[NRasters].FileName); // Insert User Options
+		}
+		#endif
+		for (RasterI = 0; RasterI < NRasters; RasterI++) // Same format given twice
+		{
+			if (strcmp(Rasters[RasterI].FileName, Rasters[NRasters].FileName) == 0) break;
+		}
+		if (RasterI == NRasters) { NRasters++; }
+		if (WavToStdout) break;
+	}
+	if (WavOut_Playlist) { return (DgvWavList(Rasters, NRasters)); }
+	if ((WavOut_Grid) && (!WavToStdout)) { return (DgvWavGrid(Rasters, NRasters)); }
+	#if(DgvCache_Enabled)
+	if ((!WavToStdout) && (WavOut_TuneMargin == WavOut_TuneOff)) { return (DgvWavOutCached(Rasters, NRasters)); } // Tuning also writes WavTune_FileName
+	#endif
+	return (DgvWavOutRasters(Rasters, NRasters));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvWavOutCached 
+//-------------------------------------------------------------------------
+// Write the rasters of the program in memory which are not up to date, or linked from an identical output (see DgvCache)
+// Output : 0 or first negative error of rasters
+int16_t DgvWavOutCached(struct WavRaster_Struct* Rasters, uint8_t NRasters)
+{
+	struct WavRaster_Struct Missing[WavOut_FormatsMax];
+	uint64_t Keys[WavOut_FormatsMax];
+	uint8_t MissingIs[WavOut_FormatsMax];
+	bool Pending[WavOut_FormatsMax]; // Key to be stored
+	uint8_t NMissing = 0;
+	uint8_t RasterI;
+	uint8_t I;
+	int16_t NErr = 0;
+
+	for (RasterI = 0; RasterI < NRasters; RasterI++)
+	{
+		Keys[RasterI] = DgvCache_RasterKey(&Rasters[RasterI].Format, Rasters[RasterI].FileName);
+		for (I = 0; (I < RasterI) && (Keys[I] != Keys[RasterI]); I++) {}
+		Pending[RasterI] = (I == RasterI); // Output given twice under two names is written twice
+		if ((Pending[RasterI]) && (DgvCache_Find(Keys[RasterI], Rasters[RasterI].FileName)))
+		{
+			Pending[RasterI] = false;
+			Rasters[RasterI].NErr = 0;
+			continue;
+		}
+		MissingIs[NMissing] = RasterI;
+		Missing[NMissing++] = Rasters[RasterI];
+	}
+	if (NMissing != 0)
+	{
+		NErr = DgvWavOutRasters(Missing, NMissing);
+		for (I = 0; I < NMissing; I++)
+		{
+			RasterI = MissingIs[I];
+			Rasters[RasterI] = Missing[I];
+			if (Pending[RasterI]) { DgvCache_Store(Keys[RasterI], Rasters[RasterI].FileName, (NErr < 0 ? NErr : Rasters[RasterI].NErr)); }
+		}
+	}
+	return (NErr);
 }
 
 
@@ -292,7 +775,7 @@ void PrintHelp(int16_t NErr)
 		printf("\n");
 		printf("===================================================================================================\n");
 		printf("Dgv generates dai files (from wav files) or optimized wav files (from dai or wav files) \n");
-		printf("'Dgv InputName.xxx OutputName.yyy --Options', Src and Dest can be equal to '*', xxx/yyy = dai or wav\n");
+		printf("'Dgv InputName.xxx OutputName.yyy --Options', Src and Dest can be equal to '*', xxx/yyy = dai, wav or csw\n");
 		printf("'--Options', optional argument for optimized wav output files formed with '--' followed by several parameters:\n");
 		printf("    - Vx: x=optimized wav (except V0) profile version corresponding to an hardware evironment (Dai + audio player)\n");
 		printf("         V0=DaiK7_24KHz, V1=DaiV4_48KHz, for V4 with V0 being similar to a Dai ouput\n");
@@ -300,12 +783,43 @@ void PrintHelp(int16_t NErr)
 		printf("         V5=DAIV7T_192KHz, V6=DAIV7U_384KHz, for modified Dai V7 (LM324 replace by TLC274)\n");
 		printf("         V7=MameA_96KHz for Mame emulator\n");
 		printf("         Speed gain vs V0: 1=3.7x, 2=3.7x, 3=4.3x, 4=4.8x, 5=6.3x, 6=7.7x, 7=9.4x, \n");
+		printf("    - L=Shortest leader read by the Dai firmware model from any entry phase (+%d DaiBits margin), instead of profile one\n", WavOut_MinLeaderMargin);
+		printf("    - R=Interrupt slack (%d Cpu cycles) on first leader DaiBits read with interrupts enabled, with L the leader also syncs with RST 6/7\n", WavOut_IntSlackDelay);
+		printf("    - Q=Fast DaiBits at every position (name, lengths and checksums), used for a program if read back by the firmware model\n");
+		printf("    - Tx=Profile tuned for each program with the firmware model, read back with periods shifted by +/-x Cpu cycles (default %d)\n", WavTune_MarginDefault);
+		printf("         Fastest profile found is written in %s, as a DaiHW_Profile[] initializer\n", WavTune_FileName);
+		printf("    - U=Profile loaded from %s (name of Vx profile is used), before Tx\n", WavTune_FileName);
+		printf("    - D=Inter calls delays loaded from %s (see 'Dgv *.wav *.cal')\n", WavCalib_FileName);
+		printf("    - J=Playlist, all .dai files joined in one wav (%s for '*.wav') with a .cue sheet of program start times\n", WavList_DefaultName);
+		printf("         Programs after the first one have the shortest leader read by the firmware model after the previous trailer\n");
+		printf("    - K=Turbo loader for binary programs: a %d bytes loader read by the firmware, then after a %d ms pilot (to start the loader)\n", (int)WavTurbo_LoaderSize, WavTurbo_Pilot_ms);
+		printf("         the program in a denser encoding, read back by an emulation of the loader. Other programs are written normally\n");
+		printf("    - G=One wav per margin variant, grid {Min,Max,Step} of P0,P1,P2,P3 offsets, InBk and OutBk margins read from %s\n", WavGrid_FileName);
+		printf("         (default: P offsets 0, margins 0 to 40 by 20), up to %d variants rendered concurrently, ex: _G0.0.0.0_20_40\n", WavGrid_VariantsMax);
 		printf("    - B=1 Bytes, W=2 Bytes, M=Mono, S=Stereo, N=Non inverted wav signal, I=Inverted wav signal output (useless for Mame)\n");
 		printf("    - Fx= with x the sampling frequency in Hz (5-7 chars, example: x=96000 for Mame)\n");
+		printf("    - A=Automatic sampling frequency, lowest standard one (from 22050Hz) keeping timing of F within %d Cpu cycles\n", WavOut_AutoRateMaxError);
+		printf("    - Ex=Edge shaping after each transition, for a physical DAI: 0=None, 1=Soft first sample, 2=Band limited (%.0fus raised cosine),\n", WavOut_EdgeRise_us);
+		printf("         3=Pre-emphasis (+%d%% of the step, decaying in %.0fus). Fast DaiBits are read back with the shaped samples\n", WavOut_EdgeBoost, WavOut_EdgeDecay_us);
+		printf("    - +xxx: additional wav file with format options xxx (M,S,B,W,N,I,A,E,F), up to 3, ex: --V4MW+F96000+SBF44100\n");
 		printf("'Dgv ?' For help. Dgv v0.1.0\n\n");
 		printf("- Ex. in Windows terminal: 'Dgv Pacman.wav *.dai', 'Dgv Pacman.dai Pac.wav', 'Dgv *.wav *.wav --V9MBN'\n");
 		printf("- Ex. in Windows terminal: 'Dgv *.wav *.wav --V3SWIF192000'\n");
 		printf("- Ex. double click on Dgv.exe in windows will process all files in directory (bin and wav)\n");
+		printf("- Ex. 'Dgv Pacman.dai - --V7 | player', output name '-' streams the wav to standard output\n");
+		printf("- Ex. 'Dgv *.wav *.val', validates wav files (Dgv ones included) with the firmware model from every Cpu phase within a sample,\n");
+		printf("         then %d times with random interrupts, noise (+/-%d) and speed error (+/-%dppm). Report is appended to .val files\n", WavValid_RandomTrials, WavValid_Noise, WavValid_SpeedPpm);
+		printf("- Ex. 'Dgv *.wav *.csw', 'Dgv *.csw *.wav', converts captures to / from compressed square wave files, read as the wav ones\n");
+		printf("         by the firmware model (converted files end with _Dgv), 'Dgv *.dai *.csw --V7' writes the pulses of the optimized wav\n");
+		printf("- Ex. 'Dgv *.dai *.est --LF48000', estimates samples, size and load time of the wav of each profile with the options without writing it,\n");
+		printf("         appended to .est files (options of each estimate are printed, %s are ignored)\n", WavEst_NotEstimated);
+		printf("- Ex. 'Dgv *.wav *.cal', learns inter calls delays from reference captures (Mame or Dai), checked with their .dai file if any\n");
+		printf("         Delays are written in %s ('*.cal') or in the given file, and used by D option\n", WavCalib_FileName);
+		printf("- Ex. 'Dgv -r -j 4 Games/*.dai *.wav --V7', %s N converts N files at a time (default one per core, 1 for one after the other),\n", DgvBatch_ThreadsOption);
+		printf("         largest first, %s includes subdirectories. Playlist, grid, tuning and stdout commands convert one file at a time\n", DgvBatch_RecursiveOption);
+		printf("- Outputs already written from the same capture or program, profile and options are kept (or linked if written under another\n");
+		printf("         name), they are recorded in %s. '%s' converts all files again\n", DgvCache_FileName, DgvCache_ForceOption);
+		printf("- Ex. 'Dgv %s -r', 'Dgv %s *.wav *.dai', converts the files, then each file written (closed or moved in), until stopped\n", DgvBatch_WatchOption, DgvBatch_WatchOption);
 		printf("Dgv v0.2.0, 12/10/2024\n");
 		printf("===================================================================================================\n");
 	}
@@ -329,7 +843,7 @@ bool NotDgvFile(char* FileName)
 		ExtLen = (uint16_t)strlen(DaiHW_Profile[i].ProfileName);
 		if ((ExtLen + 4) < FileNameLen)
 		{
-			if ((strstr(FileName, DaiHW_Profile[i].ProfileName) != NULL) && (StrCmpUp(FileName + FileNameLen - 4, ".wav") == 0))
+			if ((strstr(FileName, DaiHW_Profile[i].ProfileName) != NULL) && ((StrCmpUp(FileName + FileNameLen - 4, ".wav") == 0) || (StrCmpUp(FileName + FileNameLen - 4, WavCsw_Ext) == 0)))
 				return (false);
 		}
 	}
@@ -337,31 +851,6 @@ bool NotDgvFile(char* FileName)
 }
 
 
-//-------------------------------------------------------------------------
-// DgvOutVersions 
-//-------------------------------------------------------------------------
-// Not used normally
-// For testing / debugging different output parameters using an already downloaded file
-// Input : file with full name "FileIn", I.e. with extension .dai or .wav
-//
-void DgvOutVersions(char * FileIn)
-{
-	int16_t VersionI;
-	int16_t NErr;
-	char FileOut[MaxLenString+1];
-	char VersionString [6] ; // 5, +2 for end of string & _
-	#define VerFileMax 1 // 1= no version. Used to create different versions of a file (for example with different margins)
-	for (VersionI = 1; VersionI < VerFileMax; VersionI++) 
-	{
-			ChangeFileExt((char*)".wav", FileIn, FileOut);
-			sprintf(VersionString, "_%000d", VersionI);
-			InsertStringBefExt(VersionString, FileIn, FileOut);
-			SetVersion(VersionI);
-			NErr = DgvWavOut(FileOut);
-	}
-}
-
-
 //-------------------------------------------------------------------------
 // StrCmpUp 
 //-------------------------------------------------------------------------
@@ -396,26 +885,6 @@ int16_t StrCmpUp(const char* S1, const char* S2)
 }
 
 
-//-------------------------------------------------------------------------
-// SetVersion 
-//-------------------------------------------------------------------------
-// Adjust parameters according to version
-void SetVersion(int16_t Ver)
-{
-	uint16_t i;
-	int16_t del = 0;
-
-	for (i = 0; i < 7; i++)
-	{
-		OutBkInterCallsDelaysMargin[i] = 0; // 40, 7 values
-	}
-	PeriodsOffset_Delay[0] = ((Ver & 1) != 0 ? del : 0);
-	PeriodsOffset_Delay[1] = ((Ver & 2) != 0 ? del : 0);
-	PeriodsOffset_Delay[2] = ((Ver & 4) != 0 ? del : 0);
-	PeriodsOffset_Delay[3] = ((Ver & 8) != 0 ? del : 0);
-}
-
-
 //-------------------------------------------------------------------------
 // InsertStringBefExt 
 //-------------------------------------------------------------------------
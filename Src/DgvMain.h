@@ -67,17 +67,23 @@
 //-------------------------------------------------------------------------
 // Global variables 
 //-------------------------------------------------------------------------
-extern int8_t Glob_PosInFile;
-extern int8_t Glob_PosInBlock;
-extern int8_t Glob_BlockI;
-extern uint16_t Glob_InterK7ReadDelay; // Delay in CpuCycles between return and call of Read Bit function, including Enter & Exit delays
-extern uint16_t Glob_DaiHw;
+extern thread_local int8_t Glob_PosInFile;
+extern thread_local int8_t Glob_PosInBlock;
+extern thread_local int8_t Glob_BlockI;
+extern thread_local uint16_t Glob_InterK7ReadDelay; // Delay in CpuCycles between return and call of Read Bit function, including Enter & Exit delays
+extern thread_local uint16_t Glob_DaiHw;
+extern thread_local uint16_t Glob_InBkInterCallsDelays[DataBlock_Count][PosInBlock_Count]; // See WavOutConfig_Struct
+extern thread_local uint16_t Glob_OutBkInterCallsDelays[ProgType_Count][PosInFile_Count];
 
 //-------------------------------------------------------------------------
 // Global functions 
 //-------------------------------------------------------------------------
 void SetWavOutParameters(uint16_t Hw);
+void SetWavOutProfile(const struct DaiHardware_Struct* Profile);
 bool NotDgvFile(char* FileName);
+void InsertStringBefExt(const char* InsertS, const char* FileNameIn, char* FileNameOut);
+void ChangeFileExt(const char* NewExt, const char* FileNameIn, char* FileNameOut);
+bool IsSameStringEnd(const char* StringIn, const char* StringEnd);
 uint16_t SwapBytes(uint16_t Word);
 uint8_t DaiByteCheckSum(uint8_t Data, uint8_t ChkSum);
 uint8_t DaiWordCheckSum(uint16_t Word);
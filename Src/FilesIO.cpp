@@ -28,6 +28,13 @@
 #include <stdlib.h>
 #include <string.h> 
 #include <stdint.h> 
+#ifdef _WIN32
+	#include <windows.h> // for CreateFileMappingA
+	#include <io.h> // for _chsize_s
+#else
+	#include <fcntl.h> // for posix_fallocate
+	#include <sys/mman.h> // for mmap
+#endif
 #include "DgvMain.h"
 #include "FilesIO.h"
 #include "WavOut.h"
@@ -37,14 +44,16 @@
 //-------------------------------------------------------------------------
 // Global variables
 //-------------------------------------------------------------------------
-DaiBlock_Struct DaiBlocksInfo[3];
-uint8_t Glob_ProgType;
+thread_local DaiBlock_Struct DaiBlocksInfo[3];
+thread_local uint8_t Glob_ProgType;
 
 //-------------------------------------------------------------------------
 // Local variables
 //-------------------------------------------------------------------------
 // Reading / Writing wav structures
 
+#define NumbersFileLenMax 0x1000 // Text files read by ReadNumbersFile
+
 
 
 
@@ -76,12 +85,14 @@ int16_t Car3Num(char* TNum);
 // ChunkSize=Format:4b+fmt chunk:24b+SubChunk2ID:4b+SubChunk2Size:4b+SubChunk2:<SubChunk2Size>=36 + <SubChunk2Size>
 int16_t CreateWavOut(FILE* WaveFile, uint32_t NSamples, uint32_t SRate, uint8_t NChannels, uint8_t Bytes_per_sample)
 {
+	struct WavHeader_Struct WavOutHeader; // Local, several wav files can be created at the same time
+	struct WavSubchunk_Struct WavOutSubChunk;
 
 	if ((WaveFile == NULL) || (SRate <= 2400)) return (-1);
 
 	// Create header
 	memcpy(&WavOutHeader.ChunkId, "RIFF", 4);
-	WavOutHeader.ChunkSize = 36 + (Bytes_per_sample * NSamples); // NSamples = NSamplesPerChannel * WavOut_NChannels
+	WavOutHeader.ChunkSize = 36 + (Bytes_per_sample * NSamples); // NSamples = NSamplesPerChannel * NChannels
 	memcpy(&WavOutHeader.Format, "WAVE", 4);
 	memcpy(&WavOutHeader.Subchunk1Id, "fmt ", 4);
 	WavOutHeader.Subchunk1Size = 16;
@@ -92,41 +103,78 @@ int16_t CreateWavOut(FILE* WaveFile, uint32_t NSamples, uint32_t SRate, uint8_t
 	WavOutHeader.BlockAlign = Bytes_per_sample * NChannels;
 	WavOutHeader.BitsPerSample = Bytes_per_sample * 8;
 
-	memcpy(&WavOutSubChunks[0].SubchunkId, "data", 4);
-	WavOutSubChunks[0].SubchunkSize = Bytes_per_sample * NSamples;
+	memcpy(&WavOutSubChunk.SubchunkId, "data", 4);
+	WavOutSubChunk.SubchunkSize = Bytes_per_sample * NSamples;
 
 	if (fwrite(&WavOutHeader, sizeof(WavOutHeader), 1, WaveFile) < 1) { return (-WavWriteErr); } // Can't write file header
-	
-	if (fwrite(&WavOutSubChunks[0], sizeof(WavOutSubChunks[0]), 1, WaveFile) < 1) // Can't write input file header
-	{
-		fclose(WaveFile);
-		return (-WavWriteErr);
-	}
+	if (fwrite(&WavOutSubChunk, sizeof(WavOutSubChunk), 1, WaveFile) < 1) { return (-WavWriteErr); } // Can't write data chunk header, file is closed by caller
 
 	return (0);
 }
 
 
 //-------------------------------------------------------------------------
-// UdpdateWavSize 
+// PreallocateWavOut 
 //-------------------------------------------------------------------------
-// Update sample count of an already opened wave file
-int16_t UdpdateWavSize(FILE* WaveFile, uint32_t NSamples, uint8_t Bytes_per_sample)
+// Reserve disk space for the samples of a wav file which header has just been written
+// Output : 0, or negative if space could not be reserved (file remains valid)
+int16_t PreallocateWavOut(FILE* WaveFile, uint32_t NSamples, uint8_t Bytes_per_sample)
 {
-	uint32_t Size;
-	uint16_t Position;
-	Position = 4 ;
-	Size = 36 + (Bytes_per_sample * NSamples);
+	int64_t Size;
+	Size = (int64_t)sizeof(WavHeader_Struct) + sizeof(WavSubchunk_Struct) + (int64_t)Bytes_per_sample * NSamples;
+
+	if (fflush(WaveFile) != 0) { return (-WavWriteErr); }
+#ifdef _WIN32
+	if (_chsize_s(_fileno(WaveFile), Size) != 0) { return (-WavWriteErr); }
+#else
+	if (posix_fallocate(fileno(WaveFile), 0, (off_t)Size) != 0) { return (-WavWriteErr); }
+#endif
+	return (0);
+}
 
-	if ((fseek(WaveFile, Position, SEEK_SET)!=0)||(fwrite(&Size, sizeof(Size), 1, WaveFile) < 1)) { return (-WavWriteErr); }
 
-	Size = Bytes_per_sample * NSamples;
-	Position = (uint16_t) (sizeof(WavHeader_Struct) + sizeof(WavSubchunk_Struct) - 4);
+//-------------------------------------------------------------------------
+// MapWavOut 
+//-------------------------------------------------------------------------
+// Map in memory a wav file which header has been written and size preallocated (see PreallocateWavOut)
+// File must be opened for reading and writing. Len = header and samples length
+// Output : start of the file in memory, or NULL if mapping is not possible (file remains valid)
+uint8_t* MapWavOut(FILE* WaveFile, uint32_t Len, void** MapHandle)
+{
+	uint8_t* Data;
+
+	*MapHandle = NULL;
+	if (fflush(WaveFile) != 0) { return (NULL); }
+#ifdef _WIN32
+	HANDLE Mapping;
+	Mapping = CreateFileMappingA((HANDLE)_get_osfhandle(_fileno(WaveFile)), NULL, PAGE_READWRITE, 0, 0, NULL);
+	if (Mapping == NULL) { return (NULL); }
+	Data = (uint8_t*)MapViewOfFile(Mapping, FILE_MAP_WRITE, 0, 0, Len);
+	if (Data == NULL) { CloseHandle(Mapping); return (NULL); }
+	*MapHandle = Mapping;
+#else
+	Data = (uint8_t*)mmap(NULL, Len, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(WaveFile), 0);
+	if (Data == MAP_FAILED) { return (NULL); }
+#endif
+	return (Data);
+}
 
-	fseek(WaveFile, Position, SEEK_SET);
-	if ((fseek(WaveFile, Position, SEEK_SET) != 0) || (fwrite(&Size, sizeof(Size), 1, WaveFile) < 1)) { return (-WavWriteErr); }
 
-	return (0);
+//-------------------------------------------------------------------------
+// UnmapWavOut 
+//-------------------------------------------------------------------------
+// Write back and release a wav file mapped by MapWavOut
+int16_t UnmapWavOut(uint8_t* Data, uint32_t Len, void* MapHandle)
+{
+	int16_t NErr = 0;
+#ifdef _WIN32
+	if (!UnmapViewOfFile(Data)) { NErr = -WavWriteErr; }
+	CloseHandle((HANDLE)MapHandle);
+#else
+	(void)MapHandle; // No mapping handle outside Windows
+	if (munmap(Data, Len) != 0) { NErr = -WavWriteErr; }
+#endif
+	return (NErr);
 }
 
 //=========================================================================
@@ -520,4 +568,41 @@ int16_t ValidFileTime(uint16_t* FileTime)
 void ClearDaiBinInfos(void)
 {
 	memset((char*)DaiBlocksInfo,0,3*sizeof(DaiBlock_Struct));
-}
\ No newline at end of file
+}
+
+
+//-------------------------------------------------------------------------
+// ReadNumbersFile
+//-------------------------------------------------------------------------
+// Read the signed integers of a text file in order, such as a C initializer written by Dgv
+// Comments ('//' up to end of line) and strings are skipped
+// Output : count of numbers read in Values (up to MaxValues), negative error if file can't be read
+int16_t ReadNumbersFile(const char* FileName, long* Values, uint16_t MaxValues)
+{
+	char Text[NumbersFileLenMax + 1];
+	char* Pos;
+	char* End;
+	size_t Len;
+	uint16_t NValues = 0;
+	FILE* File;
+
+	File = fopen(FileName, "rb");
+	if (File == NULL) return (-FileParamErr);
+	Len = fread(Text, 1, NumbersFileLenMax, File);
+	fclose(File);
+	Text[Len] = '\0';
+
+	Pos = Text;
+	while ((*Pos != '\0') && (NValues < MaxValues))
+	{
+		if ((Pos[0] == '/') && (Pos[1] == '/')) { while ((*Pos != '\0') && (*Pos != '\n')) { Pos++; } }
+		else if (*Pos == '"') { Pos++; while ((*Pos != '\0') && (*Pos != '"')) { Pos++; } if (*Pos != '\0') { Pos++; } }
+		else if (((*Pos >= '0') && (*Pos <= '9')) || ((*Pos == '-') && (Pos[1] >= '0') && (Pos[1] <= '9')))
+		{
+			Values[NValues++] = strtol(Pos, &End, 10);
+			Pos = End;
+		}
+		else { Pos++; }
+	}
+	return ((int16_t)NValues);
+}
@@ -40,8 +40,8 @@ struct DaiBlock_Struct
 // Global variables 
 //-------------------------------------------------------------------------
 
-extern DaiBlock_Struct DaiBlocksInfo[3];
-extern uint8_t Glob_ProgType;
+extern thread_local DaiBlock_Struct DaiBlocksInfo[3];
+extern thread_local uint8_t Glob_ProgType;
 
 
 //-------------------------------------------------------------------------
@@ -49,7 +49,9 @@ extern uint8_t Glob_ProgType;
 //-------------------------------------------------------------------------
 // Writing wav functions
 int16_t CreateWavOut(FILE* WaveFile, uint32_t NSamples, uint32_t SRate, uint8_t NChannels, uint8_t Bytes_per_sample);
-int16_t UdpdateWavSize(FILE* WaveFile, uint32_t NSamples, uint8_t Bytes_per_sample);
+int16_t PreallocateWavOut(FILE* WaveFile, uint32_t NSamples, uint8_t Bytes_per_sample);
+uint8_t* MapWavOut(FILE* WaveFile, uint32_t Len, void** MapHandle);
+int16_t UnmapWavOut(uint8_t* Data, uint32_t Len, void* MapHandle);
 
 // Reading Bin functions
 int16_t ReadDaiFile(char* DaiFileName);
@@ -62,4 +64,5 @@ int16_t ReadHeaderSubChunk(FILE* WFile, Wav_Struct* CurrentWav);
 
 // Tools
 void ClearDaiBinInfos(void);
+int16_t ReadNumbersFile(const char* FileName, long* Values, uint16_t MaxValues);
 #endif
\ No newline at end of file
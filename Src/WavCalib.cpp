@@ -0,0 +1,310 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavCalib.cpp
+***********************************************************************************/
+// Learn InBkInterCallsDelays and OutBkInterCallsDelays from reference captures (see WavCalib.h)
+// Captures are read one by one in the main thread, learned delays are the mean over all valid captures
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavIn.h"
+#include "WavCalib.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavCalib_ValuesCount (DataBlock_Count * PosInBlock_Count + ProgType_Count * PosInFile_Count)
+
+struct WavCalib_Struct // Per key, sum of learned delays without InterDaitBits_Delay, and count of bytes
+{
+	double Sum[WavCalib_KeysCount];
+	uint32_t Count[WavCalib_KeysCount];
+};
+
+
+//-------------------------------------------------------------------------
+// Local variables
+//-------------------------------------------------------------------------
+// Set by main thread only
+struct WavCalib_Struct WavCalib_All; // Valid captures
+struct WavCalib_Struct WavCalib_Capture; // Capture being read
+uint16_t WavCalib_NCaptures;
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+int16_t WavCalib_Read(char* WavFileName);
+bool WavCalib_SameAsDai(char* DaiFileName);
+int32_t WavCalib_Delay(int16_t Key, uint16_t Current);
+void WavCalib_FreeBlocks(void);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// DgvWavCalib 
+//-------------------------------------------------------------------------
+// Add a reference capture to the calibration, if it is read without error and is the same as DaiFileName (when it exists)
+// Output : 0 or negative error (not added)
+int16_t DgvWavCalib(char* WavFileName, char* DaiFileName)
+{
+	uint16_t Key;
+	int16_t NErr;
+
+	NErr = WavCalib_Read(WavFileName);
+	if (NErr < 0)
+	{
+		printf("%s: not read by the firmware model (error %d), not used\n", WavFileName, NErr);
+		return (NErr);
+	}
+	if (!WavCalib_SameAsDai(DaiFileName))
+	{
+		printf("%s: different from %s, not used\n", WavFileName, DaiFileName);
+		return (-InvalidDaiDataErr);
+	}
+
+	for (Key = 0; Key < WavCalib_KeysCount; Key++)
+	{
+		WavCalib_All.Sum[Key] += WavCalib_Capture.Sum[Key];
+		WavCalib_All.Count[Key] += WavCalib_Capture.Count[Key];
+	}
+	WavCalib_NCaptures++;
+	printf("%s: added to calibration\n", WavFileName);
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCalib_Read 
+//-------------------------------------------------------------------------
+// Read the capture in memory as DgvWavIn (both parities) without inter calls delays, P0 delays in WavCalib_Capture
+// Output : 0 or negative error
+int16_t WavCalib_Read(char* WavFileName)
+{
+	uint16_t InBkDelays[DataBlock_Count][PosInBlock_Count];
+	uint16_t OutBkDelays[ProgType_Count][PosInFile_Count];
+	uint8_t Parity;
+	int16_t NErr = 0;
+
+	memcpy(InBkDelays, Glob_InBkInterCallsDelays, sizeof(InBkDelays));
+	memcpy(OutBkDelays, Glob_OutBkInterCallsDelays, sizeof(OutBkDelays));
+	memset(Glob_InBkInterCallsDelays, 0, sizeof(Glob_InBkInterCallsDelays));
+	memset(Glob_OutBkInterCallsDelays, 0, sizeof(Glob_OutBkInterCallsDelays));
+	WavIn_Calib = true;
+	for (Parity = 2; Parity > 0; Parity--) // Parity 1, then 0
+	{
+		memset(&WavCalib_Capture, 0, sizeof(WavCalib_Capture));
+		NErr = DgvWavIn(WavFileName, (Parity == 2));
+		if (NErr == 0) break;
+		WavCalib_FreeBlocks();
+	}
+	WavIn_Calib = false;
+	memcpy(Glob_InBkInterCallsDelays, InBkDelays, sizeof(InBkDelays));
+	memcpy(Glob_OutBkInterCallsDelays, OutBkDelays, sizeof(OutBkDelays));
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCalib_SameAsDai 
+//-------------------------------------------------------------------------
+// Compare the program read from the capture with DaiFileName. Both are freed
+// Output : false if DaiFileName exists and is different
+bool WavCalib_SameAsDai(char* DaiFileName)
+{
+	struct DaiBlock_Struct Blocks[DataBlock_Count];
+	uint8_t ProgType = Glob_ProgType;
+	uint8_t BkI;
+	bool Same = true;
+
+	memcpy(Blocks, DaiBlocksInfo, sizeof(Blocks));
+	if (ReadDaiFile(DaiFileName) >= 0)
+	{
+		Same = (Glob_ProgType == ProgType);
+		for (BkI = 0; BkI < DataBlock_Count; BkI++)
+		{
+			if ((DaiBlocksInfo[BkI].Len != Blocks[BkI].Len) || ((Blocks[BkI].Len != 0) &&
+				(memcmp(DaiBlocksInfo[BkI].Block, Blocks[BkI].Block, Blocks[BkI].Len) != 0)))
+			{
+				Same = false;
+			}
+		}
+		WavCalib_FreeBlocks();
+	}
+	memcpy(DaiBlocksInfo, Blocks, sizeof(Blocks));
+	WavCalib_FreeBlocks();
+	return (Same);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCalib_FreeBlocks 
+//-------------------------------------------------------------------------
+void WavCalib_FreeBlocks(void)
+{
+	uint8_t BkI;
+
+	for (BkI = 0; BkI < DataBlock_Count; BkI++)
+	{
+		if (DaiBlocksInfo[BkI].Block != NULL) { free(DaiBlocksInfo[BkI].Block); }
+		DaiBlocksInfo[BkI].Block = NULL;
+	}
+}
+
+
+//-------------------------------------------------------------------------
+// WavCalib_AddByte 
+//-------------------------------------------------------------------------
+// Called by WavIn for each byte read while WavIn_Calib is set
+// Input : Key of the delay before the byte (see WavCalib.h), for its 8 DaiBits: Cpu cycles from previous DaiBit end to P0 end
+// and values of previous and current DaiBits (bits 1 and 0)
+void WavCalib_AddByte(int16_t Key, const uint64_t* P0Delays, const uint8_t* BitValues)
+{
+	uint64_t NextSum = 0;
+	uint8_t NextCount = 0;
+	uint8_t BitI;
+
+	if ((Key < 0) || (Key >= WavCalib_KeysCount) || (P0Delays[0] >= WavCalib_GapMax)) return;
+	for (BitI = 1; BitI < 8; BitI++)
+	{
+		if ((BitValues[BitI] != BitValues[0]) || (P0Delays[BitI] >= WavCalib_GapMax)) continue;
+		NextSum += P0Delays[BitI];
+		NextCount++;
+	}
+	if (NextCount == 0) return; // Byte is not used
+	WavCalib_Capture.Sum[Key] += (double)P0Delays[0] - (double)NextSum / NextCount;
+	WavCalib_Capture.Count[Key]++;
+}
+
+
+//-------------------------------------------------------------------------
+// WavCalib_Delay 
+//-------------------------------------------------------------------------
+// Learned delay of a key
+// Output : delay, or Current if not enough bytes
+int32_t WavCalib_Delay(int16_t Key, uint16_t Current)
+{
+	double Delay;
+
+	if (WavCalib_All.Count[Key] < WavCalib_MinBytes) return (Current);
+	Delay = WavCalib_All.Sum[Key] / WavCalib_All.Count[Key] + InterDaitBits_Delay;
+	return ((Delay < 0) ? 0 : (int32_t)(Delay + 0.5));
+}
+
+
+//-------------------------------------------------------------------------
+// WavCalib_Write 
+//-------------------------------------------------------------------------
+// Print learned delays vs current ones, and write them in FileName as InBkInterCallsDelays and OutBkInterCallsDelays initializers
+// Output : 0 or negative error
+int16_t WavCalib_Write(const char* FileName)
+{
+	int32_t InBk[DataBlock_Count][PosInBlock_Count];
+	int32_t OutBk[ProgType_Count][PosInFile_Count];
+	uint8_t Row;
+	uint8_t Pos;
+	FILE* File;
+
+	if (WavCalib_NCaptures == 0)
+	{
+		printf("No valid capture, %s not written\n", FileName);
+		return (-FileParamErr);
+	}
+	printf("Inter calls delays learned from %d captures (current ones):\n", WavCalib_NCaptures);
+	for (Row = 0; Row < DataBlock_Count; Row++)
+	{
+		printf("  DataBlock %d:", Row);
+		for (Pos = 0; Pos < PosInBlock_Count; Pos++)
+		{
+			InBk[Row][Pos] = WavCalib_Delay(WavCalib_InBkKey(Row, Pos), Glob_InBkInterCallsDelays[Row][Pos]);
+			printf(" %d(%d)", InBk[Row][Pos], Glob_InBkInterCallsDelays[Row][Pos]);
+		}
+		printf("\n");
+	}
+	for (Row = 0; Row < ProgType_Count; Row++)
+	{
+		printf("  ProgType %d:", Row);
+		for (Pos = 0; Pos < PosInFile_Count; Pos++)
+		{
+			OutBk[Row][Pos] = WavCalib_Delay(WavCalib_OutBkKey(Row, Pos), Glob_OutBkInterCallsDelays[Row][Pos]);
+			printf(" %d(%d)", OutBk[Row][Pos], Glob_OutBkInterCallsDelays[Row][Pos]);
+		}
+		printf("\n");
+	}
+
+	File = fopen(FileName, "w");
+	if (File == NULL) { return (-FileParamErr); }
+	fprintf(File, "// Learned by Dgv from %d captures, read by 'D' option\n", WavCalib_NCaptures);
+	fprintf(File, "// DataBlock x { LenH, LenL, LenCS, 1stByte, InData, LastByte }\n");
+	for (Row = 0; Row < DataBlock_Count; Row++)
+	{
+		fprintf(File, "%s{%d,%d,%d,%d,%d,%d}%s\n", (Row == 0 ? "{ " : "  "), InBk[Row][0], InBk[Row][1], InBk[Row][2],
+			InBk[Row][3], InBk[Row][4], InBk[Row][5], (Row == DataBlock_Count - 1 ? " };" : ","));
+	}
+	fprintf(File, "\n// ProgType x { Leader, SyncByte, ProgByte, InBlock, BlockCS0, BlockCSN, Trailer }\n");
+	for (Row = 0; Row < ProgType_Count; Row++)
+	{
+		fprintf(File, "%s{%d,%d,%d,%d,%d,%d,%d}%s\n", (Row == 0 ? "{ " : "  "), OutBk[Row][0], OutBk[Row][1], OutBk[Row][2],
+			OutBk[Row][3], OutBk[Row][4], OutBk[Row][5], OutBk[Row][6], (Row == ProgType_Count - 1 ? " };" : ","));
+	}
+	fclose(File);
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCalib_Load 
+//-------------------------------------------------------------------------
+// Load delays written by WavCalib_Write in InBkDelays and OutBkDelays (see WavOutConfig_Struct)
+// Output : 0 or negative error, delays are unchanged on error
+int16_t WavCalib_Load(const char* FileName, uint16_t InBkDelays[DataBlock_Count][PosInBlock_Count], uint16_t OutBkDelays[ProgType_Count][PosInFile_Count])
+{
+	long Values[WavCalib_ValuesCount];
+	uint8_t ValueI;
+
+	if (ReadNumbersFile(FileName, Values, WavCalib_ValuesCount) < WavCalib_ValuesCount) return (-FileParamErr);
+	for (ValueI = 0; ValueI < WavCalib_ValuesCount; ValueI++)
+	{
+		if ((Values[ValueI] < 0) || (Values[ValueI] >= WavCalib_GapMax)) return (-FileParamErr);
+	}
+	for (ValueI = 0; ValueI < DataBlock_Count * PosInBlock_Count; ValueI++)
+	{
+		InBkDelays[ValueI / PosInBlock_Count][ValueI % PosInBlock_Count] = (uint16_t)Values[ValueI];
+	}
+	for (; ValueI < WavCalib_ValuesCount; ValueI++)
+	{
+		OutBkDelays[(ValueI - DataBlock_Count * PosInBlock_Count) / PosInFile_Count]
+			[(ValueI - DataBlock_Count * PosInBlock_Count) % PosInFile_Count] = (uint16_t)Values[ValueI];
+	}
+	return (0);
+}
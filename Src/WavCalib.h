@@ -0,0 +1,57 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVCALIB_H
+#define WAVCALIB_H
+#include <stdint.h> 
+#include "Const.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Calibration of inter calls delays ('Dgv *.wav *.cal') from reference captures (Mame or Dai)
+// Each capture is read by the WavIn firmware model without inter calls delays, so that the period 0 of every DaiBit
+// is measured from its start. Delay before a byte = mean over bytes of (P0 of first DaiBit - mean P0 of its other DaiBits
+// with the same value and following a DaiBit of the same value) + InterDaitBits_Delay. DaiBits of a byte have the same speed type
+// A capture is used only if it is read back without error, and is the same as its .dai file when there is one
+#define WavCalib_FileName "DgvDelays.cal" // Learned delays, written by 'Dgv *.wav *.cal' and read by 'D' option
+#define WavCalib_Ext ".cal"
+#define WavCalib_GapMax 4096 // Cpu cycles, bytes with a longer P0 are ignored
+#define WavCalib_MinBytes 1 // Bytes required to learn the delay of a position, current delay is kept otherwise
+
+// Calibration keys: OutBkInterCallsDelays positions, then InBkInterCallsDelays positions
+#define WavCalib_NoKey (-1) // Delay not learned (after sync bit)
+#define WavCalib_OutBkKey(ProgTypeI, PosInFile) ((int16_t)((ProgTypeI) * PosInFile_Count + (PosInFile)))
+#define WavCalib_InBkKey(BlockI, PosInBlock) ((int16_t)(ProgType_Count * PosInFile_Count + (BlockI) * PosInBlock_Count + (PosInBlock)))
+#define WavCalib_KeysCount (ProgType_Count * PosInFile_Count + DataBlock_Count * PosInBlock_Count)
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t DgvWavCalib(char* WavFileName, char* DaiFileName);
+int16_t WavCalib_Write(const char* FileName);
+int16_t WavCalib_Load(const char* FileName, uint16_t InBkDelays[DataBlock_Count][PosInBlock_Count], uint16_t OutBkDelays[ProgType_Count][PosInFile_Count]);
+void WavCalib_AddByte(int16_t Key, const uint64_t* P0Delays, const uint8_t* BitValues);
+
+#endif
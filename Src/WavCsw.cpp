@@ -0,0 +1,383 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavCsw.cpp
+***********************************************************************************/
+// Compressed square wave files (.csw), pulses of a tape signal (see WavCsw.h)
+// Header of version 2 : signature, 0x1A, version 2.0, sampling frequency (32 bits), pulses count (32 bits), compression (1 = RLE),
+// flags (bit 0 = first pulse high), header extension length, encoding application (16 chars), header extension
+// Header of version 1 : signature, 0x1A, version 1.x, sampling frequency (16 bits), compression (1 = RLE), flags, 3 reserved bytes
+// RLE data : one byte per pulse of 1 to 255 samples, or 0 followed by the samples count (32 bits)
+// All values are little endian
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Const.h"
+#include "FilesIO.h"
+#include "WavIn.h"
+#include "WavOut.h"
+#include "WavCsw.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavCsw_Signature "Compressed Square Wave\x1A"
+#define WavCsw_SignatureLen 23
+#define WavCsw_HeaderV1Len 0x20
+#define WavCsw_HeaderV2Len 0x34 // Without header extension
+#define WavCsw_BufferSamples 0x4000 // Samples converted at once
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+uint32_t WavCsw_Get32(const uint8_t* Data);
+void WavCsw_Put32(uint8_t* Data, uint32_t Value);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// WavCsw_Read 
+//-------------------------------------------------------------------------
+// Read the pulses of a csw file in memory, Csw->PulseEnd to be released with WavCsw_Free
+// Output : 0 or negative error
+int16_t WavCsw_Read(const char* CswFileName, struct WavCsw_Struct* Csw)
+{
+	FILE* File;
+	uint8_t* Data = NULL;
+	long Len;
+	uint32_t Pos;
+	uint32_t DataPos;
+	uint32_t Samples;
+	uint32_t End;
+	uint32_t PulseI;
+	uint8_t Compression;
+	uint8_t Pass;
+	int16_t NErr = 0;
+
+	memset(Csw, 0, sizeof(*Csw));
+	File = fopen(CswFileName, "rb");
+	if (File == NULL) return (-WavOpenErr);
+	if ((fseek(File, 0, SEEK_END) != 0) || ((Len = ftell(File)) < WavCsw_HeaderV1Len) || (fseek(File, 0, SEEK_SET) != 0))
+	{
+		fclose(File);
+		return (-WavInHeaderErr);
+	}
+	Data = (uint8_t*)malloc(Len);
+	if (Data == NULL) { fclose(File); return (-MemAllocErr); }
+	if (fread(Data, 1, Len, File) != (size_t)Len) { NErr = -WavInReadErr; }
+	fclose(File);
+	if (NErr < 0) { goto CswReadExit; }
+
+	// Header
+	if (memcmp(Data, WavCsw_Signature, WavCsw_SignatureLen) != 0) { NErr = -WavInHeaderErr; goto CswReadExit; }
+	if (Data[0x17] == 1)
+	{
+		Csw->SampleRate = Data[0x19] | (Data[0x1A] << 8);
+		Compression = Data[0x1B];
+		Csw->FirstHigh = ((Data[0x1C] & 1) != 0);
+		DataPos = WavCsw_HeaderV1Len;
+	}
+	else if ((Data[0x17] == 2) && (Len >= WavCsw_HeaderV2Len))
+	{
+		Csw->SampleRate = WavCsw_Get32(Data + 0x19);
+		Compression = Data[0x21];
+		Csw->FirstHigh = ((Data[0x22] & 1) != 0);
+		DataPos = WavCsw_HeaderV2Len + Data[0x23];
+	}
+	else
+	{
+		NErr = -WavInHeaderErr; goto CswReadExit;
+	}
+	if ((Compression != 1) || (Csw->SampleRate == 0) || (DataPos >= (uint32_t)Len)) { NErr = -WavInHeaderErr; goto CswReadExit; }
+
+	// Pulses, counted then stored
+	for (Pass = 0; Pass < 2; Pass++)
+	{
+		PulseI = 0;
+		End = 0;
+		Pos = DataPos;
+		while (Pos < (uint32_t)Len)
+		{
+			Samples = Data[Pos++];
+			if (Samples == 0)
+			{
+				if (Pos + 4 > (uint32_t)Len) break; // Truncated file, last pulse is ignored
+				Samples = WavCsw_Get32(Data + Pos);
+				Pos += 4;
+			}
+			if (End + Samples < End) { NErr = -WavInReadErr; goto CswReadExit; } // More than 2^32 samples
+			End += Samples;
+			if (Pass != 0) { Csw->PulseEnd[PulseI] = End; }
+			PulseI++;
+		}
+		if (Pass == 0)
+		{
+			if (End == 0) { NErr = -EndOfFileErr; goto CswReadExit; }
+			Csw->PulseEnd = (uint32_t*)malloc((size_t)PulseI * sizeof(uint32_t));
+			if (Csw->PulseEnd == NULL) { NErr = -MemAllocErr; goto CswReadExit; }
+		}
+	}
+	Csw->PulsesCount = PulseI;
+
+CswReadExit:
+	free(Data);
+	if (NErr < 0) { WavCsw_Free(Csw); }
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_Free 
+//-------------------------------------------------------------------------
+void WavCsw_Free(struct WavCsw_Struct* Csw)
+{
+	free(Csw->PulseEnd);
+	Csw->PulseEnd = NULL;
+	Csw->PulsesCount = 0;
+	Csw->Cursor = 0;
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_Level 
+//-------------------------------------------------------------------------
+// Level of a sample as a 1 byte wav sample, 255 for a high pulse and 0 for a low one
+// Samples are read in time order by the firmware model, the cursor only moves by a few pulses
+uint8_t WavCsw_Level(struct WavCsw_Struct* Csw, uint32_t SampleI)
+{
+	while ((Csw->Cursor > 0) && (SampleI < Csw->PulseEnd[Csw->Cursor - 1]))
+	{
+		Csw->Cursor--;
+	}
+	while ((Csw->Cursor + 1 < Csw->PulsesCount) && (SampleI >= Csw->PulseEnd[Csw->Cursor]))
+	{
+		Csw->Cursor++;
+	}
+	return ((Csw->FirstHigh != ((Csw->Cursor & 1) != 0)) ? 255 : 0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_WriteHeader 
+//-------------------------------------------------------------------------
+// Write the header of a csw file, version 2 with RLE compression
+int16_t WavCsw_WriteHeader(FILE* File, uint32_t SampleRate, uint32_t PulsesCount, bool FirstHigh)
+{
+	uint8_t Head[WavCsw_HeaderV2Len];
+
+	memset(Head, 0, sizeof(Head));
+	memcpy(Head, WavCsw_Signature, WavCsw_SignatureLen);
+	Head[0x17] = 2; // Version 2.0
+	WavCsw_Put32(Head + 0x19, SampleRate);
+	WavCsw_Put32(Head + 0x1D, PulsesCount);
+	Head[0x21] = 1; // RLE
+	Head[0x22] = (FirstHigh ? 1 : 0);
+	memcpy(Head + 0x24, WavCsw_App, strlen(WavCsw_App));
+	if (fwrite(Head, sizeof(Head), 1, File) != 1) return (-WavWriteErr);
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_PulseCode 
+//-------------------------------------------------------------------------
+// RLE code of a pulse of Samples
+// Output : length of Code, 1 or 5 bytes
+uint8_t WavCsw_PulseCode(uint32_t Samples, uint8_t* Code)
+{
+	if ((Samples != 0) && (Samples < 0x100))
+	{
+		Code[0] = (uint8_t)Samples;
+		return (1);
+	}
+	Code[0] = 0;
+	WavCsw_Put32(Code + 1, Samples);
+	return (5);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_FromWav 
+//-------------------------------------------------------------------------
+// Convert a wav file into a csw file at the same sampling frequency, a pulse ends when the signal reaches the opposite trigger level
+// of the firmware model (TTLNormInLevels), so that both files are read the same way with either parity. Channel WavInChannel is used
+// Output : 0 or negative error
+int16_t WavCsw_FromWav(char* WavFileName, const char* CswFileName)
+{
+	struct Wav_Struct Wav;
+	FILE* In = NULL;
+	FILE* Out = NULL;
+	uint8_t* Samples = NULL;
+	uint8_t Code[5];
+	uint32_t SampleI;
+	uint32_t Part;
+	uint32_t Pos;
+	uint32_t Offset;
+	uint32_t Run = 0; // Samples of current pulse
+	uint32_t Pulses = 0;
+	int16_t Signal;
+	bool High = false;
+	bool FirstHigh = false;
+	int16_t NErr = 0;
+
+	if (ReadWavHeader(WavFileName, &Wav) < 0) return (-WavInHeaderErr);
+	if ((Wav.SampleLen < 1) || (Wav.SampleLen > 2) || (Wav.SamplesPerChannel <= 0)) return (-WavInHeaderErr);
+	Offset = Wav.SampleLen * (Wav.Head.NumChannels > WavInChannel ? WavInChannel : 0);
+
+	In = fopen(WavFileName, "rb");
+	if ((In == NULL) || (fseek(In, Wav.DataPos, SEEK_SET) != 0)) { NErr = -WavInReadErr; goto FromWavExit; }
+	Out = fopen(CswFileName, "wb");
+	if (Out == NULL) { NErr = -WavOpenErr; goto FromWavExit; }
+	NErr = WavCsw_WriteHeader(Out, Wav.Head.SampleRate, 0, false); // Rewritten with the pulses count
+	if (NErr < 0) { goto FromWavExit; }
+	Samples = (uint8_t*)malloc((size_t)WavCsw_BufferSamples * Wav.Head.BlockAlign);
+	if (Samples == NULL) { NErr = -MemAllocErr; goto FromWavExit; }
+
+	for (SampleI = 0; SampleI < (uint32_t)Wav.SamplesPerChannel; SampleI += Part)
+	{
+		Part = (uint32_t)Wav.SamplesPerChannel - SampleI;
+		if (Part > WavCsw_BufferSamples) { Part = WavCsw_BufferSamples; }
+		if (fread(Samples, Wav.Head.BlockAlign, Part, In) != Part) { NErr = -WavInReadErr; goto FromWavExit; }
+		for (Pos = 0; Pos < Part; Pos++)
+		{
+			Signal = 0; // High byte of a 1 byte sample
+			memcpy(&Signal, Samples + Pos * Wav.Head.BlockAlign + Offset, Wav.SampleLen);
+			if (Wav.SampleLen != 1) { Signal = Signal / 256 + 128; } // Same scale as LevelChangeLoops
+			if ((SampleI == 0) && (Pos == 0))
+			{
+				High = (Signal >= 128);
+				FirstHigh = High;
+			}
+			else if ((High) ? (Signal <= TTLNormInLevels[0]) : (Signal >= TTLNormInLevels[1]))
+			{
+				if (fwrite(Code, WavCsw_PulseCode(Run, Code), 1, Out) != 1) { NErr = -WavWriteErr; goto FromWavExit; }
+				Pulses++;
+				Run = 0;
+				High = !High;
+			}
+			Run++;
+		}
+	}
+	if (fwrite(Code, WavCsw_PulseCode(Run, Code), 1, Out) != 1) { NErr = -WavWriteErr; goto FromWavExit; }
+	Pulses++;
+	if (fseek(Out, 0, SEEK_SET) != 0) { NErr = -WavWriteErr; goto FromWavExit; }
+	NErr = WavCsw_WriteHeader(Out, Wav.Head.SampleRate, Pulses, FirstHigh);
+
+FromWavExit:
+	if (In != NULL) { fclose(In); }
+	if ((Out != NULL) && (fclose(Out) != 0) && (NErr == 0)) { NErr = -WavWriteErr; }
+	free(Samples);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_ToWav 
+//-------------------------------------------------------------------------
+// Convert a csw file into a wav file at the csw sampling frequency, with the channels and sample size of Format
+// Levels are WavLevels_*[0], a high pulse has the level of TTL high, as read from the csw by the firmware model
+// Output : 0 or negative error
+int16_t WavCsw_ToWav(const char* CswFileName, const char* WavFileName, const struct WavFormat_Struct* Format)
+{
+	struct WavCsw_Struct Csw;
+	FILE* Out = NULL;
+	uint8_t* Buffer = NULL;
+	uint8_t SampleWav[2][4]; // One sample of all channels of each level
+	uint32_t SampleLen = Format->NChannels * Format->Bytes_per_sample;
+	uint32_t BufferPos = 0;
+	uint32_t SampleI = 0;
+	uint32_t PulseI;
+	uint8_t Level;
+	uint8_t Ch;
+	int16_t WavLevel;
+	int16_t NErr;
+
+	NErr = WavCsw_Read(CswFileName, &Csw);
+	if (NErr < 0) return (NErr);
+	if ((uint64_t)Csw.PulseEnd[Csw.PulsesCount - 1] * SampleLen > 0xFFFFFFFF - WavCsw_HeaderV2Len) { NErr = -WavWriteErr; goto ToWavExit; } // Wav size limit
+	for (Level = 0; Level < 2; Level++)
+	{
+		WavLevel = (Format->Bytes_per_sample == 2 ? WavLevels_2B[0][Level] : WavLevels_1B[0][Level]);
+		for (Ch = 0; Ch < Format->NChannels; Ch++)
+		{
+			memcpy(SampleWav[Level] + Ch * Format->Bytes_per_sample, &WavLevel, Format->Bytes_per_sample); // Little endian, as in wav files
+		}
+	}
+
+	Out = fopen(WavFileName, "wb");
+	if (Out == NULL) { NErr = -WavOpenErr; goto ToWavExit; }
+	NErr = CreateWavOut(Out, Csw.PulseEnd[Csw.PulsesCount - 1] * Format->NChannels, Csw.SampleRate, Format->NChannels, Format->Bytes_per_sample);
+	if (NErr < 0) { goto ToWavExit; }
+	Buffer = (uint8_t*)malloc((size_t)WavCsw_BufferSamples * SampleLen);
+	if (Buffer == NULL) { NErr = -MemAllocErr; goto ToWavExit; }
+
+	for (PulseI = 0; PulseI < Csw.PulsesCount; PulseI++)
+	{
+		Level = (Csw.FirstHigh != ((PulseI & 1) != 0));
+		for (; SampleI < Csw.PulseEnd[PulseI]; SampleI++)
+		{
+			memcpy(Buffer + BufferPos, SampleWav[Level], SampleLen);
+			BufferPos += SampleLen;
+			if (BufferPos == WavCsw_BufferSamples * SampleLen)
+			{
+				if (fwrite(Buffer, 1, BufferPos, Out) != BufferPos) { NErr = -WavWriteErr; goto ToWavExit; }
+				BufferPos = 0;
+			}
+		}
+	}
+	if (fwrite(Buffer, 1, BufferPos, Out) != BufferPos) { NErr = -WavWriteErr; }
+
+ToWavExit:
+	if ((Out != NULL) && (fclose(Out) != 0) && (NErr == 0)) { NErr = -WavWriteErr; }
+	free(Buffer);
+	WavCsw_Free(&Csw);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_Get32 
+//-------------------------------------------------------------------------
+uint32_t WavCsw_Get32(const uint8_t* Data)
+{
+	return ((uint32_t)Data[0] | ((uint32_t)Data[1] << 8) | ((uint32_t)Data[2] << 16) | ((uint32_t)Data[3] << 24));
+}
+
+
+//-------------------------------------------------------------------------
+// WavCsw_Put32 
+//-------------------------------------------------------------------------
+void WavCsw_Put32(uint8_t* Data, uint32_t Value)
+{
+	Data[0] = (uint8_t)Value;
+	Data[1] = (uint8_t)(Value >> 8);
+	Data[2] = (uint8_t)(Value >> 16);
+	Data[3] = (uint8_t)(Value >> 24);
+}
@@ -0,0 +1,68 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVCSW_H
+#define WAVCSW_H
+#include <stdio.h>
+#include <stdint.h> 
+#include "Const.h"
+#include "WavIO.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Compressed square wave files (.csw), a tape signal stored as the length in samples of each pulse (level between two transitions)
+// Read as decoder input in place of a wav (versions 1 and 2, RLE), written by the encoder in place of a wav (version 2, RLE)
+// A csw and a wav of the same sampling frequency give the same levels to the firmware model (see WavIn LevelChangeLoops):
+//	- 'Dgv x.wav *.csw' stores the pulses seen by the firmware model (trigger levels TTLNormInLevels), at the wav frequency
+//	- 'Dgv x.csw *.wav' writes back the pulses as samples, at the csw frequency (format options M, S, B, W)
+// Z-RLE compression (type 2) is not supported, it requires zlib
+#define WavCsw_Ext ".csw"
+#define WavCsw_App "Dgv" // Encoding application, in the header
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+struct WavCsw_Struct // Pulses of a csw file in memory
+{
+	uint32_t SampleRate;
+	uint32_t PulsesCount;
+	uint32_t* PulseEnd; // Sample index following each pulse
+	bool FirstHigh; // Level of first pulse, next ones alternate
+	uint32_t Cursor; // Pulse of the last sample read (see WavCsw_Level)
+};
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t WavCsw_Read(const char* CswFileName, struct WavCsw_Struct* Csw);
+void WavCsw_Free(struct WavCsw_Struct* Csw);
+uint8_t WavCsw_Level(struct WavCsw_Struct* Csw, uint32_t SampleI);
+int16_t WavCsw_WriteHeader(FILE* File, uint32_t SampleRate, uint32_t PulsesCount, bool FirstHigh);
+uint8_t WavCsw_PulseCode(uint32_t Samples, uint8_t* Code);
+int16_t WavCsw_FromWav(char* WavFileName, const char* CswFileName);
+int16_t WavCsw_ToWav(const char* CswFileName, const char* WavFileName, const struct WavFormat_Struct* Format);
+
+#endif
@@ -0,0 +1,121 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavEst.cpp
+***********************************************************************************/
+// Estimate the wav of a program for all hardware profiles, without rendering any sample
+// Each profile only needs the count of DaiBits of each shape (see WavOut_Estimate), table is printed and appended to the report
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <chrono>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavOut.h"
+#include "WavEst.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavEst_HeaderLen 44 // Wav header written by WavRaster
+#define WavEst_ProfilesCount (sizeof(DaiHW_Profile) / sizeof(DaiHW_Profile[0]))
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// DgvWavEst
+//-------------------------------------------------------------------------
+// Samples, duration, file size and load time (end of last block checksum) of the wav of each profile with Options
+// (V is replaced by each profile), printed next to each estimate. Options which need a render are not estimated (see WavEst_NotEstimated)
+// Gain is the load time saved compared with the first profile of the table
+// Output : 0 or negative error, encoder configuration of the caller is unchanged
+int16_t DgvWavEst(char* DaiFileName, const char* ReportName, const char* Options)
+{
+	struct WavOutEstimate_Struct Est;
+	struct WavOutConfig_Struct Caller;
+	struct WavOutConfig_Struct Config;
+	const struct WavFormat_Struct* Format;
+	char ProfileOptions[OptionsLenMax + 2];
+	char* Hw;
+	FILE* File;
+	char Report[(WavEst_ProfilesCount + 3) * 128];
+	char* Line;
+	double LoadRef = -1; // Load time of the first profile
+	double Load_s;
+	uint64_t Size;
+	uint16_t DaiHwI;
+	int16_t NErr;
+
+	NErr = ReadDaiFile(DaiFileName); if (NErr < 0) { return (NErr); }
+	WavOut_GetConfig(&Caller);
+
+	auto Start = std::chrono::steady_clock::now();
+	Line = Report;
+	Line += sprintf(Line, "%s: estimate per profile (%s options are not estimated)\n", DaiFileName, WavEst_NotEstimated);
+	Line += sprintf(Line, "Profile         Options               Samples  Duration(s)   Size(bytes)  DaiBits  Load(s)  Gain(s)\n");
+	for (DaiHwI = 0; DaiHwI < WavEst_ProfilesCount; DaiHwI++)
+	{
+		if ((DaiHwI_BitMask & (1 << DaiHwI)) == 0) continue;
+		strncpy(ProfileOptions, Options, OptionsLenMax);
+		ProfileOptions[OptionsLenMax] = '\0';
+		Hw = strrchr(ProfileOptions, 'V');
+		if ((Hw != NULL) && (Hw[1] >= '0') && (Hw[1] <= '9')) { Hw[1] = (char)('0' + DaiHwI); }
+		WavOut_Config(DaiHwI, ProfileOptions, &Config);
+		Config.TuneMargin = WavOut_TuneOff;
+		Config.Turbo = false;
+		Config.Playlist = false;
+		Config.Grid = false;
+		Config.Formats[0].AutoRate = 0;
+		WavOut_SetConfig(&Config);
+		Update_WavOut_NameOptions(WavOut_NameOptions); // Options of the estimate
+		Format = &WavOut_Formats[0];
+		NErr = WavOut_Estimate(Format, &Est); if (NErr < 0) { break; }
+		Size = WavEst_HeaderLen + Est.Samples * Format->NChannels * Format->Bytes_per_sample;
+		Load_s = (double)Est.LoadSamples / Format->SamplingFq;
+		if (LoadRef < 0) { LoadRef = Load_s; }
+		Line += sprintf(Line, "V%u %-11s %-18s  %10llu  %11.2f  %12llu  %7u  %7.2f  %7.2f\n",
+			DaiHwI, DaiHW_Profile[DaiHwI].ProfileName, WavOut_NameOptions + 2, (unsigned long long)Est.Samples, (double)Est.Samples / Format->SamplingFq,
+			(unsigned long long)Size, Est.DaiBits, Load_s, LoadRef - Load_s);
+	}
+	auto Stop = std::chrono::steady_clock::now();
+	WavOut_SetConfig(&Caller);
+	if (NErr < 0)
+	{
+		Line += sprintf(Line, "Error %d, no estimate for the next profiles\n", NErr);
+	}
+	sprintf(Line, "Evaluated in %lld us\n", (long long)std::chrono::duration_cast<std::chrono::microseconds>(Stop - Start).count());
+
+	printf("%s", Report);
+	File = fopen(ReportName, "a");
+	if (File == NULL) { return (-FileParamErr); }
+	fputs(Report, File);
+	fclose(File);
+	return (NErr < 0 ? NErr : 0);
+}
@@ -0,0 +1,43 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVEST_H
+#define WAVEST_H
+#include <stdint.h> 
+#include "Const.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Load time estimate of a program ('Dgv File.dai *.est') for each profile of DaiHwI_BitMask, with the options of the command
+// Samples, file size and load time are computed from the program bytes without writing samples (see WavOut_Estimate)
+#define WavEst_Ext ".est" // Extension of report files
+#define WavEst_NotEstimated "T,K,J,G,A" // Options ignored by the estimate: tuning, turbo loader, playlist, grid and automatic rate need a render
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t DgvWavEst(char* DaiFileName, const char* ReportName, const char* Options);
+
+#endif
@@ -0,0 +1,257 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavGrid.cpp
+***********************************************************************************/
+// Write the program in memory in one set of wav files per margin variant (see WavGrid.h)
+// Each variant has its own timing pass and rasters, variants are shared between one thread per core
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <thread>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavOut.h"
+#include "WavRaster.h"
+#include "WavTune.h"
+#include "WavGrid.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavGrid_ValuesCount (WavGrid_DimsCount * 3)
+
+struct WavGridRun_Struct // Program and encoder configuration (profile tuned for the program), copied by each variant thread
+{
+	struct WavOutConfig_Struct Config;
+	struct DaiBlock_Struct Blocks[DataBlock_Count];
+	uint8_t ProgType;
+	uint8_t NRasters;
+};
+
+struct WavGridJob_Struct
+{
+	const struct WavGridRun_Struct* Run;
+	int16_t Values[WavGrid_DimsCount]; // Grid coordinates
+	struct WavRaster_Struct Rasters[WavOut_FormatsMax];
+	int16_t NErr; // Output : 0 or first negative error
+};
+
+
+//-------------------------------------------------------------------------
+// Local variables
+//-------------------------------------------------------------------------
+thread_local int16_t WavGrid_Ranges[WavGrid_DimsCount][3]; // {Min,Max,Step}, set by WavGrid_Load
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+int16_t WavGrid_Jobs(struct WavGridJob_Struct* Jobs, uint16_t NJobs);
+void WavGrid_Variant(struct WavGridJob_Struct* Job);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// DgvWavGrid 
+//-------------------------------------------------------------------------
+// Write the program in memory for every point of WavGrid_Ranges, grid coordinates are inserted in the names of Rasters
+// Profile is tuned once before variants ('T' option)
+// Output : 0 or first negative error
+int16_t DgvWavGrid(const struct WavRaster_Struct* Rasters, uint8_t NRasters)
+{
+	struct WavGridRun_Struct Run;
+	struct WavGridJob_Struct* Jobs;
+	const struct DaiHardware_Struct* Profile = WavOut_Profile;
+	int16_t Values[WavGrid_DimsCount];
+	char Coords[8 * WavGrid_DimsCount];
+	uint16_t NJobs = 0;
+	uint16_t JobI;
+	uint8_t RasterI;
+	uint8_t Dim;
+	int16_t NErr = 0;
+
+	Jobs = (struct WavGridJob_Struct*)malloc(WavGrid_VariantsMax * sizeof(struct WavGridJob_Struct));
+	if (Jobs == NULL) return (-MemAllocErr);
+	if (WavOut_TuneMargin != WavOut_TuneOff)
+	{
+		NErr = DgvWavTune(WavOut_TuneMargin); if (NErr < 0) { goto GridExit; }
+	}
+
+	WavOut_GetConfig(&Run.Config);
+	Run.Config.TuneMargin = WavOut_TuneOff; // Variants are written with the tuned profile
+	memcpy(Run.Blocks, DaiBlocksInfo, sizeof(Run.Blocks));
+	Run.ProgType = Glob_ProgType;
+	Run.NRasters = NRasters;
+
+	// Grid points, first dimension varies fastest
+	for (Dim = 0; Dim < WavGrid_DimsCount; Dim++) { Values[Dim] = WavGrid_Ranges[Dim][0]; }
+	while (NJobs < WavGrid_VariantsMax)
+	{
+		Jobs[NJobs].Run = &Run;
+		memcpy(Jobs[NJobs].Values, Values, sizeof(Values));
+		sprintf(Coords, "_G%d.%d.%d.%d_%d_%d", Values[WavGrid_P0], Values[WavGrid_P1], Values[WavGrid_P2], Values[WavGrid_P3],
+			Values[WavGrid_InBk], Values[WavGrid_OutBk]);
+		for (RasterI = 0; RasterI < NRasters; RasterI++)
+		{
+			Jobs[NJobs].Rasters[RasterI] = Rasters[RasterI];
+			if (strlen(Rasters[RasterI].FileName) + strlen(Coords) > MaxLenString) { NErr = -WavOpenErr; goto GridExit; }
+			InsertStringBefExt(Coords, Rasters[RasterI].FileName, Jobs[NJobs].Rasters[RasterI].FileName);
+		}
+		NJobs++;
+
+		for (Dim = 0; Dim < WavGrid_DimsCount; Dim++)
+		{
+			Values[Dim] += WavGrid_Ranges[Dim][2];
+			if (Values[Dim] <= WavGrid_Ranges[Dim][1]) break;
+			Values[Dim] = WavGrid_Ranges[Dim][0];
+		}
+		if (Dim == WavGrid_DimsCount) break; // Last point
+	}
+	fprintf(stderr, "%d margin variants\n", NJobs);
+
+	NErr = WavGrid_Jobs(Jobs, NJobs);
+	for (JobI = 0; (JobI < NJobs) && (NErr >= 0); JobI++)
+	{
+		NErr = Jobs[JobI].NErr;
+	}
+
+GridExit:
+	if (WavOut_Profile != Profile) { SetWavOutProfile(Profile); } // Next program is tuned from the same profile
+	free(Jobs);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavGrid_Jobs 
+//-------------------------------------------------------------------------
+// Write variants, each one by its own thread, as many at once as cores
+// Output : 0 or negative error, result of each variant is in Jobs[i].NErr
+int16_t WavGrid_Jobs(struct WavGridJob_Struct* Jobs, uint16_t NJobs)
+{
+	std::thread* Threads[WavGrid_VariantsMax];
+	uint32_t NThreads;
+	uint16_t First;
+	uint16_t JobI;
+	int16_t NErr = 0;
+
+	NThreads = std::thread::hardware_concurrency(); // 0 if unknown
+	if (NThreads < 1) { NThreads = 1; }
+	if (NThreads > WavGrid_VariantsMax) { NThreads = WavGrid_VariantsMax; }
+
+	// Variant threads have their own encoder and firmware model state, the caller one is unchanged
+	for (First = 0; First < NJobs; First += (uint16_t)NThreads)
+	{
+		for (JobI = First; (JobI < NJobs) && (JobI < First + NThreads); JobI++)
+		{
+			Threads[JobI] = NULL;
+			Jobs[JobI].NErr = -MemAllocErr;
+			try
+			{
+				Threads[JobI] = new std::thread(WavGrid_Variant, &Jobs[JobI]);
+			}
+			catch (...)
+			{
+				NErr = -MemAllocErr;
+			}
+		}
+		for (JobI = First; (JobI < NJobs) && (JobI < First + NThreads); JobI++)
+		{
+			if (Threads[JobI] != NULL)
+			{
+				Threads[JobI]->join();
+				delete Threads[JobI];
+			}
+		}
+	}
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavGrid_Variant 
+//-------------------------------------------------------------------------
+// Thread of a variant: program is written with the margins of its grid point, in all rasters
+void WavGrid_Variant(struct WavGridJob_Struct* Job)
+{
+	const struct WavGridRun_Struct* Run = Job->Run;
+	uint8_t RasterI;
+	uint8_t Px;
+	uint8_t Pos;
+
+	memcpy(DaiBlocksInfo, Run->Blocks, sizeof(Run->Blocks));
+	Glob_ProgType = Run->ProgType;
+	WavOut_SetConfig(&Run->Config);
+	for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+	{
+		PeriodsOffset_Delay[Px] += Job->Values[WavGrid_P0 + Px];
+	}
+	for (Pos = 0; Pos < PosInBlock_Count; Pos++) { InBkInterCallsDelaysMargin[Pos] = Job->Values[WavGrid_InBk]; }
+	for (Pos = 0; Pos < PosInFile_Count; Pos++) { OutBkInterCallsDelaysMargin[Pos] = Job->Values[WavGrid_OutBk]; }
+	WavOut_FormatsCount = 0;
+	for (RasterI = 0; RasterI < Run->NRasters; RasterI++) // Leader is checked with every format
+	{
+		WavOut_Formats[WavOut_FormatsCount++] = Job->Rasters[RasterI].Format;
+	}
+
+	Job->NErr = DgvWavOutRasters(Job->Rasters, Run->NRasters);
+	free(WavOut_Edges.Bits); // Edges of this thread
+}
+
+
+//-------------------------------------------------------------------------
+// WavGrid_Load 
+//-------------------------------------------------------------------------
+// Read the grid ({Min,Max,Step} per dimension, see WavGrid.h) from FileName, WavGrid_Default is used if it can't be read
+// Output : 0 or negative error (grid from file is invalid, or has more than WavGrid_VariantsMax points)
+int16_t WavGrid_Load(const char* FileName)
+{
+	long Values[WavGrid_ValuesCount];
+	uint32_t NPoints = 1;
+	uint8_t Dim;
+
+	if (ReadNumbersFile(FileName, Values, WavGrid_ValuesCount) < WavGrid_ValuesCount)
+	{
+		fprintf(stderr, "Margin grid not read from %s, default grid is used\n", FileName);
+		for (Dim = 0; Dim < WavGrid_ValuesCount; Dim++) { Values[Dim] = WavGrid_Default[Dim / 3][Dim % 3]; }
+	}
+	for (Dim = 0; Dim < WavGrid_DimsCount; Dim++)
+	{
+		if ((Values[3 * Dim] > Values[3 * Dim + 1]) || (Values[3 * Dim + 2] <= 0) ||
+			(Values[3 * Dim] < -WavGrid_ValueMax) || (Values[3 * Dim + 1] > WavGrid_ValueMax)) return (-FileParamErr);
+		NPoints *= (uint32_t)((Values[3 * Dim + 1] - Values[3 * Dim]) / Values[3 * Dim + 2] + 1);
+		if (NPoints > WavGrid_VariantsMax) return (-FileParamErr);
+		WavGrid_Ranges[Dim][0] = (int16_t)Values[3 * Dim];
+		WavGrid_Ranges[Dim][1] = (int16_t)Values[3 * Dim + 1];
+		WavGrid_Ranges[Dim][2] = (int16_t)Values[3 * Dim + 2];
+	}
+	return (0);
+}
@@ -0,0 +1,51 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVGRID_H
+#define WAVGRID_H
+#include <stdint.h> 
+#include "Const.h"
+#include "WavRaster.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Margin variants ('G' option), for test sessions on a Dai: one wav per point of a grid over
+//	- PeriodsOffset_Delay of each period, added to the profile offsets
+//	- InBkInterCallsDelaysMargin and OutBkInterCallsDelaysMargin, same margin at every position
+// Grid is read from WavGrid_FileName, {Min,Max,Step} in Cpu cycles for P0, P1, P2, P3, InBk, OutBk (WavGrid_Default if not found)
+// Coordinates are inserted in wav file names, ex: _G0.0.0.0_20_40 for P0.P1.P2.P3_InBk_OutBk
+enum WavGridDim { WavGrid_P0, WavGrid_P1, WavGrid_P2, WavGrid_P3, WavGrid_InBk, WavGrid_OutBk, WavGrid_DimsCount };
+static const int16_t WavGrid_Default[WavGrid_DimsCount][3] = { {0,0,1},{0,0,1},{0,0,1},{0,0,1},{0,40,20},{0,40,20} };
+#define WavGrid_FileName "DgvGrid.txt"
+#define WavGrid_VariantsMax 256
+#define WavGrid_ValueMax 1000 // Cpu cycles, maximum absolute value of a coordinate
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t DgvWavGrid(const struct WavRaster_Struct* Rasters, uint8_t NRasters);
+int16_t WavGrid_Load(const char* FileName);
+
+#endif
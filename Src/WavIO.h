@@ -48,6 +48,16 @@ struct WavSubchunk_Struct
 	uint32_t	SubchunkSize;		// 'Subchunk2Size, File size(data) ; Size of the data section
 };
 
+struct WavFormat_Struct // Characteristics of a wav output file
+{
+	uint32_t	SamplingFq;			// Sampling frequency in Hz
+	uint8_t		NChannels;			// 1 = Mono, 2 = Stereo, same samples on both channels
+	uint8_t		Bytes_per_sample;	// 1 = uint8_t samples, 2 = int16_t samples
+	uint8_t		InvertSignal;		// 1 when signal is inverted vs TTL levels
+	uint8_t		AutoRate;			// 1 to use the lowest rate keeping timing of SamplingFq (see WavRaster_AutoRate)
+	uint8_t		EdgeShape;			// Shaping of samples following each transition, WavOutEdge_None to WavOutEdge_Count-1 (see WavRaster_EdgeKernel)
+};
+
 struct Wav_Struct
 {
 	WavHeader_Struct Head;
@@ -22,13 +22,16 @@
 
 #ifdef _WIN32 // __unix__
 	#include <windows.h>
-	#include <string.h>
 #endif
+#include <string.h>
+#include <stdlib.h>
 
 #include "FilesIO.h"
 #include"WavIn.h"
 #include "WavOut.h"
 #include "DgvMain.h"
+#include "WavCalib.h"
+#include "WavCsw.h"
 #include <stdbool.h>
 
 //-------------------------------------------------------------------------
@@ -76,45 +79,24 @@
 //-------------------------------------------------------------------------
 // Local variables
 //-------------------------------------------------------------------------
-FILE* WavInFile;
-struct Wav_Struct CurrentWavIn = {};
-struct WavHeader_Struct WavInHeader = {};
-int16_t TriggerLevelDown;
-int16_t TriggerLevelUp;
-uint32_t WavInPosOffset;
-uint32_t WavInPosMax;
-bool WavIn_InvertSignal; // Inverted for a real Dai
-
-
-//---------------
-uint64_t Glob_CpuTime;
-uint32_t Glob_BinByteI_Debug;
-int16_t LoopL;
-int16_t LoopH;
-int16_t LoopHOld;
-#if(WavIn_Display_Debug!=0)
-	int16_t LoopHOld_Debug ;
-#endif
-
-//---------------
-// Interrupt related
-uint64_t Rst6_LastCpuTime ; // Triggered every 16ms, 0xD578 via RST 6
-bool Rst6_NextDelayIsShort ; // Rst6 delay is alternatively short or long
-uint64_t Rst7_LastCpuTime ; // Triggered every 20ms by TV page blanking signal, 0xD9A9 via RST 7 (clock interrupt)
+thread_local bool WavIn_Calib; // P0 detection delays are added to the calibration (see WavCalib)
 
 
 //-------------------------------------------------------------------------
 // Local functions
 //-------------------------------------------------------------------------
-int16_t ReadLeader(void);
-int16_t ReadDaiCore(void);
-int16_t ReadDaiByte(void);
-int16_t ReadDaiBit(uint16_t InterCallsK7ReadDelay) ;
-int16_t LevelChangeLoops(int16_t ExpectedTtlTrigger, uint16_t OffsetDelay, uint16_t LoopDelay, bool LimitDelay, bool IntEnabled) ;
+int16_t ReadLeader(struct WavIn_Struct* In);
+int16_t ReadDaiCore(struct WavIn_Struct* In, uint8_t BlocksCount);
+int16_t ReadDaiByte(struct WavIn_Struct* In);
+int16_t ReadDaiBit(struct WavIn_Struct* In, uint16_t InterCallsK7ReadDelay) ;
+int16_t LevelChangeLoops(struct WavIn_Struct* In, int16_t ExpectedTtlTrigger, uint16_t OffsetDelay, uint16_t LoopDelay, bool LimitDelay, bool IntEnabled) ;
 
-uint16_t InterruptSimul_Delay(int16_t MinDelay);
-uint16_t Rst7Simul_Delay(uint64_t EnabledCpuTime, uint16_t EnabledPeriod);
-uint16_t Rst6Simul_Delay(uint64_t EnabledCpuTime, uint16_t EnabledPeriod);
+uint16_t InterruptSimul_Delay(struct WavIn_Struct* In, int16_t MinDelay);
+uint16_t Rst7Simul_Delay(struct WavIn_Struct* In, uint64_t EnabledCpuTime);
+uint16_t Rst6Simul_Delay(struct WavIn_Struct* In, uint64_t EnabledCpuTime);
+void WavIn_SetMemory(struct WavIn_Struct* In, const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format);
+int16_t WavIn_ReadProgram(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, struct WavInTrial_Struct* Trial, uint8_t BlocksCount);
+int16_t WavIn_NoiseSample(struct WavIn_Struct* In);
 
 
 //=========================================================================
@@ -132,48 +114,62 @@ uint16_t Rst6Simul_Delay(uint64_t EnabledCpuTime, uint16_t EnabledPeriod);
 //		LimitDelay : if true, will exit if 255 loops
 // Output: 
 //		LoopI = K7Read count (limited to 254 if LimitDelay==0) ; or Error (-EndOfFileErr / -WavInReadErr)
-//		Glob_CpuTime updatedDelay since function entry leading signal level change ;
+//		In->CpuTime updatedDelay since function entry leading signal level change ;
 
-int16_t LevelChangeLoops(int16_t ExpectedTtlTrigger, uint16_t OffsetDelay, uint16_t LoopDelay, bool LimitDelay, bool IntEnabled)
+int16_t LevelChangeLoops(struct WavIn_Struct* In, int16_t ExpectedTtlTrigger, uint16_t OffsetDelay, uint16_t LoopDelay, bool LimitDelay, bool IntEnabled)
 {
-	double WavInSampleI_Debug;
 	int16_t WavSignal;
-	int16_t TTLSignal; //Inverted if WavIn_InvertSignal==1
+	int16_t TTLSignal; //Inverted if In->InvertSignal==1
 	uint32_t WavInPosNew;
 	int16_t LoopI = 0;
 	bool NotTriggered;
 	uint16_t InterruptDelay = 0;
 
 	WavSignal = 0;
-	Glob_CpuTime = Glob_CpuTime + OffsetDelay;
+	In->CpuTime = In->CpuTime + OffsetDelay;
 	do
 	{
-		if ((IntEnabled)&&(AllowInterruptSimul))
+		if ((IntEnabled)&&(In->InterruptSimul))
 		{
-			InterruptDelay = InterruptSimul_Delay(0);
-			Glob_CpuTime+= InterruptDelay;
+			InterruptDelay = InterruptSimul_Delay(In, 0);
+			In->CpuTime+= InterruptDelay;
 		}
 
-		WavInPosNew = (uint32_t)(Glob_CpuTime * CurrentWavIn.Head.SampleRate / CpuFq * CurrentWavIn.Head.BlockAlign + WavInPosOffset);
+		WavInPosNew = (uint32_t)(In->CpuTime * In->Wav.Head.SampleRate / CpuFq * In->Wav.Head.BlockAlign + In->PosOffset);
 
-		WavInSampleI_Debug = ((double)Glob_CpuTime) * CurrentWavIn.Head.SampleRate / CpuFq;
-		if (WavInPosNew > WavInPosMax)
+		if (WavInPosNew > In->PosMax)
 		{
 			return (-EndOfFileErr);
 		}
-		if (fseek(WavInFile, WavInPosNew, SEEK_SET))
+		WavSignal = 0; // High byte of a 1 byte sample
+		if (In->Memory != NULL)
 		{
-			return (-WavInReadErr);
+			memcpy(&WavSignal, In->Memory + WavInPosNew, In->Wav.SampleLen);
 		}
-		if (fread(&WavSignal, CurrentWavIn.SampleLen, 1, WavInFile) != 1)
+		else if (In->Pulses)
+		{
+			WavSignal = WavCsw_Level(&In->Csw, WavInPosNew);
+		}
+		else
 		{
-			return (-WavInReadErr);
+			if (fseek(In->File, WavInPosNew, SEEK_SET))
+			{
+				return (-WavInReadErr);
+			}
+			if (fread(&WavSignal, In->Wav.SampleLen, 1, In->File) != 1)
+			{
+				return (-WavInReadErr);
+			}
 		}
-		if (CurrentWavIn.SampleLen != 1) // 2 bytes from -32768 to 32767
+		if (In->Wav.SampleLen != 1) // 2 bytes from -32768 to 32767
 		{
 			WavSignal = WavSignal / 256 + 128; // Back to 0-255
 		}
-		TTLSignal = (WavIn_InvertSignal == 0 ? WavSignal : 255 - WavSignal);
+		if (In->Noise != 0)
+		{
+			WavSignal += WavIn_NoiseSample(In);
+		}
+		TTLSignal = (In->InvertSignal == 0 ? WavSignal : 255 - WavSignal);
 		NotTriggered = (((ExpectedTtlTrigger >= 128) && (TTLSignal < ExpectedTtlTrigger)) || ((ExpectedTtlTrigger < 128) && (TTLSignal > ExpectedTtlTrigger)));
 		if ((LoopI < 254) || (LimitDelay))
 		{
@@ -182,7 +178,7 @@ int16_t LevelChangeLoops(int16_t ExpectedTtlTrigger, uint16_t OffsetDelay, uint1
 
 #if(WavIn_Display_Debug==1) // For debug
 		printf("CpT=%06d,Trg=%02d,TtlV=%03d,NS=%06d,FPs=%02d,Ofs=%03d,", 
-			(uint32_t)Glob_CpuTime, (uint8_t)!NotTriggered, (uint8_t)TTLSignal, (uint32_t)(Glob_CpuTime * CurrentWavIn.Head.SampleRate / CpuFq), (uint8_t)Glob_PosInFile, OffsetDelay);
+			(uint32_t)In->CpuTime, (uint8_t)!NotTriggered, (uint8_t)TTLSignal, (uint32_t)(In->CpuTime * In->Wav.Head.SampleRate / CpuFq), (uint8_t)In->PosInFile, OffsetDelay);
 		if ((TTLSignal < TTLNormInLevels[0])&&(InterruptDelay == 0))
 		{
 			printf("L0I=%03d\n", LoopI);
@@ -199,7 +195,7 @@ int16_t LevelChangeLoops(int16_t ExpectedTtlTrigger, uint16_t OffsetDelay, uint1
 
 		if (NotTriggered) // For next Read (not on exit)
 		{
-			Glob_CpuTime += LoopDelay;
+			In->CpuTime += LoopDelay;
 		}
 
 		if ((LimitDelay) && (LoopI == 255)) // Exit if too many loops
@@ -215,28 +211,29 @@ int16_t LevelChangeLoops(int16_t ExpectedTtlTrigger, uint16_t OffsetDelay, uint1
 //-------------------------------------------------------------------------
 // InterruptSimul_Delay 
 //-------------------------------------------------------------------------
-// Input : MinDelay, delay to be added to Glob_CpuTime (o/w if no interrupt)
-// Output : Delay to be added to Glob_CpuTime due to interrupts + MinDelay
-uint16_t InterruptSimul_Delay(int16_t MinDelay)
+// Input : MinDelay, delay to be added to In->CpuTime (o/w if no interrupt)
+// Output : Delay to be added to In->CpuTime due to interrupts + MinDelay
+uint16_t InterruptSimul_Delay(struct WavIn_Struct* In, int16_t MinDelay)
 {
-	#if(AllowInterruptSimul==1)
-		uint64_t EnabledCpuT=0;
-		uint16_t Delay;
-		if (Glob_CpuTime > 15) { EnabledCpuT = Glob_CpuTime - 15; } //  to EI
-		if ((Rst7Period_Delay + Rst7_LastCpuTime) > (Rst6Period_Delay + Rst6_LastCpuTime)) // XXX is it the right test ?
-		{
-			Delay = Rst6Simul_Delay(EnabledCpuT, MinDelay) ;
-			Delay = Rst7Simul_Delay(EnabledCpuT, MinDelay + Delay) + Delay;
-		}
-		else
-		{
-			Delay = Rst7Simul_Delay(EnabledCpuT, MinDelay);
-			Delay = Rst6Simul_Delay(EnabledCpuT, MinDelay + Delay) + Delay;
-		}
-		return (Delay + MinDelay);
-	#else
+	uint64_t EnabledCpuT=0;
+	uint16_t Delay;
+
+	if (!In->InterruptSimul)
+	{
 		return (MinDelay);
-	#endif
+	}
+	if (In->CpuTime > 15) { EnabledCpuT = In->CpuTime - 15; } //  to EI
+	if ((Rst7Period_Delay + In->Rst7_LastCpuTime) > (Rst6Period_Delay + In->Rst6_LastCpuTime)) // XXX is it the right test ?
+	{
+		Delay = Rst6Simul_Delay(In, EnabledCpuT) ;
+		Delay = Rst7Simul_Delay(In, EnabledCpuT) + Delay;
+	}
+	else
+	{
+		Delay = Rst7Simul_Delay(In, EnabledCpuT);
+		Delay = Rst6Simul_Delay(In, EnabledCpuT) + Delay;
+	}
+	return (Delay + MinDelay);
 
 }
 
@@ -244,27 +241,26 @@ uint16_t InterruptSimul_Delay(int16_t MinDelay)
 //-------------------------------------------------------------------------
 // Rst6Simul_Delay 
 //-------------------------------------------------------------------------
-// Input :	EnabledCpuTime, time at which interrupts have been enabled
-//			EnabledPeriod, delay after EnabledCpuTime during which interrupts remain enabled
-// Output : Delay to be added to Glob_CpuTime if interrupt Rst 6 is triggered, 0 if no trigger
-uint16_t Rst6Simul_Delay(uint64_t EnabledCpuTime, uint16_t EnabledPeriod)
+// Input :	EnabledCpuTime, time at which interrupts have been enabled, a pending interrupt is triggered then
+// Output : Delay to be added to In->CpuTime if interrupt Rst 6 is triggered, 0 if no trigger
+uint16_t Rst6Simul_Delay(struct WavIn_Struct* In, uint64_t EnabledCpuTime)
 {
 	uint16_t Delay ;
-	if (EnabledCpuTime > (Rst6Period_Delay + Rst6_LastCpuTime))
+	if (EnabledCpuTime > (Rst6Period_Delay + In->Rst6_LastCpuTime))
 	{
-		if (Rst6_NextDelayIsShort)
+		if (In->Rst6_NextDelayIsShort)
 		{
-			Rst6_NextDelayIsShort = false;
+			In->Rst6_NextDelayIsShort = false;
 			Delay = (Rst6A_Clock_Delay);
 		}
 		else
 		{
-			Rst6_NextDelayIsShort = true;
+			In->Rst6_NextDelayIsShort = true;
 			Delay = (Rst6B_Clock_Delay);
 		}
-		Rst6_LastCpuTime = EnabledCpuTime;
+		In->Rst6_LastCpuTime = EnabledCpuTime;
 		#if(WavIn_Display_Interrupt==1)
-			printf("Rst6____________________,CpuT=%06d,SplI=%06d,EnabledT=%06d,AddedTime=%04d \n", (uint32_t)Glob_CpuTime, (uint32_t)(Glob_CpuTime * CurrentWavIn.Head.SampleRate / CpuFq),(uint32_t)Rst6_LastCpuTime, Delay);
+			printf("Rst6____________________,CpuT=%06d,SplI=%06d,EnabledT=%06d,AddedTime=%04d \n", (uint32_t)In->CpuTime, (uint32_t)(In->CpuTime * In->Wav.Head.SampleRate / CpuFq),(uint32_t)In->Rst6_LastCpuTime, Delay);
 		#endif
 		return (Delay);
 	}
@@ -275,16 +271,15 @@ uint16_t Rst6Simul_Delay(uint64_t EnabledCpuTime, uint16_t EnabledPeriod)
 //-------------------------------------------------------------------------
 // Rst7Simul_Delay 
 //-------------------------------------------------------------------------
-// Input :	EnabledCpuTime, time at which interrupts have been enabled
-//			EnabledPeriod, delay after EnabledCpuTime during which interrupts remain enabled
-// Output : Delay to be added to Glob_CpuTime if interrupt Rst 7 is triggered, 0 if no trigger
-uint16_t Rst7Simul_Delay(uint64_t EnabledCpuTime, uint16_t EnabledPeriod)
+// Input :	EnabledCpuTime, time at which interrupts have been enabled, a pending interrupt is triggered then
+// Output : Delay to be added to In->CpuTime if interrupt Rst 7 is triggered, 0 if no trigger
+uint16_t Rst7Simul_Delay(struct WavIn_Struct* In, uint64_t EnabledCpuTime)
 {
-	if (EnabledCpuTime > (Rst7Period_Delay + Rst7_LastCpuTime))
+	if (EnabledCpuTime > (Rst7Period_Delay + In->Rst7_LastCpuTime))
 	{
-		Rst7_LastCpuTime = EnabledCpuTime;
+		In->Rst7_LastCpuTime = EnabledCpuTime;
 		#if(WavIn_Display_Interrupt==1)
-		printf("Rst7____________________,CpuT=%06d,SplI=%06d,EnabledT=%06d,AddedTime=%04d \n", (uint32_t)Glob_CpuTime, (uint32_t)(Glob_CpuTime * CurrentWavIn.Head.SampleRate / CpuFq), (uint32_t)Rst6_LastCpuTime, Rst7_Clock_Delay);
+		printf("Rst7____________________,CpuT=%06d,SplI=%06d,EnabledT=%06d,AddedTime=%04d \n", (uint32_t)In->CpuTime, (uint32_t)(In->CpuTime * In->Wav.Head.SampleRate / CpuFq), (uint32_t)In->Rst6_LastCpuTime, Rst7_Clock_Delay);
 #endif
 		return (Rst7_Clock_Delay);
 	}
@@ -297,8 +292,8 @@ uint16_t Rst7Simul_Delay(uint64_t EnabledCpuTime, uint16_t EnabledPeriod)
 // Read samples until start of Sync Byte
 // ReadLeader + Sync Bit
 // No interrupt (keyboard scan / cursor blink) is modelized
-// Resets Glob_CpuTime to the beigining of the first High level found after low level
-int16_t ReadLeader(void)
+// Resets In->CpuTime to the beigining of the first High level found after low level
+int16_t ReadLeader(struct WavIn_Struct* In)
 {
 	#define HighLevelLoopsEstimation 0x28 // Number of High level loopson ReadLeader entry, set in firmware  
 
@@ -309,33 +304,34 @@ int16_t ReadLeader(void)
 	uint8_t PulseNToSync ;
 	bool OutOfMargin;
 #if(WavIn_Display_Debug!=0)
-	LoopHOld_Debug=0;
+	In->LoopHOld_Debug=0;
 #endif
 
 	TriggerLow = TTLNormInLevels[0] ;
 	TriggerHigh = TTLNormInLevels[1] ;
-	LoopH = HighLevelLoopsEstimation;
+	In->LoopH = HighLevelLoopsEstimation;
 	InterDelay = 0 ; 
 
 FwDai_RDL05: // 0xD488, See DAI Firmware labels 
 	FirstHigh_Time = 0;
 #if(WavIn_Display_Debug!=0)
-	LoopHOld_Debug = LoopHOld;
+	In->LoopHOld_Debug = In->LoopHOld;
 #endif
-	LoopHOld = LoopH;
+	In->LoopHOld = In->LoopH;
 	InterDelay += 7;
 //FwDai_RDL10: // 0xD48A
 	InterDelay += 19; // 19 from start of RDL05 to first K7 Read (included)
 	// Interrupt may add cycles to blink cursor or check keyboard (ex: Rst7_Clock_Delay, Rst6A_Clock_Delay, Rst6B_Clock_Delay)
 #if(WavIn_Display_Debug==2) // For debug
-	if (LoopH == HighLevelLoopsEstimation)
+	if (In->LoopH == HighLevelLoopsEstimation)
 	{ printf("Leader___Start_FirstRead,"); }
 	else 
 	{ printf("Leader_Restart_FirstRead,"); }
 	printf("CpuT=%06d,SplI=%06d,Loop_1=%04d,Loop_0=%04d \n", 
-		(uint32_t)Glob_CpuTime, (uint32_t)(Glob_CpuTime * CurrentWavIn.Head.SampleRate / CpuFq), LoopHOld_Debug, LoopH);
+		(uint32_t)In->CpuTime, (uint32_t)(In->CpuTime * In->Wav.Head.SampleRate / CpuFq), In->LoopHOld_Debug, In->LoopH);
 #endif
-	LoopH = LevelChangeLoops(TriggerLow, InterDelay, 29, false, true); if (LoopH < 0) return (LoopH);
+	In->LoopH = LevelChangeLoops(In, TriggerLow, InterDelay, 29, false, true); if (In->LoopH < 0) return (In->LoopH);
+	In->IntEnabledEnd = In->CpuTime; // Interrupts are disabled from here
 	InterDelay = 22; // After First low read to RDL30
 	PulseNToSync = LeaderMinHighLevelsForSync ;
 	OutOfMargin = false;
@@ -343,8 +339,8 @@ FwDai_RDL05: // 0xD488, See DAI Firmware labels
 FwDai_RDL30: // 0xD494
 	// Wait for High (DCR E) -> Low length
 	InterDelay += 33; // From start of RDL30 to first Ora M included
-	LoopL = LevelChangeLoops(TriggerHigh, InterDelay, TailsCyclesPerLoop, true, false); if (LoopL < 0) return (LoopL);
-	if (LoopL >= 255)
+	In->LoopL = LevelChangeLoops(In, TriggerHigh, InterDelay, TailsCyclesPerLoop, true, false); if (In->LoopL < 0) return (In->LoopL);
+	if (In->LoopL >= 255)
 	{
 		InterDelay = 25; // If restart 
 		goto FwDai_RDL05; // This is not fully comparable to firmware
@@ -352,20 +348,20 @@ FwDai_RDL30: // 0xD494
 	InterDelay = 17; // After First High to RDL50
 //FwDai_RDL50: // 0xD4A1
 	InterDelay += 22;  // From start of RDL50 to first Ana M included
-	if (FirstHigh_Time == 0) { FirstHigh_Time = Glob_CpuTime; }
+	if (FirstHigh_Time == 0) { FirstHigh_Time = In->CpuTime; }
 	// Wait for Low (INR B) -> High length
-	LoopH = LevelChangeLoops(TriggerLow, InterDelay, TailsCyclesPerLoop, true,false); if (LoopH < 0) return (LoopH);
-	if (LoopH >= 255)
+	In->LoopH = LevelChangeLoops(In, TriggerLow, InterDelay, TailsCyclesPerLoop, true,false); if (In->LoopH < 0) return (In->LoopH);
+	if (In->LoopH >= 255)
 	{
 		InterDelay = 25; // If restart 
 		goto FwDai_RDL05; // This is not fully comparable to firmware
 	}
-	InterDelay = 72 + (LoopHOld > LoopH ? 9 : 0);  // From last read (excluded) to End of test included (0xD4B8) 
-	// Margin criteria makes sens only when LoopH >= 16
-	// Depending of CPU / WAV synchonisation, LoopH varies from 16 to 20, observed delta up to 3 for Mame created 44k1 waves
+	InterDelay = 72 + (In->LoopHOld > In->LoopH ? 9 : 0);  // From last read (excluded) to End of test included (0xD4B8) 
+	// Margin criteria makes sens only when In->LoopH >= 16
+	// Depending of CPU / WAV synchonisation, In->LoopH varies from 16 to 20, observed delta up to 3 for Mame created 44k1 waves
 
 	OutOfMargin = false;
-	if (abs(LoopH - LoopHOld) > ((LoopHOld & 0xF0) >> 3)) // RDL60, 0xD4B0
+	if (abs(In->LoopH - In->LoopHOld) > ((In->LoopHOld & 0xF0) >> 3)) // RDL60, 0xD4B0
 	{
 		OutOfMargin = true;
 	}
@@ -379,31 +375,31 @@ FwDai_RDL30: // 0xD494
 	if (PulseNToSync != 0)
 	{
 		InterDelay += 15; 
-		goto FwDai_RDL30; // Delay between K7 read: 120 + (LoopHOld < LoopH ? 9 : 0)
+		goto FwDai_RDL30; // Delay between K7 read: 120 + (In->LoopHOld < In->LoopH ? 9 : 0)
 	}
 
 	PulseNToSync++;
 	InterDelay += 30;
-	goto FwDai_RDL30;  // Delay between K7 read: 135 + (LoopHOld < LoopH ? 9 : 0)
+	goto FwDai_RDL30;  // Delay between K7 read: 135 + (In->LoopHOld < In->LoopH ? 9 : 0)
 
 FwDai_RDL70: // 0xD4C3, If out of margin: 
 	PulseNToSync--;
 	if (PulseNToSync != 0)
 	{
-		InterDelay += 15; // Delay between K7 read: 113 + (LoopHOld < LoopH ? 9 : 0)
+		InterDelay += 15; // Delay between K7 read: 113 + (In->LoopHOld < In->LoopH ? 9 : 0)
 		goto FwDai_RDL05;
 	}
 
 	// Wait high, FwDai_RDL80, test xD4C8
-	InterDelay += 26; // Delay between K7 read: 98 + (LoopHOld < LoopH ? 9 : 0)
-	LoopL = LevelChangeLoops(TriggerHigh, InterDelay, 17, false, false); if (LoopL < 0) return (LoopL);
+	InterDelay += 26; // Delay between K7 read: 98 + (In->LoopHOld < In->LoopH ? 9 : 0)
+	In->LoopL = LevelChangeLoops(In, TriggerHigh, InterDelay, 17, false, false); if (In->LoopL < 0) return (In->LoopL);
 	InterDelay = 17; // Delay between K7 read: 17
 	// Wait low, FwDai_RDL90, test xD4CC
-	LoopH = LevelChangeLoops(TriggerLow, InterDelay, 17, false, false); if (LoopH < 0) return (LoopH);
+	In->LoopH = LevelChangeLoops(In, TriggerLow, InterDelay, 17, false, false); if (In->LoopH < 0) return (In->LoopH);
 	// Delay to next K7Read, InterDelay = 175 
 #if(WavIn_Display_Debug > 1) // For debug
 	printf("Leader___SyncBit Exit___,"); 
-	printf("CpuT=%06d,SplI=%06d,Loop_1=%04d,Loop_0=%04d,", (uint32_t)Glob_CpuTime, (uint32_t)(Glob_CpuTime * CurrentWavIn.Head.SampleRate / CpuFq), LoopH, LoopHOld_Debug);
+	printf("CpuT=%06d,SplI=%06d,Loop_1=%04d,Loop_0=%04d,", (uint32_t)In->CpuTime, (uint32_t)(In->CpuTime * In->Wav.Head.SampleRate / CpuFq), In->LoopH, In->LoopHOld_Debug);
 #endif
 	return (0);
 }
@@ -413,75 +409,73 @@ FwDai_RDL70: // 0xD4C3, If out of margin:
 // ReadDaiCore 
 //-------------------------------------------------------------------------
 // Read all information to a bin structure excluding Leader and Trailer & Sync Byte
-// Input: WavOutFile and global variables 
+// Input: WavOutFile and global variables, BlocksCount first blocks are read (DataBlock_Count for a whole program)
 // Output : 0 or negative error code
-int16_t ReadDaiCore(void)
+int16_t ReadDaiCore(struct WavIn_Struct* In, uint8_t BlocksCount)
 {
 	uint16_t DataI;
 	uint8_t DataCS;
 	int16_t DaiByte;
-	int16_t NErr = 0;
 
-	Glob_PosInFile = PosInFile_ProgByte; 
-	DaiByte = ReadDaiByte();
-	Glob_BinByteI_Debug = 0; // Starts at 0
+	In->PosInFile = PosInFile_ProgByte; 
+	DaiByte = ReadDaiByte(In);
+	In->BinByteI_Debug = 0; // Starts at 0
 	if (DaiByte < 0) { return (DaiByte); }
-	Glob_ProgType = (uint8_t) DaiByte;
-	if (Glob_ProgType>0x32) { return (-WavInProgTypeErr); }
+	In->ProgType = (uint8_t) DaiByte;
+	if (In->ProgType>0x32) { return (-WavInProgTypeErr); }
 
-	for (Glob_BlockI = 0; Glob_BlockI < DataBlock_Count; Glob_BlockI++)
+	for (In->BlockI = 0; In->BlockI < BlocksCount; In->BlockI++)
 	{
-		Glob_PosInFile = PosInFile_InBlock;
+		In->PosInFile = PosInFile_InBlock;
 
 		// Read Len and checksum of len
-		Glob_PosInBlock = PosInBlock_LenH;
-		DaiByte = ReadDaiByte(); if (DaiByte < 0) { return (-WavInBlockLenErr); }
-		DaiBlocksInfo[Glob_BlockI].Len = DaiByte<<8;
-		Glob_PosInBlock = PosInBlock_LenL;
-		DaiByte = ReadDaiByte(); if (DaiByte < 0) { return (-WavInBlockLenErr); }
-		DaiBlocksInfo[Glob_BlockI].Len += DaiByte ;
-		if (DaiBlocksInfo[Glob_BlockI].Len>0xFFFF) { return (-WavInBlockLenErr); }
-		Glob_PosInBlock = PosInBlock_LenCS;
-		DaiByte = ReadDaiByte(); if (DaiByte < 0) { return (-WavInBlockLenCSErr); }
-		DaiBlocksInfo[Glob_BlockI].LenCS = (uint8_t) DaiByte;
+		In->PosInBlock = PosInBlock_LenH;
+		DaiByte = ReadDaiByte(In); if (DaiByte < 0) { return (-WavInBlockLenErr); }
+		In->Blocks[In->BlockI].Len = DaiByte<<8;
+		In->PosInBlock = PosInBlock_LenL;
+		DaiByte = ReadDaiByte(In); if (DaiByte < 0) { return (-WavInBlockLenErr); }
+		In->Blocks[In->BlockI].Len += DaiByte ;
+		In->PosInBlock = PosInBlock_LenCS;
+		DaiByte = ReadDaiByte(In); if (DaiByte < 0) { return (-WavInBlockLenCSErr); }
+		In->Blocks[In->BlockI].LenCS = (uint8_t) DaiByte;
 
 		// Len Checksum
-		if(DaiBlocksInfo[Glob_BlockI].LenCS!=DaiWordCheckSum(DaiBlocksInfo[Glob_BlockI].Len)) { return (-WavInBlockLenCSErr); }
-		Glob_PosInBlock = PosInBlock_InData;
+		if(In->Blocks[In->BlockI].LenCS!=DaiWordCheckSum(In->Blocks[In->BlockI].Len)) { return (-WavInBlockLenCSErr); }
+		In->PosInBlock = PosInBlock_InData;
 
 		// Create Block arrays
-		DaiBlocksInfo[Glob_BlockI].Block = (char*)calloc(DaiBlocksInfo[Glob_BlockI].Len, 1);
-		if (DaiBlocksInfo[Glob_BlockI].Block == NULL)  return (-WavInCallocErr);
+		In->Blocks[In->BlockI].Block = (char*)calloc(In->Blocks[In->BlockI].Len, 1);
+		if (In->Blocks[In->BlockI].Block == NULL)  return (-WavInCallocErr);
 		DataCS = 0x56;
 		// Read data part of block
-		for (DataI = 0; DataI < DaiBlocksInfo[Glob_BlockI].Len; DataI++)
+		for (DataI = 0; DataI < In->Blocks[In->BlockI].Len; DataI++)
 		{
 			if (DataI > 0)
 			{
-				Glob_PosInBlock = PosInBlock_InData;
+				In->PosInBlock = PosInBlock_InData;
 			}
 			else
-				if (DataI == (DaiBlocksInfo[Glob_BlockI].Len - 1))
+				if (DataI == (In->Blocks[In->BlockI].Len - 1))
 				{
-					Glob_PosInBlock = PosInBlock_LastByte;
+					In->PosInBlock = PosInBlock_LastByte;
 				}
-			DaiByte = ReadDaiByte(); if (DaiByte < 0) { return (-WavReadBlockErr); }
-			DaiBlocksInfo[Glob_BlockI].Block[DataI] = (uint8_t) DaiByte;
+			DaiByte = ReadDaiByte(In); if (DaiByte < 0) { return (-WavReadBlockErr); }
+			In->Blocks[In->BlockI].Block[DataI] = (uint8_t) DaiByte;
 			DataCS = DaiByteCheckSum((uint8_t) DaiByte, DataCS);
 		}
 
-		if (Glob_BlockI == 0)
+		if (In->BlockI == 0)
 		{
-			Glob_PosInFile = PosInFile_BlockCS0;
+			In->PosInFile = PosInFile_BlockCS0;
 		}
 		else
 		{
-			Glob_PosInFile = PosInFile_BlockCSN;
+			In->PosInFile = PosInFile_BlockCSN;
 		}
-		DaiByte = ReadDaiByte(); if (DaiByte < 0) { return (-WavInBlockCSErr); }
-		DaiBlocksInfo[Glob_BlockI].BlockCS = (uint8_t) DaiByte;
+		DaiByte = ReadDaiByte(In); if (DaiByte < 0) { return (-WavInBlockCSErr); }
+		In->Blocks[In->BlockI].BlockCS = (uint8_t) DaiByte;
 		// Block Checksum
-		if (DataCS != DaiBlocksInfo[Glob_BlockI].BlockCS) { return (-WavInBlockCSErr); }
+		if (DataCS != In->Blocks[In->BlockI].BlockCS) { return (-WavInBlockCSErr); }
 	}
 	return(0);
 }
@@ -493,16 +487,24 @@ int16_t ReadDaiCore(void)
 // Convert a byte in wave samples
 // Input:
 // - Byte to write as a DaiBit
-int16_t ReadDaiByte(void)
+int16_t ReadDaiByte(struct WavIn_Struct* In)
 {
 	uint8_t BitMask ;
 	int16_t DaiBit ;
 	int16_t DataByte ;
+	uint64_t BitStart ;
+	uint64_t P0Delays[8] ; // Delays from previous DaiBit end to P0 end, for calibration
+	uint8_t BitValues[8] ; // Previous and current DaiBit values (bits 1 and 0), which change P0 delays
+	uint8_t BitI = 0 ;
 
 	DataByte = 0 ;
 	for (BitMask = 0x80; BitMask != 0; BitMask = BitMask >> 1)
 	{
-		DaiBit = ReadDaiBit(Glob_InterK7ReadDelay); 
+		BitStart = In->CpuTime;
+		DaiBit = ReadDaiBit(In, In->InterK7ReadDelay); 
+		P0Delays[BitI] = In->P0End - BitStart;
+		BitValues[BitI++] = (uint8_t)((In->LastDaiBit << 1) | (DaiBit > 0));
+		In->LastDaiBit = (DaiBit > 0);
 		if (DaiBit > 0)
 		{
 			DataByte += BitMask;
@@ -512,21 +514,25 @@ int16_t ReadDaiByte(void)
 			return (DaiBit);
 		}
 		// Delay between reading bits, if not last bit
-		Glob_InterK7ReadDelay = ExitDaiBit_Delay + InterDaitBits_Delay + EnterDaiBit_Delay;
+		In->InterK7ReadDelay = ExitDaiBit_Delay + InterDaitBits_Delay + EnterDaiBit_Delay;
 	}
 
-	// Calculate Glob_InterK7ReadDelay : delays between last read Sample and next one for writing next byte
-	if (Glob_PosInFile != PosInFile_InBlock) // First one to use it is Glob_PosInFile == PosInFile_SyncByte
+	if (WavIn_Calib) { WavCalib_AddByte(In->CalibKey, P0Delays, BitValues); }
+
+	// Calculate In->InterK7ReadDelay : delays between last read Sample and next one for writing next byte
+	if (In->PosInFile != PosInFile_InBlock) // First one to use it is In->PosInFile == PosInFile_SyncByte
 	{	// Delay between bytes when not in Block
-		Glob_InterK7ReadDelay = ExitDaiBit_Delay + EnterDaiBit_Delay + OutBkInterCallsDelays[Glob_ProgType - 0x30][Glob_PosInFile];
-		Glob_InterK7ReadDelay += OutBkInterCallsDelaysMargin[Glob_PosInFile];
+		In->InterK7ReadDelay = ExitDaiBit_Delay + EnterDaiBit_Delay + Glob_OutBkInterCallsDelays[In->ProgType - 0x30][In->PosInFile];
+		In->InterK7ReadDelay += OutBkInterCallsDelaysMargin[In->PosInFile];
+		In->CalibKey = WavCalib_OutBkKey(In->ProgType - 0x30, In->PosInFile);
 	}
 	else
 	{	// Delay between trying to read last sample of a byte and 1st sample of a byte
-		Glob_InterK7ReadDelay = ExitDaiBit_Delay + InBkInterCallsDelays[Glob_BlockI][Glob_PosInBlock] + EnterDaiBit_Delay;
-		Glob_InterK7ReadDelay += InBkInterCallsDelaysMargin[Glob_PosInBlock];
+		In->InterK7ReadDelay = ExitDaiBit_Delay + Glob_InBkInterCallsDelays[In->BlockI][In->PosInBlock] + EnterDaiBit_Delay;
+		In->InterK7ReadDelay += InBkInterCallsDelaysMargin[In->PosInBlock];
+		In->CalibKey = WavCalib_InBkKey(In->BlockI, In->PosInBlock);
 	}
-	Glob_BinByteI_Debug += 1;
+	In->BinByteI_Debug += 1;
 	return (DataByte);
 }
 
@@ -536,7 +542,7 @@ int16_t ReadDaiByte(void)
 //-------------------------------------------------------------------------
 // Convert a DaiBit, which has 4 periods from 0 to 3, into a bit
 // Output DaiBit level (0=Low, 1=High) or -1 if error or -2 end of file
-int16_t ReadDaiBit(uint16_t InterCallsK7ReadDelay)
+int16_t ReadDaiBit(struct WavIn_Struct* In, uint16_t InterCallsK7ReadDelay)
 {
 	uint8_t DaiBitPeriod;
 	uint16_t RequiredPeriodMinDelay;
@@ -551,48 +557,84 @@ int16_t ReadDaiBit(uint16_t InterCallsK7ReadDelay)
 		LoopDelay = DaiBitCyclesPerLoop[DaiBitPeriod];
 		RequiredPeriodMinDelay = ((DaiBitPeriod == 0) ? InterCallsK7ReadDelay : LoopDelay) + (DaiBitPeriod == 2 ? 10 : 0);
 		ExpectedTtlTrigger = TTLNormInLevels[1-(DaiBitPeriod & 0x01)] ;
-		LoopsN[DaiBitPeriod] = LevelChangeLoops(ExpectedTtlTrigger, RequiredPeriodMinDelay, LoopDelay, true, false);
+		LoopsN[DaiBitPeriod] = LevelChangeLoops(In, ExpectedTtlTrigger, RequiredPeriodMinDelay, LoopDelay, true, false);
 		if (LoopsN[DaiBitPeriod] < 0)
 		{
 			return (LoopsN[DaiBitPeriod]);
 		}
+		if (DaiBitPeriod == 0) { In->P0End = In->CpuTime; }
 	}
 	if (LoopsN[1] > LoopsN[3])
 	{
+		if (LoopsN[1] - LoopsN[3] - 1 < In->BitMargin) { In->BitMargin = LoopsN[1] - LoopsN[3] - 1; }
 		return (1);
 	}
+	if (LoopsN[3] - LoopsN[1] < In->BitMargin) { In->BitMargin = LoopsN[3] - LoopsN[1]; }
 	return (0);
 }
 
 
+//-------------------------------------------------------------------------
+// WavIn_Init
+//-------------------------------------------------------------------------
+// New decoder session, samples are then set by DgvWavIn or WavIn_SetMemory
+void WavIn_Init(struct WavIn_Struct* In)
+{
+	memset(In, 0, sizeof(*In));
+	In->InterruptSimul = AllowInterruptSimul;
+	In->BitMargin = INT16_MAX;
+	In->CalibKey = WavCalib_NoKey;
+}
+
+
 //-------------------------------------------------------------------------
 // DgvWavIn
 //-------------------------------------------------------------------------
 // Main function to read wav file 
+// A csw file (see WavCsw) is read as 1 byte mono samples, levels of its pulses
+// Program read is the program in memory on exit
 int16_t DgvWavIn(char* FileName, bool WavInParity)
 {
+	struct WavIn_Struct Session;
+	struct WavIn_Struct* In = &Session;
 	int16_t NErr;
 	int16_t SyncByte = 0;
-	int16_t DaiByte = 0;
 	uint16_t CpuTimeStart = 0 ;
+#if(WavIn_Display_Debug == 3)
 	uint32_t SampleIOnByteSyncStart_Debug = 0 ;
+#endif
 
-	WavIn_InvertSignal = WavInParity;
+	WavIn_Init(In);
+	In->InvertSignal = WavInParity;
+	In->Pulses = IsSameStringEnd(FileName, WavCsw_Ext);
 
-	ReadWavHeader(FileName, &CurrentWavIn);
-	WavInPosOffset = CurrentWavIn.DataPos + CurrentWavIn.SampleLen * (WavInChannel); // At Glob_CpuTime, WavInPos = End of Wav Header
-	WavInPosMax = CurrentWavIn.DataPos + (CurrentWavIn.SamplesPerChannel) * CurrentWavIn.Head.BlockAlign - CurrentWavIn.SampleLen; // Last begining of last sample
+	if (In->Pulses)
+	{
+		NErr = WavCsw_Read(FileName, &In->Csw);
+		if (NErr < 0) { goto ExitDgvWavIn; }
+		In->Wav.Head.SampleRate = In->Csw.SampleRate;
+		In->Wav.Head.BlockAlign = 1;
+		In->Wav.SampleLen = 1;
+		In->PosOffset = 0;
+		In->PosMax = In->Csw.PulseEnd[In->Csw.PulsesCount - 1] - 1; // Last sample
+	}
+	else
+	{
+		ReadWavHeader(FileName, &In->Wav);
+		In->PosOffset = In->Wav.DataPos + In->Wav.SampleLen * (WavInChannel); // At In->CpuTime, WavInPos = End of Wav Header
+		In->PosMax = In->Wav.DataPos + (In->Wav.SamplesPerChannel) * In->Wav.Head.BlockAlign - In->Wav.SampleLen; // Last begining of last sample
+	}
 
 
-	if (CurrentWavIn.SampleLen > 2)
+	if (In->Wav.SampleLen > 2)
 	{
 		NErr = WavInHeaderErr;
 		goto ExitDgvWavIn;
 	}
 
 	// Reopen file
-	WavInFile = fopen(FileName, "rb");
-	if (WavInFile == NULL)
+	if (!In->Pulses) { In->File = fopen(FileName, "rb"); }
+	if ((In->File == NULL) && (!In->Pulses))
 	{
 		printf("Could not open %s \nPress Enter to exit\n", FileName);
 		NErr = WavInHeaderErr;
@@ -604,26 +646,29 @@ int16_t DgvWavIn(char* FileName, bool WavInParity)
 	{
 		// Real Leader, Sync Bit, Sync Byte
 		SyncByte = 0; // For debug
-		Glob_CpuTime = CpuTimeStartOffset + CpuTimeStart; 
-		Glob_BinByteI_Debug = 0;
-		Rst6_LastCpuTime = Init_Rst6_CpuTime; 
-		Rst6_NextDelayIsShort = false; 
-		Rst7_LastCpuTime = Init_Rst7_CpuTime; 	
+		In->CpuTime = CpuTimeStartOffset + CpuTimeStart; 
+		In->BinByteI_Debug = 0;
+		In->Rst6_LastCpuTime = Init_Rst6_CpuTime; 
+		In->Rst6_NextDelayIsShort = false; 
+		In->Rst7_LastCpuTime = Init_Rst7_CpuTime; 	
 
 	SearchSyncByte:
-		ClearDaiBinInfos();
-		Glob_PosInFile = PosInFile_Leader;
-		Glob_ProgType = 0x30; // Necessary to get Glob_InterK7ReadDelay at the end of PosInFile_SyncByte
-		NErr = ReadLeader(); 
+		memset(In->Blocks, 0, sizeof(In->Blocks));
+		In->PosInFile = PosInFile_Leader;
+		In->ProgType = 0x30; // Necessary to get In->InterK7ReadDelay at the end of PosInFile_SyncByte
+		In->CalibKey = WavCalib_NoKey; // Sync byte follows the sync bit
+		NErr = ReadLeader(In); 
 		if (NErr < 0) 
 		{	
 			goto ExitDgvWavIn;
 		}
 
-		Glob_InterK7ReadDelay = SyncBitExit_Delay + SyncBitDaiBit_Delay + EnterDaiBit_Delay;
-		Glob_PosInFile = PosInFile_SyncByte;
-		SampleIOnByteSyncStart_Debug = (uint32_t)((Glob_CpuTime + Glob_InterK7ReadDelay) * CurrentWavIn.Head.SampleRate / CpuFq) ;
-		SyncByte = ReadDaiByte(); // Result should be 0x55
+		In->InterK7ReadDelay = SyncBitExit_Delay + SyncBitDaiBit_Delay + EnterDaiBit_Delay;
+		In->PosInFile = PosInFile_SyncByte;
+#if(WavIn_Display_Debug == 3)
+		SampleIOnByteSyncStart_Debug = (uint32_t)((In->CpuTime + In->InterK7ReadDelay) * In->Wav.Head.SampleRate / CpuFq) ;
+#endif
+		SyncByte = ReadDaiByte(In); // Result should be 0x55
 #if(WavIn_Display_Debug > 1) // For debug
 		printf("SyncByte=%04d\n", SyncByte);
 #endif
@@ -635,7 +680,7 @@ int16_t DgvWavIn(char* FileName, bool WavInParity)
 		if (SyncByte != 0x55) // Due saved files
 		{ 
 			#if(RestartIfInvalidSyncByte) // This is the case in firmware
-				Glob_CpuTime +=  InterruptSimul_Delay(367); // Delay due to calling Disable sound interrupt and restart of Read Leader
+				In->CpuTime +=  InterruptSimul_Delay(In, 367); // Delay due to calling Disable sound interrupt and restart of Read Leader
 				goto SearchSyncByte;
 			#else
 				NErr = -WavInSyncTypeErr;
@@ -643,23 +688,181 @@ int16_t DgvWavIn(char* FileName, bool WavInParity)
 			goto ExitDgvWavIn;
 		}
 
-		for (Glob_BlockI = 0; Glob_BlockI < DataBlock_Count; Glob_BlockI++)
+		for (In->BlockI = 0; In->BlockI < DataBlock_Count; In->BlockI++)
 		{
-			DaiBlocksInfo[Glob_BlockI].Block = NULL;
+			In->Blocks[In->BlockI].Block = NULL;
 		}
 
 		// Read Program / Variables information, starting by Type byte
-		NErr = ReadDaiCore();
+		NErr = ReadDaiCore(In, DataBlock_Count);
 	ExitDgvWavIn:
 #if(WavIn_Display_Debug == 3)
-		printf("CpuTimeStart=%03d, Err=%04d, CpuTExit=%06d, SByteSyncStart=%04d, SyncByte=%03d\n", CpuTimeStart, NErr, (uint32_t)Glob_CpuTime, SampleIOnByteSyncStart_Debug, SyncByte);
+		printf("CpuTimeStart=%03d, Err=%04d, CpuTExit=%06d, SByteSyncStart=%04d, SyncByte=%03d\n", CpuTimeStart, NErr, (uint32_t)In->CpuTime, SampleIOnByteSyncStart_Debug, SyncByte);
 		printf("===============================================================================\n");
 		printf("\n");
 #endif
 		NErr = NErr;
 	}
 
-	if (WavInFile != NULL) { fclose(WavInFile); }
+	if (In->File != NULL) { fclose(In->File); }
+	In->File = NULL;
+	if (In->Pulses) { WavCsw_Free(&In->Csw); }
+	memcpy(DaiBlocksInfo, In->Blocks, sizeof(In->Blocks));
+	Glob_ProgType = In->ProgType;
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavIn_SetMemory
+//-------------------------------------------------------------------------
+// Samples of the session are read from memory (no header) instead of In->File
+void WavIn_SetMemory(struct WavIn_Struct* In, const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format)
+{
+	In->Wav.Head.SampleRate = Format->SamplingFq;
+	In->Wav.Head.BlockAlign = Format->NChannels * Format->Bytes_per_sample;
+	In->Wav.SampleLen = Format->Bytes_per_sample;
+	In->PosOffset = In->Wav.SampleLen * (Format->NChannels > WavInChannel ? WavInChannel : 0);
+	In->PosMax = Len - In->Wav.Head.BlockAlign + In->PosOffset; // Last begining of last sample
+	In->InvertSignal = (Format->InvertSignal != 0);
+	In->Memory = Samples;
+	In->Pulses = false;
+}
+
+
+//-------------------------------------------------------------------------
+// WavIn_ReadFromMemory
+//-------------------------------------------------------------------------
+// Read a program from samples in memory (no header), as in DgvWavIn, up to the end of the BlocksCount first blocks
+// and compare it with the program in memory
+// Used to check timings before writing a wav (see WavOut_ReadBack). Program in memory and encoder state are unchanged
+// Output : 0 if the same program is read, negative error otherwise
+int16_t WavIn_ReadFromMemory(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, uint8_t BlocksCount)
+{
+	struct WavInTrial_Struct Trial;
+
+	memset(&Trial, 0, sizeof(Trial));
+	Trial.Interrupts = AllowInterruptSimul;
+	Trial.Rst6Delay = Init_Rst6_CpuTime + Rst6Period_Delay; // Same first interrupts as DgvWavIn
+	Trial.Rst7Delay = Init_Rst7_CpuTime + Rst7Period_Delay;
+	return (WavIn_ReadProgram(Samples, Len, Format, &Trial, BlocksCount));
+}
+
+
+//-------------------------------------------------------------------------
+// WavIn_TrialFromMemory
+//-------------------------------------------------------------------------
+// Read a whole program from samples in memory (no header) in the conditions of Trial, and compare it with the program in memory
+// Used to validate a wav file (see WavValid). Program in memory and encoder state are unchanged
+// Output : 0 if the same program is read, negative error otherwise. Trial->BitMargin
+int16_t WavIn_TrialFromMemory(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, struct WavInTrial_Struct* Trial)
+{
+	return (WavIn_ReadProgram(Samples, Len, Format, Trial, DataBlock_Count));
+}
+
+
+//-------------------------------------------------------------------------
+// WavIn_ReadProgram
+//-------------------------------------------------------------------------
+// See WavIn_ReadFromMemory and WavIn_TrialFromMemory
+int16_t WavIn_ReadProgram(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, struct WavInTrial_Struct* Trial, uint8_t BlocksCount)
+{
+	struct WavIn_Struct Session;
+	struct WavIn_Struct* In = &Session;
+	int16_t NErr;
+	int16_t SyncByte;
+	uint8_t BkI;
+
+	WavIn_Init(In);
+	WavIn_SetMemory(In, Samples, Len, Format);
+	In->Wav.Head.SampleRate = (uint32_t)((int64_t)Format->SamplingFq * (1000000 + Trial->SpeedPpm) / 1000000);
+	In->InterruptSimul = Trial->Interrupts;
+	In->Noise = Trial->Noise;
+	In->NoiseState = Trial->Seed | 1;
+
+	// Interrupts are triggered once their period has elapsed since Rst6_LastCpuTime / Rst7_LastCpuTime
+	In->CpuTime = (uint64_t)Trial->EntryDelay + CpuTimeStartOffset;
+	In->Rst6_LastCpuTime = (uint64_t)Trial->EntryDelay + Trial->Rst6Delay - Rst6Period_Delay;
+	In->Rst6_NextDelayIsShort = false;
+	In->Rst7_LastCpuTime = (uint64_t)Trial->EntryDelay + Trial->Rst7Delay - Rst7Period_Delay;
+	In->PosInFile = PosInFile_Leader;
+	In->ProgType = 0x30; // Necessary to get In->InterK7ReadDelay at the end of PosInFile_SyncByte
+	NErr = ReadLeader(In); if (NErr < 0) { goto ReadMemoryExit; }
+
+	In->InterK7ReadDelay = SyncBitExit_Delay + SyncBitDaiBit_Delay + EnterDaiBit_Delay;
+	In->PosInFile = PosInFile_SyncByte;
+	SyncByte = ReadDaiByte(In);
+	if (SyncByte != 0x55) { NErr = -WavInSyncTypeErr; goto ReadMemoryExit; }
+	NErr = ReadDaiCore(In, BlocksCount); if (NErr < 0) { goto ReadMemoryExit; }
+
+	// Compared with the program in memory
+	if (In->ProgType != Glob_ProgType) { NErr = -WavInProgTypeErr; goto ReadMemoryExit; }
+	for (BkI = 0; BkI < BlocksCount; BkI++)
+	{
+		if ((In->Blocks[BkI].Len != DaiBlocksInfo[BkI].Len) || (In->Blocks[BkI].BlockCS != DaiBlocksInfo[BkI].BlockCS) ||
+			(memcmp(In->Blocks[BkI].Block, DaiBlocksInfo[BkI].Block, DaiBlocksInfo[BkI].Len) != 0))
+		{
+			NErr = -WavReadBlockErr; goto ReadMemoryExit;
+		}
+	}
+
+ReadMemoryExit:
+	for (BkI = 0; BkI < DataBlock_Count; BkI++)
+	{
+		if (In->Blocks[BkI].Block != NULL) { free(In->Blocks[BkI].Block); }
+	}
+	Trial->BitMargin = In->BitMargin;
 	return (NErr);
 }
 
+
+//-------------------------------------------------------------------------
+// WavIn_NoiseSample
+//-------------------------------------------------------------------------
+// Output : uniform noise in [-In->Noise, In->Noise]
+int16_t WavIn_NoiseSample(struct WavIn_Struct* In)
+{
+	In->NoiseState ^= In->NoiseState << 13;
+	In->NoiseState ^= In->NoiseState >> 17;
+	In->NoiseState ^= In->NoiseState << 5;
+	return ((int16_t)(In->NoiseState % (2 * In->Noise + 1)) - In->Noise);
+}
+
+
+//-------------------------------------------------------------------------
+// WavIn_SyncFromMemory
+//-------------------------------------------------------------------------
+// Read Leader, SyncBit and Sync Byte from samples in memory (no header), as in DgvWavIn
+// ReadLeader is entered Sync->EntryDelay Cpu cycles after first sample, interrupts are simulated if Sync->Interrupts
+// Used to find the shortest leader and where interrupts can land (see WavOut_LeaderSchedule)
+// Output : 0 if Sync Byte 0x55 is read, negative error otherwise. Sync->IntEnabledEnd
+int16_t WavIn_SyncFromMemory(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, struct WavInSync_Struct* Sync)
+{
+	struct WavIn_Struct Session;
+	struct WavIn_Struct* In = &Session;
+	int16_t NErr;
+	int16_t SyncByte;
+
+	WavIn_Init(In);
+	WavIn_SetMemory(In, Samples, Len, Format);
+	In->InterruptSimul = Sync->Interrupts;
+
+	// Interrupts are triggered once their period has elapsed since Rst6_LastCpuTime / Rst7_LastCpuTime
+	In->CpuTime = (uint64_t)Sync->EntryDelay + CpuTimeStartOffset;
+	In->Rst6_LastCpuTime = (uint64_t)Sync->EntryDelay + Sync->Rst6Delay - Rst6Period_Delay;
+	In->Rst6_NextDelayIsShort = false;
+	In->Rst7_LastCpuTime = (uint64_t)Sync->EntryDelay + Sync->Rst7Delay - Rst7Period_Delay;
+	In->PosInFile = PosInFile_Leader;
+	In->ProgType = 0x30; // Necessary to get In->InterK7ReadDelay at the end of PosInFile_SyncByte
+
+	NErr = ReadLeader(In);
+	if (NErr >= 0)
+	{
+		In->InterK7ReadDelay = SyncBitExit_Delay + SyncBitDaiBit_Delay + EnterDaiBit_Delay;
+		In->PosInFile = PosInFile_SyncByte;
+		SyncByte = ReadDaiByte(In);
+		NErr = (SyncByte == 0x55 ? 0 : -WavInSyncTypeErr);
+	}
+	Sync->IntEnabledEnd = (uint32_t)In->IntEnabledEnd; // CpuTime 0 is first sample
+	return (NErr);
+}
@@ -23,6 +23,9 @@
 #ifndef WAVIN_H
 #define WAVIN_H
 #include <stdint.h> 
+#include "WavIO.h"
+#include "FilesIO.h"
+#include "WavCsw.h"
 
 
 //-------------------------------------------------------------------------
@@ -30,14 +33,92 @@
 //-------------------------------------------------------------------------
 // User choices
 #define WavInChannel 0 // Selected channel in a stereo signal (0 or 1) 
-static int16_t TTLNormInLevels[2] = {55,200}  ; // Normalized TTL levels leading to trigger Logic change
+static const int16_t TTLNormInLevels[2] = {55,200}  ; // Normalized TTL levels leading to trigger Logic change
+
+//---------------
+// WavIn_Struct, decoder session : firmware model state and program read, passed to all reading functions
+// Sessions are independent, several of them can run at the same time (see WavIn_Init)
+//---------------
+struct WavIn_Struct
+{
+	// Samples
+	FILE* File;
+	struct Wav_Struct Wav;
+	uint32_t PosOffset;
+	uint32_t PosMax;
+	bool InvertSignal; // Inverted for a real Dai
+	const uint8_t* Memory; // Samples are read from memory instead of File when not NULL (see WavIn_SetMemory)
+	struct WavCsw_Struct Csw; // Pulses of a csw file
+	bool Pulses; // Samples are the levels of Csw pulses instead of File ones (see DgvWavIn)
+	uint8_t Noise; // Maximum noise added to each normalized sample (see WavIn_TrialFromMemory)
+	uint32_t NoiseState; // Noise generator (xorshift)
+
+	// Firmware model
+	uint64_t CpuTime;
+	int16_t LoopL;
+	int16_t LoopH;
+	int16_t LoopHOld;
+	int16_t LoopHOld_Debug;
+	bool InterruptSimul;
+	uint64_t IntEnabledEnd; // CpuTime at end of last wait with interrupts enabled
+	uint64_t Rst6_LastCpuTime; // Triggered every 16ms, 0xD578 via RST 6
+	bool Rst6_NextDelayIsShort; // Rst6 delay is alternatively short or long
+	uint64_t Rst7_LastCpuTime; // Triggered every 20ms by TV page blanking signal, 0xD9A9 via RST 7 (clock interrupt)
+	int16_t BitMargin; // Minimum K7 read loops a DaiBit could lose before being misread, since last reset
+	int16_t CalibKey; // Calibration key of the delay before next byte
+	uint64_t P0End; // CpuTime at end of period 0 of last DaiBit
+	uint8_t LastDaiBit; // Value of last DaiBit read
+	uint32_t BinByteI_Debug;
+
+	// Position and program read
+	int8_t PosInFile;
+	int8_t PosInBlock;
+	int8_t BlockI;
+	uint16_t InterK7ReadDelay; // Delay in CpuCycles between return and call of ReadDaiBit, including Enter & Exit delays
+	uint8_t ProgType;
+	struct DaiBlock_Struct Blocks[DataBlock_Count];
+};
+
+//---------------
+// WavInSync_Struct, firmware model run on samples in memory (see WavIn_SyncFromMemory)
+//---------------
+#define WavInSync_NoRst 0xFFFFFFFF // Rst6Delay / Rst7Delay value for an interrupt not triggered
+struct WavInSync_Struct
+{
+	uint32_t EntryDelay; // Cpu cycles from first sample to ReadLeader entry
+	bool Interrupts; // Simulate RST 6 / RST 7 interrupts while they are enabled
+	uint32_t Rst6Delay; // Cpu cycles from entry to first RST 6, or WavInSync_NoRst
+	uint32_t Rst7Delay; // Cpu cycles from entry to first RST 7, or WavInSync_NoRst
+	uint32_t IntEnabledEnd; // Output : Cpu cycles from first sample to end of last wait with interrupts enabled (ReadLeader RDL10)
+};
+
+//---------------
+// WavInTrial_Struct, conditions of a whole program read from samples in memory (see WavIn_TrialFromMemory)
+//---------------
+struct WavInTrial_Struct
+{
+	uint32_t EntryDelay; // Cpu cycles from first sample to ReadLeader entry
+	bool Interrupts; // Simulate RST 6 / RST 7 interrupts while they are enabled
+	uint32_t Rst6Delay; // Cpu cycles from entry to first RST 6
+	uint32_t Rst7Delay; // Cpu cycles from entry to first RST 7
+	uint8_t Noise; // Maximum noise added to each sample, on the 0-255 scale of TTLNormInLevels
+	int32_t SpeedPpm; // Playing speed error (ppm), > 0 when played faster
+	uint32_t Seed; // Noise generator seed
+	int16_t BitMargin; // Output : minimum K7 read loops a DaiBit could lose before being misread
+};
 
 
 //-------------------------------------------------------------------------
 // Global functions 
 //-------------------------------------------------------------------------
 
+void WavIn_Init(struct WavIn_Struct* In);
 int16_t DgvWavIn(char* FileName, bool WavInParity);
+int16_t WavIn_ReadFromMemory(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, uint8_t BlocksCount);
+int16_t WavIn_TrialFromMemory(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, struct WavInTrial_Struct* Trial);
+int16_t WavIn_SyncFromMemory(const uint8_t* Samples, uint32_t Len, const struct WavFormat_Struct* Format, struct WavInSync_Struct* Sync);
+
+extern thread_local bool WavIn_Calib;
 
 
 
@@ -0,0 +1,372 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavList.cpp
+***********************************************************************************/
+// Join several programs in one wav file (see WavList.h)
+// Programs are read once by the main thread, their timing passes are done concurrently (one thread per program,
+// as many at once as cores), edges lists are then concatenated and rendered as a single program
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <thread>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavOut.h"
+#include "WavRaster.h"
+#include "WavTune.h"
+#include "WavTurbo.h"
+#include "WavList.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+struct WavListProgram_Struct
+{
+	struct DaiBlock_Struct Blocks[DataBlock_Count];
+	uint8_t ProgType;
+	char Name[MaxLenString + 1]; // Dai file name without extension, title in cue sheet
+};
+
+struct WavListRun_Struct // Encoder configuration, copied by each program thread
+{
+	struct WavOutConfig_Struct Config;
+	uint16_t PauseDaiBits;
+};
+
+struct WavListJob_Struct
+{
+	const struct WavListRun_Struct* Run;
+	const struct WavListProgram_Struct* Program;
+	struct DaiHardware_Struct Profile; // Tuned for the program ('T' option)
+	bool First; // First program of the playlist
+	struct DaiBitShape_Struct* Shapes; // Output : edges list of the program, owned by the job
+	uint16_t ShapesCount;
+	uint16_t* Bits;
+	uint32_t BitsCount;
+	int16_t NErr; // Output : 0 or negative error
+};
+
+
+//-------------------------------------------------------------------------
+// Local variables
+//-------------------------------------------------------------------------
+// Set by main thread only
+struct WavListProgram_Struct WavList_Programs[WavList_ProgramsMax];
+uint8_t WavList_Count;
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+int16_t WavList_Jobs(struct WavListJob_Struct* Jobs, uint8_t NJobs);
+void WavList_Program(struct WavListJob_Struct* Job);
+int16_t WavList_WriteCue(const struct WavRaster_Struct* Raster, const struct DaiEdges_Struct* Edges, const uint32_t* StartBits);
+void WavList_Clear(void);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// WavList_Add 
+//-------------------------------------------------------------------------
+// Read a .dai file and add it at the end of the playlist
+// Output : 0 or negative error
+int16_t WavList_Add(char* DaiFileName)
+{
+	struct WavListProgram_Struct* Program;
+	uint8_t BkI;
+	int16_t NErr;
+
+	if (WavList_Count >= WavList_ProgramsMax) { return (-FileParamErr); }
+	Program = &WavList_Programs[WavList_Count];
+	NErr = ReadDaiFile(DaiFileName); if (NErr < 0) { return (NErr); }
+	memcpy(Program->Blocks, DaiBlocksInfo, sizeof(Program->Blocks));
+	Program->ProgType = Glob_ProgType;
+	for (BkI = 0; BkI < DataBlock_Count; BkI++) { DaiBlocksInfo[BkI].Block = NULL; } // Owned by the playlist
+	strcpy(Program->Name, DaiFileName);
+	if (strrchr(Program->Name, '.') != NULL) { *strrchr(Program->Name, '.') = '\0'; }
+	WavList_Count++;
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// DgvWavList 
+//-------------------------------------------------------------------------
+// Write all programs of the playlist in one wav file per raster, with its cue sheet. Playlist is cleared
+// Output : 0 or first negative error
+int16_t DgvWavList(struct WavRaster_Struct* Rasters, uint8_t NRasters)
+{
+	struct WavListRun_Struct Run;
+	struct WavListJob_Struct Jobs[WavList_ProgramsMax];
+	struct DaiEdges_Struct Edges;
+	struct DaiBitShape_Struct* Shapes = NULL;
+	const struct DaiHardware_Struct* Profile = WavOut_Profile;
+	uint32_t StartBits[WavList_ProgramsMax + 1];
+	uint32_t TailDaiBitDelay = 0;
+	uint32_t BitI;
+	uint16_t ShapesCount = 0;
+	uint8_t JobI;
+	uint8_t RasterI;
+	uint8_t Px;
+	uint8_t BkI;
+	int16_t NErr = 0;
+
+	memset(&Edges, 0, sizeof(Edges));
+	if (WavList_Count == 0) { return (0); }
+	for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+	{
+		TailDaiBitDelay += WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType_Leader][Px] * TailsCyclesPerLoop;
+	}
+	WavOut_GetConfig(&Run.Config);
+	Run.Config.TuneMargin = WavOut_TuneOff; // Programs are tuned by the main thread
+	Run.PauseDaiBits = (uint16_t)((uint64_t)WavList_Pause_ms * CpuFq / 1000 / TailDaiBitDelay);
+
+	// Profile of each program, tuned by the main thread one program after the other
+	for (JobI = 0; JobI < WavList_Count; JobI++)
+	{
+		Jobs[JobI].Run = &Run;
+		Jobs[JobI].Program = &WavList_Programs[JobI];
+		Jobs[JobI].First = (JobI == 0);
+		Jobs[JobI].Shapes = NULL;
+		Jobs[JobI].Bits = NULL;
+		Jobs[JobI].BitsCount = 0;
+		if ((WavOut_TuneMargin != WavOut_TuneOff) && (NErr >= 0))
+		{
+			memcpy(DaiBlocksInfo, WavList_Programs[JobI].Blocks, sizeof(DaiBlocksInfo));
+			Glob_ProgType = WavList_Programs[JobI].ProgType;
+			NErr = DgvWavTune(WavOut_TuneMargin);
+			for (BkI = 0; BkI < DataBlock_Count; BkI++) { DaiBlocksInfo[BkI].Block = NULL; }
+		}
+		Jobs[JobI].Profile = *WavOut_Profile;
+		if (WavOut_Profile != Profile) { SetWavOutProfile(Profile); }
+	}
+	if (NErr < 0) { goto ListExit; }
+
+	NErr = WavList_Jobs(Jobs, WavList_Count);
+	for (JobI = 0; JobI < WavList_Count; JobI++)
+	{
+		if ((NErr >= 0) && (Jobs[JobI].NErr < 0))
+		{
+			fprintf(stderr, "Error %d while writing %s in playlist\n", Jobs[JobI].NErr, WavList_Programs[JobI].Name);
+			NErr = Jobs[JobI].NErr;
+		}
+		Edges.BitsCount += Jobs[JobI].BitsCount;
+		if ((uint32_t)ShapesCount + Jobs[JobI].ShapesCount > UINT16_MAX) { NErr = -MemAllocErr; }
+		ShapesCount += Jobs[JobI].ShapesCount;
+	}
+	if (NErr < 0) { goto ListExit; }
+
+	// Edges lists are concatenated, shapes of each program follow the ones of previous programs
+	Shapes = (struct DaiBitShape_Struct*)malloc(((size_t)ShapesCount + 1) * sizeof(struct DaiBitShape_Struct));
+	Edges.Bits = (uint16_t*)malloc(((size_t)Edges.BitsCount + 1) * sizeof(uint16_t));
+	if ((Shapes == NULL) || (Edges.Bits == NULL)) { NErr = -MemAllocErr; goto ListExit; }
+	Edges.Shapes = Shapes;
+	Edges.BitsMax = Edges.BitsCount;
+	Edges.BitsCount = 0;
+	for (JobI = 0; JobI < WavList_Count; JobI++)
+	{
+		memcpy(Shapes + Edges.ShapesCount, Jobs[JobI].Shapes, Jobs[JobI].ShapesCount * sizeof(struct DaiBitShape_Struct));
+		StartBits[JobI] = Edges.BitsCount;
+		for (BitI = 0; BitI < Jobs[JobI].BitsCount; BitI++)
+		{
+			Edges.Bits[Edges.BitsCount++] = Jobs[JobI].Bits[BitI] + Edges.ShapesCount;
+		}
+		Edges.ShapesCount += Jobs[JobI].ShapesCount;
+	}
+	StartBits[WavList_Count] = Edges.BitsCount;
+
+	fprintf(stderr, "Playlist of %d programs\n", WavList_Count);
+	NErr = WavRaster_Render(Rasters, NRasters, &Edges);
+	for (RasterI = 0; RasterI < NRasters; RasterI++)
+	{
+		if ((Rasters[RasterI].NErr >= 0) && (strcmp(Rasters[RasterI].FileName, WavOut_StdoutName) != 0))
+		{
+			WavList_WriteCue(&Rasters[RasterI], &Edges, StartBits);
+		}
+	}
+
+ListExit:
+	for (JobI = 0; JobI < WavList_Count; JobI++)
+	{
+		free(Jobs[JobI].Shapes);
+		free(Jobs[JobI].Bits);
+	}
+	free(Shapes);
+	free(Edges.Bits);
+	WavList_Clear();
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavList_Jobs 
+//-------------------------------------------------------------------------
+// Timing pass of each program by its own thread, as many at once as cores
+// Output : 0 or negative error, result of each program is in Jobs[i].NErr
+int16_t WavList_Jobs(struct WavListJob_Struct* Jobs, uint8_t NJobs)
+{
+	std::thread* Threads[WavList_ProgramsMax];
+	uint32_t NThreads;
+	uint8_t First;
+	uint8_t JobI;
+	int16_t NErr = 0;
+
+	NThreads = std::thread::hardware_concurrency(); // 0 if unknown
+	if (NThreads < 1) { NThreads = 1; }
+	if (NThreads > WavList_ProgramsMax) { NThreads = WavList_ProgramsMax; }
+
+	// Program threads have their own encoder state, the caller one is unchanged
+	for (First = 0; First < NJobs; First += (uint8_t)NThreads)
+	{
+		for (JobI = First; (JobI < NJobs) && (JobI < First + NThreads); JobI++)
+		{
+			Threads[JobI] = NULL;
+			Jobs[JobI].NErr = -MemAllocErr;
+			try
+			{
+				Threads[JobI] = new std::thread(WavList_Program, &Jobs[JobI]);
+			}
+			catch (...)
+			{
+				NErr = -MemAllocErr;
+			}
+		}
+		for (JobI = First; (JobI < NJobs) && (JobI < First + NThreads); JobI++)
+		{
+			if (Threads[JobI] != NULL)
+			{
+				Threads[JobI]->join();
+				delete Threads[JobI];
+			}
+		}
+	}
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavList_Program 
+//-------------------------------------------------------------------------
+// Thread of a program: timing pass, edges list is moved to the job
+// Programs after the first one have the shortest leader (+ pause), checked with all formats
+void WavList_Program(struct WavListJob_Struct* Job)
+{
+	const struct WavListRun_Struct* Run = Job->Run;
+
+	memcpy(DaiBlocksInfo, Job->Program->Blocks, sizeof(DaiBlocksInfo));
+	Glob_ProgType = Job->Program->ProgType;
+	WavOut_SetConfig(&Run->Config);
+	SetWavOutProfile(&Job->Profile);
+	WavOut_MinLeader = ((Run->Config.MinLeader) || (!Job->First));
+	WavOut_LeaderExtraDaiBits = (Job->First ? 0 : Run->PauseDaiBits);
+
+	Job->NErr = (WavOut_Turbo ? WavTurbo_TimingPass() : WavOut_TimingPass());
+	if (Job->NErr >= 0)
+	{
+		Job->Shapes = (struct DaiBitShape_Struct*)malloc(((size_t)WavOut_Edges.ShapesCount + 1) * sizeof(struct DaiBitShape_Struct));
+		if (Job->Shapes == NULL) { Job->NErr = -MemAllocErr; }
+		else
+		{
+			memcpy(Job->Shapes, WavOut_Edges.Shapes, WavOut_Edges.ShapesCount * sizeof(struct DaiBitShape_Struct)); // Cache of this thread
+			Job->ShapesCount = WavOut_Edges.ShapesCount;
+			Job->Bits = WavOut_Edges.Bits;
+			Job->BitsCount = WavOut_Edges.BitsCount;
+			WavOut_Edges.Bits = NULL;
+		}
+	}
+	free(WavOut_Edges.Bits); // Edges of this thread, if not moved
+	memset(DaiBlocksInfo, 0, sizeof(DaiBlocksInfo)); // Blocks are owned by the playlist
+}
+
+
+//-------------------------------------------------------------------------
+// WavList_WriteCue 
+//-------------------------------------------------------------------------
+// Cue sheet of a rendered playlist wav, start time of each program (first DaiBit of its leader)
+// Output : 0 or negative error
+int16_t WavList_WriteCue(const struct WavRaster_Struct* Raster, const struct DaiEdges_Struct* Edges, const uint32_t* StartBits)
+{
+	char CueName[MaxLenString + 1];
+	const char* WavName;
+	const struct DaiBitShape_Struct* Shape;
+	double Seconds = 0;
+	uint32_t Frames;
+	uint32_t BitI = 0;
+	uint8_t JobI;
+	uint8_t Px;
+	FILE* File;
+
+	ChangeFileExt(".cue", Raster->FileName, CueName);
+	File = fopen(CueName, "w");
+	if (File == NULL) { return (-FileParamErr); }
+	WavName = strrchr(Raster->FileName, '\\');
+	if (WavName == NULL) { WavName = strrchr(Raster->FileName, '/'); }
+	WavName = (WavName == NULL ? Raster->FileName : WavName + 1);
+	fprintf(File, "REM Dgv playlist, %d programs\n", WavList_Count);
+	fprintf(File, "FILE \"%s\" WAVE\n", WavName);
+	for (JobI = 0; JobI < WavList_Count; JobI++)
+	{
+		// Time of the first sample of the program, periods are rounded up to samples
+		for (; BitI < StartBits[JobI]; BitI++)
+		{
+			Shape = &Edges->Shapes[Edges->Bits[BitI]];
+			for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+			{
+				Seconds += (double)WavRaster_SamplesMin(Shape->Cycles[Px], Raster->Format.SamplingFq) / Raster->Format.SamplingFq;
+			}
+		}
+		Frames = (uint32_t)(Seconds * 75); // 75 frames per second
+		fprintf(File, "  TRACK %02d AUDIO\n", JobI + 1);
+		fprintf(File, "    TITLE \"%s\"\n", WavList_Programs[JobI].Name);
+		fprintf(File, "    INDEX 01 %02lu:%02lu:%02lu\n", (unsigned long)(Frames / 75 / 60), (unsigned long)(Frames / 75 % 60), (unsigned long)(Frames % 75));
+	}
+	fclose(File);
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavList_Clear 
+//-------------------------------------------------------------------------
+void WavList_Clear(void)
+{
+	uint8_t ProgI;
+	uint8_t BkI;
+
+	for (ProgI = 0; ProgI < WavList_Count; ProgI++)
+	{
+		for (BkI = 0; BkI < DataBlock_Count; BkI++)
+		{
+			if (WavList_Programs[ProgI].Blocks[BkI].Block != NULL) { free(WavList_Programs[ProgI].Blocks[BkI].Block); }
+		}
+	}
+	WavList_Count = 0;
+}
@@ -0,0 +1,48 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVLIST_H
+#define WAVLIST_H
+#include <stdint.h> 
+#include "Const.h"
+#include "WavRaster.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Playlist ('J' option): all .dai files of the command are joined in one wav, in the order they are found
+// First program has the leader of the options, each next one the shortest leader read by the firmware model after
+// the trailer of the previous one ('L' option), plus WavList_Pause_ms for the user to enter the next LOAD command
+// A cue sheet with the start time of each program is written next to each wav file (.cue)
+#define WavList_ProgramsMax 32
+#define WavList_Pause_ms 3000 // Added to the leader of each program after the first one, time to type LOAD
+#define WavList_DefaultName "DgvPlaylist.wav" // Wav file name when output name is '*.wav'
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t WavList_Add(char* DaiFileName);
+int16_t DgvWavList(struct WavRaster_Struct* Rasters, uint8_t NRasters);
+
+#endif
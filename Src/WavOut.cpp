@@ -26,6 +26,11 @@
 #include "FilesIO.h"
 #include "DgvMain.h"
 #include "WavOut.h"
+#include "WavIn.h"
+#include "WavTune.h"
+#include "WavCalib.h"
+#include "WavGrid.h"
+#include "WavTurbo.h"
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
@@ -34,12 +39,43 @@
 #endif
 
 
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavOutCache_BitsMax 128 // Different DaiBits (DaiBitType x delay) in a file, about 20 in practice, 30 more per turbo payload
+#define WavOutCache_BytesMax 32 // Different byte contexts (speed x delay before first DaiBit) in a file
+#define WavOut_EdgesBitsInit 0x4000 // DaiBits allocated at once in WavOut_Edges, doubled when full
+
+struct WavOutCacheBit_Struct // Shape of the DaiBit is in WavOutCache_Shapes at the same index
+{
+	uint8_t DaiBitType; // DaiBitType_Count for a shape given by its cycles (see WriteShapeDaiBit)
+	uint16_t InterCallsK7ReadDelay; // 0 for Leader / Trailer
+	bool Tails; // Leader or Trailer, timing is approximative
+};
+
+struct WavOutCacheByte_Struct
+{
+	uint8_t DaiBitSpeed; // DaiBitType_LowFast or DaiBitType_LowNorm
+	uint16_t FirstK7ReadDelay; // Glob_InterK7ReadDelay before first DaiBit of the byte
+	int16_t BitI[2][2]; // Index in WavOutCache_Bits of DaiBits [First bit / Next bits][Bit value]
+};
+
+struct WavOutCacheKey_Struct // Parameters used to compute cached DaiBits
+{
+	uint8_t MinLoops[DaiBitType_Count][DaiBitPeriod_Count]; // Of WavOut_Profile, which may not be one of DaiHW_Profile[]
+	int16_t PeriodsOffset[DaiBitPeriod_Count];
+};
+
+
 //-------------------------------------------------------------------------
 // Global variables
 //-------------------------------------------------------------------------
-struct WavHeader_Struct WavOutHeader;
-struct WavSubchunk_Struct WavOutSubChunks[NChunkMax];
-char WavOut_NameOptions[OptionsLenMax + 2];
+thread_local struct WavFormat_Struct WavOut_Formats[WavOut_FormatsMax];
+thread_local uint8_t WavOut_FormatsCount;
+thread_local struct DaiEdges_Struct WavOut_Edges;
+thread_local const struct DaiHardware_Struct* WavOut_Profile = &DaiHW_Profile[DaiHW_Default];
+thread_local struct DaiHardware_Struct WavOut_ConfigProfile; // Profile installed by WavOut_SetConfig
+thread_local char WavOut_NameOptions[OptionsLenMax + 2];
 #define NumErri64 0x80000000 // Invalid value if error in conversion for a 
 
 //-------------------------------------------------------------------------
@@ -50,26 +86,56 @@ char WavOut_NameOptions[OptionsLenMax + 2];
 //---------------
 // Debug variables 
 // Time and Delays are in Cpu Cycles (not necessarily an integer)
-uint64_t Glob_Debug_K7ReadTime; // For debug only
-uint64_t Glob_Debug_K7ReadTime_FirstInByte; // For debug only, end of Last Read K7 instruction in first loop of Period0 
-uint64_t Glob_Debug_K7ReadTime_LastInByte; // For debug only, end of Last Read K7 instruction in first loop of Period0 
-uint64_t Glob_Debug_WrittenSamplesinByte;
+thread_local uint64_t Glob_Debug_K7ReadTime; // For debug only
+thread_local uint64_t Glob_Debug_K7ReadTime_FirstInByte; // For debug only, end of Last Read K7 instruction in first loop of Period0 
+thread_local uint64_t Glob_Debug_K7ReadTime_LastInByte; // For debug only, end of Last Read K7 instruction in first loop of Period0 
 
 // Margin variables to generate wav for a Physical DAI
-int16_t PeriodsOffset_Delay[DaiBitPeriod_Count];
-int16_t InBkInterCallsDelaysMargin[PosInBlock_Count];
-int16_t OutBkInterCallsDelaysMargin[PosInFile_Count];
+thread_local int16_t PeriodsOffset_Delay[DaiBitPeriod_Count];
+thread_local int16_t InBkInterCallsDelaysMargin[PosInBlock_Count];
+thread_local int16_t OutBkInterCallsDelaysMargin[PosInFile_Count];
 
 // Wav related variables
-FILE* WavOutFile;
-uint8_t WavOut_NChannels;
-uint8_t WavOut_Bytes_per_sample;
-uint8_t WavOut_InvertSignal;
-uint32_t WavOut_SamplingFq;
-uint16_t WavOut_LeaderDaiBits ;
-uint16_t WavOut_TrailerDaiBits ;
-uint32_t WavOut_SamplesCount; // Actual samples count written to Wav file
-uint16_t WavOut_SignalLevels[2][2]; // Samples levels definitions, WavOut_SignalLevels[LevelChange][TTLlevel]
+thread_local uint16_t WavOut_LeaderDaiBits ;
+thread_local uint16_t WavOut_TrailerDaiBits ;
+thread_local bool WavOut_MinLeader; // Shortest leader which syncs, instead of profile Leader_ms
+thread_local bool WavOut_IntSlack; // Slack for interrupts on first leader DaiBits
+thread_local bool WavOut_FastPos; // Fast DaiBits at every position read back by the firmware model ('Q' option)
+thread_local bool WavOut_PosSpeeds; // DaiBits speed from OutBkDaiBitSpeeds / InBkDaiBitSpeeds, o/w fast only in blocks 1 and 2
+thread_local int16_t WavOut_TuneMargin = WavOut_TuneOff; // Profile tuned for each program ('T' option)
+thread_local bool WavOut_LoadTuned; // Profile loaded from WavTune_FileName ('U' option)
+thread_local bool WavOut_LoadDelays; // Inter calls delays loaded from WavCalib_FileName ('D' option)
+thread_local bool WavOut_Grid; // One wav per margin variant of WavGrid_FileName ('G' option)
+thread_local bool WavOut_Playlist; // All programs joined in one wav ('J' option)
+thread_local bool WavOut_Turbo; // Binary program loaded by a turbo loader ('K' option)
+thread_local uint16_t WavOut_LeaderExtraDaiBits; // Added to the leader (pause between programs of a playlist, see WavList)
+
+//---------------
+// Leader schedule, kept while profile, options and formats are unchanged
+struct WavOutLeaderKey_Struct
+{
+	struct WavOutCacheKey_Struct Cache;
+	bool MinLeader;
+	bool IntSlack;
+	bool PosSpeeds;
+	bool LoadDelays;
+	uint8_t FormatsCount;
+	struct WavFormat_Struct Formats[WavOut_FormatsMax];
+};
+thread_local struct WavOutLeaderKey_Struct WavOutLeader_Key;
+thread_local uint16_t WavOutLeader_DaiBits; // 0 if not computed
+thread_local uint16_t WavOutLeader_SlackDaiBits;
+
+//---------------
+// DaiBits cache
+// Timing of a DaiBit only depends on the profile, its DaiBitType and the delay since the previous K7 read
+// Each different DaiBit is a shape of WavOut_Edges, rendered once per wav file. Cache is kept while WavOutCache_Key is unchanged
+thread_local struct WavOutCacheBit_Struct WavOutCache_Bits[WavOutCache_BitsMax];
+thread_local struct DaiBitShape_Struct WavOutCache_Shapes[WavOutCache_BitsMax];
+thread_local struct WavOutCacheByte_Struct WavOutCache_Bytes[WavOutCache_BytesMax];
+thread_local struct WavOutCacheKey_Struct WavOutCache_Key;
+thread_local uint16_t WavOutCache_BitsCount;
+thread_local uint16_t WavOutCache_BytesCount;
 
 
 //-------------------------------------------------------------------------
@@ -77,14 +143,28 @@ uint16_t WavOut_SignalLevels[2][2]; // Samples levels definitions, WavOut_Signal
 //-------------------------------------------------------------------------
 
 int16_t WriteDaiByte(uint8_t DataByte);
+uint8_t WavOut_ByteSpeed(void);
+void WavOut_NextByteDelay(void);
+int16_t WavOut_EstimateBytes(const uint8_t* Data, uint32_t Len, uint32_t* ShapeBits);
+uint64_t WavOut_EstimateSamples(const uint32_t* ShapeBits, uint32_t SamplingFq);
 int16_t WriteDaiBit(uint8_t DaiBitType, uint16_t InterCallsK7ReadDelay);
-uint16_t WavSamplesMin(uint16_t CyclesMin);
-int16_t WriteWavSamples(uint16_t Samples, uint8_t DaiBitPeriod);
-int16_t WavOutLevel(uint8_t DaiBitPeriod, uint16_t SampleI);
+int16_t WriteCachedDaiBit(int16_t BitI);
+void WavOutCache_Check(void);
+int16_t WavOutCache_GetBit(uint8_t DaiBitType, uint16_t InterCallsK7ReadDelay);
+int16_t WavOutCache_GetByte(uint8_t DaiBitSpeed, uint16_t FirstK7ReadDelay);
 uint16_t DaiBitLoopRelatedDelay(uint16_t DaiBitPeriod, uint16_t LoopCount);
-int16_t WriteDaiTails(void);
+int16_t WriteDaiTails(uint32_t Bit_Count, uint32_t SlackBit_Count);
+int16_t WriteDaiLeader(uint32_t LeaderDaiBits, uint32_t SlackDaiBits);
+int16_t WavOut_LeaderSchedule(uint16_t* LeaderDaiBits, uint16_t* SlackDaiBits);
+int16_t WavOut_LeaderTest(uint16_t LeaderDaiBits, uint16_t SlackDaiBits, uint32_t EntryMax, uint16_t EntryStep, uint32_t IntWindow,
+	bool* Synced, uint32_t* IntEnabledEnd);
+uint16_t WavOut_LeaderDaiBitAt(uint32_t CpuCycles);
+uint32_t WavOut_LeaderCycles(uint16_t LeaderDaiBits);
 int16_t WriteDaiCore(void);
+int16_t WriteDaiProgram(void);
+void WavOut_DefaultFormat(struct WavOutConfig_Struct* Config);
 int64_t GetFirstNumberInString(char* StringWithNum);
+uint32_t LoadFormatOptions(char* Options, struct WavFormat_Struct* Format);
 
 //=========================================================================
 // FUNCTIONS
@@ -96,14 +176,123 @@ int64_t GetFirstNumberInString(char* StringWithNum);
 // Parameters to be used DgvOut
 void SetWavOutParameters(uint16_t Hw)
 {
-	Glob_DaiHw = Hw ;
+	struct WavOutConfig_Struct Config;
+
+	WavOut_DefaultConfig(Hw, &Config);
+	WavOut_SetConfig(&Config);
+}
+
+//-------------------------------------------------------------------------
+// WavOut_DefaultConfig 
+//-------------------------------------------------------------------------
+// Configuration of profile Hw without options, encoder state is unchanged
+void WavOut_DefaultConfig(uint16_t Hw, struct WavOutConfig_Struct* Config)
+{
+	memset(Config, 0, sizeof(*Config));
+	Config->DaiHw = Hw;
+	Config->Profile = DaiHW_Profile[Hw];
+	WavOut_DefaultFormat(Config);
+	Config->TuneMargin = WavOut_TuneOff;
+	memcpy(Config->InBkInterCallsDelays, InBkInterCallsDelays, sizeof(Config->InBkInterCallsDelays));
+	memcpy(Config->OutBkInterCallsDelays, OutBkInterCallsDelays, sizeof(Config->OutBkInterCallsDelays));
+	WavOut_ConfigNameOptions(Config->NameOptions, Config, &Config->Formats[0]);
+}
+
+//-------------------------------------------------------------------------
+// WavOut_Config 
+//-------------------------------------------------------------------------
+// Configuration of profile Hw with Options (see WavOut_LoadOptions), encoder state is unchanged
+// Output : Config, option bits updated by Options
+uint32_t WavOut_Config(uint16_t Hw, char* Options, struct WavOutConfig_Struct* Config)
+{
+	uint32_t UpdatedOptionBits;
+
+	WavOut_DefaultConfig(Hw, Config);
+	UpdatedOptionBits = WavOut_LoadOptions(Options, Config);
+	WavOut_ConfigNameOptions(Config->NameOptions, Config, &Config->Formats[0]);
+	return (UpdatedOptionBits);
+}
+
+//-------------------------------------------------------------------------
+// WavOut_GetConfig 
+//-------------------------------------------------------------------------
+// Encoder configuration of the calling thread, profile in use is copied
+void WavOut_GetConfig(struct WavOutConfig_Struct* Config)
+{
+	Config->DaiHw = Glob_DaiHw;
+	Config->Profile = *WavOut_Profile;
+	memcpy(Config->Formats, WavOut_Formats, sizeof(Config->Formats));
+	Config->FormatsCount = WavOut_FormatsCount;
+	Config->MinLeader = WavOut_MinLeader;
+	Config->IntSlack = WavOut_IntSlack;
+	Config->FastPos = WavOut_FastPos;
+	Config->TuneMargin = WavOut_TuneMargin;
+	Config->LoadTuned = WavOut_LoadTuned;
+	Config->LoadDelays = WavOut_LoadDelays;
+	Config->Grid = WavOut_Grid;
+	Config->Playlist = WavOut_Playlist;
+	Config->Turbo = WavOut_Turbo;
+	memcpy(Config->InBkInterCallsDelays, Glob_InBkInterCallsDelays, sizeof(Config->InBkInterCallsDelays));
+	memcpy(Config->OutBkInterCallsDelays, Glob_OutBkInterCallsDelays, sizeof(Config->OutBkInterCallsDelays));
+	strcpy(Config->NameOptions, WavOut_NameOptions);
+}
+
+//-------------------------------------------------------------------------
+// WavOut_SetConfig 
+//-------------------------------------------------------------------------
+// Install a configuration in the encoder state of the calling thread, margins are the profile ones (see SetWavOutProfile)
+// Profile is copied in WavOut_ConfigProfile, Config does not need to stay valid
+void WavOut_SetConfig(const struct WavOutConfig_Struct* Config)
+{
+	Glob_DaiHw = Config->DaiHw;
+	WavOut_ConfigProfile = Config->Profile;
+	SetWavOutProfile(&WavOut_ConfigProfile);
+	memcpy(WavOut_Formats, Config->Formats, sizeof(WavOut_Formats));
+	WavOut_FormatsCount = Config->FormatsCount;
+	WavOut_MinLeader = Config->MinLeader;
+	WavOut_IntSlack = Config->IntSlack;
+	WavOut_FastPos = Config->FastPos;
+	WavOut_TuneMargin = Config->TuneMargin;
+	WavOut_LoadTuned = Config->LoadTuned;
+	WavOut_LoadDelays = Config->LoadDelays;
+	WavOut_Grid = Config->Grid;
+	WavOut_Playlist = Config->Playlist;
+	WavOut_Turbo = Config->Turbo;
+	memcpy(Glob_InBkInterCallsDelays, Config->InBkInterCallsDelays, sizeof(Glob_InBkInterCallsDelays));
+	memcpy(Glob_OutBkInterCallsDelays, Config->OutBkInterCallsDelays, sizeof(Glob_OutBkInterCallsDelays));
+	strcpy(WavOut_NameOptions, Config->NameOptions);
+}
+
+//-------------------------------------------------------------------------
+// WavOut_DefaultFormat 
+//-------------------------------------------------------------------------
+// Main wav format from the profile of Config, no additional format
+void WavOut_DefaultFormat(struct WavOutConfig_Struct* Config)
+{
+	Config->Formats[0].NChannels = Config->Profile.NChannels;
+	Config->Formats[0].Bytes_per_sample = Config->Profile.Bytes_per_sample;
+	Config->Formats[0].InvertSignal = Config->Profile.InvertSignal;
+	Config->Formats[0].SamplingFq = Config->Profile.SamplingFq;
+	Config->Formats[0].AutoRate = 0;
+	Config->Formats[0].EdgeShape = WavOutEdge_None;
+	Config->FormatsCount = 1;
+}
+
+//-------------------------------------------------------------------------
+// SetWavOutProfile 
+//-------------------------------------------------------------------------
+// Timing parameters of a profile, which may not be one of DaiHW_Profile[] (tuned or loaded one)
+// Wav formats and options are unchanged. Profile must stay valid while used
+void SetWavOutProfile(const struct DaiHardware_Struct* Profile)
+{
 	uint8_t Px;
 	uint32_t TailDaiBitDelay;
 
+	WavOut_Profile = Profile;
 	// Margin variables to generate wav for a Physical DAI
 	for (uint8_t PeriodI = 0; PeriodI < DaiBitPeriod_Count; PeriodI++)
 	{
-		PeriodsOffset_Delay[PeriodI] = DaiHW_Profile[Glob_DaiHw].PeriodsOffset_HwDelay[PeriodI];
+		PeriodsOffset_Delay[PeriodI] = WavOut_Profile->PeriodsOffset_HwDelay[PeriodI];
 	}
 	for (uint8_t PosInBk = 0; PosInBk < PosInBlock_Count; PosInBk++)
 	{
@@ -111,33 +300,17 @@ void SetWavOutParameters(uint16_t Hw)
 		OutBkInterCallsDelaysMargin[PosInBk] = 0; // Inter Calls related sections, must be High enough to add a Sample(21 at 96KHz)
 	}
 
-	WavOut_NChannels = DaiHW_Profile[Glob_DaiHw].NChannels;
-	WavOut_Bytes_per_sample = DaiHW_Profile[Glob_DaiHw].Bytes_per_sample;
-	WavOut_InvertSignal = DaiHW_Profile[Glob_DaiHw].InvertSignal;
-	WavOut_SamplingFq = DaiHW_Profile[Glob_DaiHw].SamplingFq;
-	WavOut_InvertSignal = DaiHW_Profile[Glob_DaiHw].InvertSignal;
 	TailDaiBitDelay = 0 ;
 	for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
 	{
-		TailDaiBitDelay += DaiHW_Profile[Glob_DaiHw].DaiBitPeriods_MinLoops[DaiBitType_Leader][Px]*TailsCyclesPerLoop;
+		TailDaiBitDelay += WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType_Leader][Px]*TailsCyclesPerLoop;
 	}
-	WavOut_LeaderDaiBits = (uint16_t) (DaiHW_Profile[Glob_DaiHw].Leader_ms * CpuFq / 1000 / TailDaiBitDelay) ;
+	WavOut_LeaderDaiBits = (uint16_t) (WavOut_Profile->Leader_ms * CpuFq / 1000 / TailDaiBitDelay) ;
 	for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
 	{
-		TailDaiBitDelay += DaiHW_Profile[Glob_DaiHw].DaiBitPeriods_MinLoops[DaiBitType_Trailer][Px] * TailsCyclesPerLoop;
-	}
-	WavOut_TrailerDaiBits = (uint16_t) (DaiHW_Profile[Glob_DaiHw].Trailer_ms * CpuFq / 1000 / TailDaiBitDelay + 1) ;
-
-	Update_WavOut_NameOptions (WavOut_NameOptions); 
-
-	// Levels to change depending of type of wav file (see WavOut_SignalLevels[2][2])
-	for (uint8_t Levels = 0; Levels < 2; Levels++)
-	{
-		for (uint8_t TTL = 0; TTL < 2; TTL++)
-		{
-			WavOut_SignalLevels[Levels][TTL] = (WavOut_Bytes_per_sample == 2 ? WavLevels_2B[Levels][TTL] : WavLevels_1B[Levels][TTL]);
-		}
+		TailDaiBitDelay += WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType_Trailer][Px] * TailsCyclesPerLoop;
 	}
+	WavOut_TrailerDaiBits = (uint16_t) (WavOut_Profile->Trailer_ms * CpuFq / 1000 / TailDaiBitDelay + 1) ;
 }
 
 //-------------------------------------------------------------------------
@@ -149,50 +322,81 @@ void SetWavOutParameters(uint16_t Hw)
 // - DaiBitType (global variables) - (fast or slow) x (High or low), see enum definition 
 //   Slow / Fast Daibits differs by the number of minimum loops when reading K7 (defined by DaiBitPeriod_MinLoops)
 // - Glob_InterK7ReadDelay (global variables) : delay between last K7 read (instruction end), and next instruction read (included) 
+// DaiBits of a byte are taken from the byte context in cache (speed, delay before first DaiBit)
 int16_t WriteDaiByte(uint8_t DataByte)
 {
 	uint8_t BitMask;
 	int16_t Err;
-	uint8_t DaiBitType;
+	int16_t ByteI;
+	uint8_t DaiBitSpeed;
+	uint8_t NextBit;
 
 	Glob_Debug_K7ReadTime_FirstInByte = Glob_Debug_K7ReadTime + Glob_InterK7ReadDelay ;
-	Glob_Debug_WrittenSamplesinByte = 0;
 
+	DaiBitSpeed = WavOut_ByteSpeed();
+	ByteI = WavOutCache_GetByte(DaiBitSpeed, Glob_InterK7ReadDelay); if (ByteI < 0) return (ByteI);
+
+	NextBit = 0; // First DaiBit uses Glob_InterK7ReadDelay
 	for (BitMask = 0x80; BitMask != 0; BitMask = BitMask >> 1)
 	{
-		if ((Glob_PosInFile > PosInFile_ProgByte)&&(Glob_BlockI > 0))
-		// Current byte is part of a block (excpet the last byte)
-		{
-			DaiBitType = DaiBitType_LowFast;
-		}
-		else 
-		// Normal bits
-		{
-			DaiBitType = DaiBitType_LowNorm;
-		}
-		DaiBitType += ((DataByte & BitMask) != 0); // Add 1 if bit is 1
-		Err = WriteDaiBit(DaiBitType,Glob_InterK7ReadDelay ); if (Err < 0) break;
+		Err = WriteCachedDaiBit(WavOutCache_Bytes[ByteI].BitI[NextBit][(DataByte & BitMask) != 0]); if (Err < 0) break;
+
+		// Delay between reading bits, if not last bit (ExitDaiBit_Delay + InterDaitBits_Delay + EnterDaiBit_Delay)
+		NextBit = 1;
+	}
+
+	WavOut_NextByteDelay();
+	Glob_Debug_K7ReadTime_LastInByte = Glob_Debug_K7ReadTime;
+#if(0) // For debug
+	// printf("b0s= %06d,b7e= %06d,D= %06d,B= x%02X \n", (uint32_t)Glob_Debug_K7ReadTime_FirstInByte, (uint32_t)Glob_Debug_K7ReadTime_LastInByte, (uint32_t)Glob_InterK7ReadDelay, DataByte);
+#endif
+	return(Err);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_ByteSpeed 
+//-------------------------------------------------------------------------
+// DaiBitType_LowFast or DaiBitType_LowNorm, speed of the DaiBits of a byte at current position
+uint8_t WavOut_ByteSpeed(void)
+{
+	uint8_t DaiBitSpeed;
 
-		// Delay between reading bits, if not last bit
-		Glob_InterK7ReadDelay = ExitDaiBit_Delay + InterDaitBits_Delay + EnterDaiBit_Delay;
+	if (WavOut_PosSpeeds)
+	// Speed of current position
+	{
+		DaiBitSpeed = (Glob_PosInFile == PosInFile_InBlock ? InBkDaiBitSpeeds[Glob_BlockI][Glob_PosInBlock] : OutBkDaiBitSpeeds[Glob_PosInFile]);
+	}
+	else if ((Glob_PosInFile > PosInFile_ProgByte)&&(Glob_BlockI > 0))
+	// Current byte is part of a block (excpet the last byte)
+	{
+		DaiBitSpeed = DaiBitType_LowFast;
+	}
+	else 
+	// Normal bits
+	{
+		DaiBitSpeed = DaiBitType_LowNorm;
 	}
+	return (DaiBitSpeed);
+}
 
-	// Calculate Glob_InterK7ReadDelay : delays between last read Sample and next one for writing next byte
+
+//-------------------------------------------------------------------------
+// WavOut_NextByteDelay 
+//-------------------------------------------------------------------------
+// Calculate Glob_InterK7ReadDelay : delays between last read Sample and next one for writing next byte
+void WavOut_NextByteDelay(void)
+{
 	if (Glob_PosInFile != PosInFile_InBlock)
 	{	// Delay between bytes when not in Block
-		Glob_InterK7ReadDelay = ExitDaiBit_Delay + EnterDaiBit_Delay + OutBkInterCallsDelays[Glob_ProgType-0x30][Glob_PosInFile];
+		Glob_InterK7ReadDelay = ExitDaiBit_Delay + EnterDaiBit_Delay + Glob_OutBkInterCallsDelays[Glob_ProgType-0x30][Glob_PosInFile];
 		Glob_InterK7ReadDelay += OutBkInterCallsDelaysMargin[Glob_PosInFile];
 	}
 	else
 	{	// Delay between trying to read last sample of a byte and 1st sample of a byte
-		Glob_InterK7ReadDelay = ExitDaiBit_Delay + InBkInterCallsDelays[Glob_BlockI][Glob_PosInBlock] + EnterDaiBit_Delay; 
+		Glob_InterK7ReadDelay = ExitDaiBit_Delay + Glob_InBkInterCallsDelays[Glob_BlockI][Glob_PosInBlock] + EnterDaiBit_Delay; 
 		Glob_InterK7ReadDelay += InBkInterCallsDelaysMargin[Glob_PosInBlock];
 	}
-	Glob_Debug_K7ReadTime_LastInByte = Glob_Debug_K7ReadTime;
-#if(0) // For debug
-	// printf("b0s= %06d,b7e= %06d,D= %06d,B= x%02X,S= %03d \n", (uint32_t)Glob_Debug_K7ReadTime_FirstInByte, (uint32_t)Glob_Debug_K7ReadTime_LastInByte, (uint32_t)Glob_InterK7ReadDelay, DataByte, (uint32_t)Glob_Debug_WrittenSamplesinByte);
-#endif
-	return(Err);
 }
 
 
@@ -201,19 +405,106 @@ int16_t WriteDaiByte(uint8_t DataByte)
 //-------------------------------------------------------------------------
 // Convert a DaiBit, which has 4 periods from 0 to 3, in wave samples
 int16_t WriteDaiBit(uint8_t DaiBitType, uint16_t InterCallsK7ReadDelay)
+{
+	int16_t BitI;
+
+	BitI = WavOutCache_GetBit(DaiBitType, InterCallsK7ReadDelay); if (BitI < 0) return (BitI);
+	return (WriteCachedDaiBit(BitI));
+}
+
+
+//-------------------------------------------------------------------------
+// WriteCachedDaiBit 
+//-------------------------------------------------------------------------
+// Append a DaiBit from cache to WavOut_Edges, samples are written later by rasterizers (see WavRaster)
+int16_t WriteCachedDaiBit(int16_t BitI)
+{
+	uint8_t DaiBitPeriod;
+	uint16_t* Bits;
+
+	for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+	{
+		Glob_Debug_K7ReadTime += WavOutCache_Shapes[BitI].Cycles[DaiBitPeriod];
+	}
+	if (WavOut_Edges.BitsCount >= WavOut_Edges.BitsMax)
+	{
+		Bits = (uint16_t*)realloc(WavOut_Edges.Bits, (WavOut_Edges.BitsMax ? 2 * WavOut_Edges.BitsMax : WavOut_EdgesBitsInit) * sizeof(uint16_t));
+		if (Bits == NULL) return (-MemAllocErr);
+		WavOut_Edges.Bits = Bits;
+		WavOut_Edges.BitsMax = (WavOut_Edges.BitsMax ? 2 * WavOut_Edges.BitsMax : WavOut_EdgesBitsInit);
+	}
+	WavOut_Edges.Bits[WavOut_Edges.BitsCount++] = (uint16_t)BitI;
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WriteShapeDaiBit 
+//-------------------------------------------------------------------------
+// Append a DaiBit of given periods cycles to WavOut_Edges, its shape is added to cache if not found (see WavTurbo)
+int16_t WriteShapeDaiBit(const uint16_t* Cycles)
+{
+	uint16_t BitI;
+	struct WavOutCacheBit_Struct* Bit;
+
+	for (BitI = 0; BitI < WavOutCache_BitsCount; BitI++)
+	{
+		if ((WavOutCache_Bits[BitI].DaiBitType == DaiBitType_Count) && (memcmp(WavOutCache_Shapes[BitI].Cycles, Cycles, sizeof(WavOutCache_Shapes[BitI].Cycles)) == 0)) break;
+	}
+	if (BitI == WavOutCache_BitsCount)
+	{
+		if (WavOutCache_BitsCount >= WavOutCache_BitsMax) return (-MemAllocErr);
+		Bit = &WavOutCache_Bits[WavOutCache_BitsCount];
+		Bit->DaiBitType = DaiBitType_Count;
+		Bit->InterCallsK7ReadDelay = 0;
+		Bit->Tails = false;
+		memcpy(WavOutCache_Shapes[BitI].Cycles, Cycles, sizeof(WavOutCache_Shapes[BitI].Cycles));
+		WavOutCache_BitsCount++;
+	}
+	WavOut_Edges.Shapes = WavOutCache_Shapes;
+	WavOut_Edges.ShapesCount = WavOutCache_BitsCount;
+	return (WriteCachedDaiBit(BitI));
+}
+
+
+//-------------------------------------------------------------------------
+// WavOutCache_GetBit 
+//-------------------------------------------------------------------------
+// Find a DaiBit in cache, add it with its shape if not found
+// Input : DaiBitType and InterCallsK7ReadDelay (ignored for Leader / Trailer), Glob_PosInFile
+// Output : index in WavOutCache_Bits or negative error
+int16_t WavOutCache_GetBit(uint8_t DaiBitType, uint16_t InterCallsK7ReadDelay)
 {
 	uint8_t DaiBitPeriod;
 	uint16_t RequiredPeriodMinDelay;
-	uint16_t NSamplesMin;
-	int16_t Err;
+	uint16_t BitI;
+	bool Tails;
+	struct WavOutCacheBit_Struct* Bit;
+
+	Tails = ((Glob_PosInFile == PosInFile_Leader) || (Glob_PosInFile == PosInFile_Trailer));
+	if ((Tails) && (DaiBitType == DaiBitType_SyncBit)) { InterCallsK7ReadDelay = 0; } // No slack before SyncBit
+
+	for (BitI = 0; BitI < WavOutCache_BitsCount; BitI++)
+	{
+		Bit = &WavOutCache_Bits[BitI];
+		if ((Bit->DaiBitType == DaiBitType) && (Bit->InterCallsK7ReadDelay == InterCallsK7ReadDelay) && (Bit->Tails == Tails))
+		{
+			return (BitI);
+		}
+	}
+	if (WavOutCache_BitsCount >= WavOutCache_BitsMax) return (-MemAllocErr);
 
+	Bit = &WavOutCache_Bits[WavOutCache_BitsCount];
+	Bit->DaiBitType = DaiBitType;
+	Bit->InterCallsK7ReadDelay = InterCallsK7ReadDelay;
+	Bit->Tails = Tails;
 	for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
 	{
 		// Loop related part. If Period0 and only 1 loop -> 0 because it is already included in InterCallsK7ReadDelay
 		// Add margin for analog wav. Not allowed for Leader or trailer
-		if ((Glob_PosInFile != PosInFile_Leader)&& (Glob_PosInFile != PosInFile_Trailer))
+		if (!Tails)
 		{
-			RequiredPeriodMinDelay = DaiBitLoopRelatedDelay(DaiBitPeriod, DaiHW_Profile[Glob_DaiHw].DaiBitPeriods_MinLoops[DaiBitType][DaiBitPeriod]);
+			RequiredPeriodMinDelay = DaiBitLoopRelatedDelay(DaiBitPeriod, WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType][DaiBitPeriod]);
 			RequiredPeriodMinDelay += PeriodsOffset_Delay[DaiBitPeriod];
 			if (DaiBitPeriod == 0)
 			{
@@ -222,107 +513,76 @@ int16_t WriteDaiBit(uint8_t DaiBitType, uint16_t InterCallsK7ReadDelay)
 		}
 		else
 		{
-			// Header / Trailer timing is approximative
-			RequiredPeriodMinDelay = TailsCyclesPerLoop * DaiHW_Profile[Glob_DaiHw].DaiBitPeriods_MinLoops[DaiBitType][DaiBitPeriod];
+			// Header / Trailer timing is approximative. InterCallsK7ReadDelay is the interrupt slack of leader ('R' option)
+			RequiredPeriodMinDelay = TailsCyclesPerLoop * WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType][DaiBitPeriod];
+			if (DaiBitPeriod == 0)
+			{
+				RequiredPeriodMinDelay += InterCallsK7ReadDelay;
+			}
 		}
 
 		// Cycle count should be exact
-		NSamplesMin = WavSamplesMin(RequiredPeriodMinDelay);
-#if(0) // For debug
-		if (Glob_BlockI == 1)
-		{
-			printf("K7T= %06d,bP= %02d,D= %04d,bT= %02d,NS= %02d\n", (uint32_t)Glob_Debug_K7ReadTime_FirstInByte, (uint8_t)DaiBitPeriod, (uint16_t)RequiredPeriodMinDelay, (uint8_t)DaiBitType, (uint8_t)NSamplesMin);
-		}
-#endif
-		Err = WriteWavSamples(NSamplesMin, DaiBitPeriod);
-
-		Glob_Debug_WrittenSamplesinByte += NSamplesMin;
-		Glob_Debug_K7ReadTime += RequiredPeriodMinDelay;
-		if (Err < 0) break;
+		WavOutCache_Shapes[WavOutCache_BitsCount].Cycles[DaiBitPeriod] = RequiredPeriodMinDelay;
 	}
-	return(Err);
+	return (WavOutCache_BitsCount++);
 }
 
 
 //-------------------------------------------------------------------------
-// WavSamplesMin
+// WavOutCache_GetByte 
 //-------------------------------------------------------------------------
-// Calculates how many Samples should be written to catch start of next DaiBitPeriod
-uint16_t WavSamplesMin(uint16_t CyclesMin)
+// Find the DaiBits used by a byte written in a given context, add them to cache if not found
+// Input : DaiBitSpeed, DaiBitType_LowFast or DaiBitType_LowNorm ; FirstK7ReadDelay, delay before first DaiBit
+// Output : index in WavOutCache_Bytes or negative error
+int16_t WavOutCache_GetByte(uint8_t DaiBitSpeed, uint16_t FirstK7ReadDelay)
 {
-	uint64_t Samples;
-	Samples = (CyclesMin * WavOut_SamplingFq) / CpuFq;
-	if (((Samples * CpuFq) != (CyclesMin * WavOut_SamplingFq))||(Samples==0))
-	{
-		Samples++ ;
-	}
-	return ((uint16_t) Samples);
-}
-
+	uint16_t ByteI;
+	uint8_t BitVal;
+	int16_t BitI;
+	struct WavOutCacheByte_Struct* Byte;
 
-//-------------------------------------------------------------------------
-// WriteWavSamples 
-//-------------------------------------------------------------------------
-// Adds a sample in the output files 
-int16_t WriteWavSamples(uint16_t Samples,uint8_t DaiBitPeriod)
-{
-	uint16_t Sample;
-	int16_t WavLevel;
-	uint8_t Ch;
-
-	for (Sample = 0; Sample < Samples; Sample++)
+	for (ByteI = 0; ByteI < WavOutCache_BytesCount; ByteI++)
 	{
-		WavLevel = WavOutLevel(DaiBitPeriod,Sample);
-		for (Ch=0;Ch< WavOut_NChannels;Ch++)
+		Byte = &WavOutCache_Bytes[ByteI];
+		if ((Byte->DaiBitSpeed == DaiBitSpeed) && (Byte->FirstK7ReadDelay == FirstK7ReadDelay))
 		{
-			if (fwrite(&WavLevel, WavOut_Bytes_per_sample, 1, WavOutFile) < 1)
-			{
-				return (-WavWriteErr);
-			}
-			WavOut_SamplesCount++;
+			return (ByteI);
 		}
 	}
-	return (0);
+	if (WavOutCache_BytesCount >= WavOutCache_BytesMax) return (-MemAllocErr);
+
+	Byte = &WavOutCache_Bytes[WavOutCache_BytesCount];
+	Byte->DaiBitSpeed = DaiBitSpeed;
+	Byte->FirstK7ReadDelay = FirstK7ReadDelay;
+	for (BitVal = 0; BitVal < 2; BitVal++)
+	{
+		BitI = WavOutCache_GetBit(DaiBitSpeed + BitVal, FirstK7ReadDelay); if (BitI < 0) return (BitI);
+		Byte->BitI[0][BitVal] = BitI;
+		BitI = WavOutCache_GetBit(DaiBitSpeed + BitVal, ExitDaiBit_Delay + InterDaitBits_Delay + EnterDaiBit_Delay); if (BitI < 0) return (BitI);
+		Byte->BitI[1][BitVal] = BitI;
+	}
+	return (WavOutCache_BytesCount++);
 }
 
 
 //-------------------------------------------------------------------------
-// WavLevel 
+// WavOutCache_Check 
 //-------------------------------------------------------------------------
-// Set Wav Level according to DaiBitPeriod and WavOut_SmoothSignal
-// Set WavOut_SmoothSignal to 0,to have a square signl
-// Set WavOut_SmoothSignal to 1, for a smoother analog signal (used for a physical DAI)
-int16_t WavOutLevel(uint8_t DaiBitPeriod,uint16_t SampleI)
+// Clear cache if any parameter used to compute DaiBits has changed since cache was filled
+// Wav format is not part of the key, shapes are in Cpu cycles
+void WavOutCache_Check(void)
 {
-	uint16_t Smoothed = 0;
-	uint8_t TTLIndex_Low;
-	uint8_t TTLIndex_High;
+	struct WavOutCacheKey_Struct Key;
 
-	if (WavOut_InvertSignal!=0)
-	{
-		TTLIndex_Low = 1;
-		TTLIndex_High = 0;
-	}
-	else
-	{
-		TTLIndex_Low = 0;
-		TTLIndex_High = 1;
-	}
+	memset(&Key, 0, sizeof(Key)); // Padding is compared too
+	memcpy(Key.MinLoops, WavOut_Profile->DaiBitPeriods_MinLoops, sizeof(Key.MinLoops));
+	memcpy(Key.PeriodsOffset, PeriodsOffset_Delay, sizeof(Key.PeriodsOffset));
 
-	#if(WavOut_SmoothSignal)
-		if (SampleI==0) Smoothed = 1; // 
-	#endif
-	if ((DaiBitPeriod == 0) || (DaiBitPeriod == 2))
-	{	
-		return (WavOut_SignalLevels[Smoothed][TTLIndex_Low]);
-	}
-	else if ((DaiBitPeriod == 1) || (DaiBitPeriod == 3) )
-	{
-		return (WavOut_SignalLevels[Smoothed][TTLIndex_High]);
-	}
-	else 
+	if (memcmp(&Key, &WavOutCache_Key, sizeof(Key)) != 0)
 	{
-		return (128);
+		WavOutCache_BitsCount = 0;
+		WavOutCache_BytesCount = 0;
+		WavOutCache_Key = Key;
 	}
 }
 
@@ -366,28 +626,26 @@ uint16_t DaiBitLoopRelatedDelay(uint16_t DaiBitPeriod, uint16_t LoopCount)
 //-------------------------------------------------------------------------
 // WriteBitTails : write Leader or Trailer
 //-------------------------------------------------------------------------
-// Write Leader (excluding SyncBit) or Trailer
-int16_t WriteDaiTails(void)
+// Write Leader (excluding SyncBit) or Trailer, Bit_Count DaiBits
+// First SlackBit_Count DaiBits have a TTL low period longer by WavOut_IntSlackDelay (see WavOut_LeaderSchedule)
+int16_t WriteDaiTails(uint32_t Bit_Count, uint32_t SlackBit_Count)
 {
 	uint32_t N ;
 	int16_t Err = 0;
-	uint32_t Bit_Count ;
 	uint8_t DaiBitT ;
 
 	if (Glob_PosInFile==PosInFile_Trailer)
 	{
 		DaiBitT = DaiBitType_Trailer;
-		Bit_Count = WavOut_TrailerDaiBits;
 	}
 	else
 	{
 		DaiBitT = DaiBitType_Leader;
-		Bit_Count = WavOut_LeaderDaiBits;
 	}
 
 	for (N=0; N < Bit_Count; N++)
 	{
-		Err = WriteDaiBit(DaiBitT, 0);
+		Err = WriteDaiBit(DaiBitT, (N < SlackBit_Count ? WavOut_IntSlackDelay : 0));
 		if (Err < 0) break;
 	}
 	return(Err);
@@ -398,7 +656,7 @@ int16_t WriteDaiTails(void)
 // WriteDaiCore 
 //-------------------------------------------------------------------------
 // Write all information to a wav file excluding Leader and Trailer
-// Input: WavOutFile and global variables o/w Glob_ProgType
+// Input: global variables o/w Glob_ProgType
 // Output : 0 or negative error code
 int16_t WriteDaiCore(void)
 {
@@ -449,67 +707,528 @@ int16_t WriteDaiCore(void)
 
 
 //-------------------------------------------------------------------------
-// DgvWavOut
+// WriteDaiProgram
 //-------------------------------------------------------------------------
-// Reads a .dai file and convert it into a wav file
-// Resulting files is ONLY for MAME emulator
-// As the 750ms for starting the motor is not modelized, the LOAD or R functions has to be entered before opening the wav file
+// Write Leader, a SyncBit and a StartByte (0x55), 3 Blocks and a Trailer in WavOut_Edges
+// Timing pass only, nothing depends on wav format
+int16_t WriteDaiProgram(void)
+{
+	int16_t NErr = 0;
+	uint16_t LeaderDaiBits = WavOut_LeaderDaiBits;
+	uint16_t SlackDaiBits = 0;
 
-int16_t DgvWavOut(char* WavFileName)
+	WavOutCache_Check(); // DaiBits already computed are reused if parameters are unchanged
+	if ((WavOut_MinLeader) || (WavOut_IntSlack))
+	{
+		NErr = WavOut_LeaderSchedule(&LeaderDaiBits, &SlackDaiBits); if (NErr < 0) { return (NErr); }
+	}
+	WavOut_Edges.BitsCount = 0;
+
+	NErr = WriteDaiLeader(LeaderDaiBits + WavOut_LeaderExtraDaiBits, SlackDaiBits); if (NErr < 0) { return (NErr); }
+	Glob_PosInFile = PosInFile_SyncByte;
+	NErr = WriteDaiByte(0x55); if (NErr < 0) { return (NErr); }
+	NErr = WriteDaiCore(); if (NErr < 0) { return (NErr); }
+	Glob_PosInFile = PosInFile_Trailer;
+	NErr = WriteDaiTails(WavOut_TrailerDaiBits, 0); 
+	WavOut_Edges.Shapes = WavOutCache_Shapes;
+	WavOut_Edges.ShapesCount = WavOutCache_BitsCount;
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_ReadBack
+//-------------------------------------------------------------------------
+// Program is written in WavOut_Edges with a leader of WavOut_CheckLeaderDaiBits at most,
+// and read back with the WavIn firmware model for every format, up to the end of block BlocksCount-1
+// Output : 0 if read back, negative error otherwise
+int16_t WavOut_ReadBack(uint8_t BlocksCount)
 {
-	FILE* DaiFile = NULL;
+	uint32_t Len;
+	uint8_t FormatI;
+	uint8_t* Wav;
 	int16_t NErr = 0;
-	
-	Glob_PosInFile = PosInFile_Leader;
-	Glob_BlockI = 0;
-	WavOut_SamplesCount = 0;
 
-    WavOutFile = fopen(WavFileName, "wb");
-	if (WavOutFile == NULL) { NErr = - WavOpenErr; goto DgvWavExit2; }
+	WavOutCache_Check();
+	WavOut_Edges.BitsCount = 0;
+	NErr = WriteDaiLeader((WavOut_LeaderDaiBits < WavOut_CheckLeaderDaiBits ? WavOut_LeaderDaiBits : WavOut_CheckLeaderDaiBits), 0); if (NErr < 0) { return (NErr); }
+	Glob_PosInFile = PosInFile_SyncByte;
+	NErr = WriteDaiByte(0x55); if (NErr < 0) { return (NErr); }
+	NErr = WriteDaiCore(); if (NErr < 0) { return (NErr); }
+	Glob_PosInFile = PosInFile_Trailer;
+	NErr = WriteDaiTails(WavOut_TrailerDaiBits, 0); if (NErr < 0) { return (NErr); }
+	WavOut_Edges.Shapes = WavOutCache_Shapes;
+	WavOut_Edges.ShapesCount = WavOutCache_BitsCount;
+
+	for (FormatI = 0; (FormatI < WavOut_FormatsCount) && (NErr >= 0); FormatI++)
+	{
+		NErr = WavRaster_Memory(&WavOut_Formats[FormatI], &WavOut_Edges, &Wav, &Len); if (NErr < 0) { return (NErr); }
+		NErr = WavIn_ReadFromMemory(Wav, Len, &WavOut_Formats[FormatI], BlocksCount);
+		free(Wav);
+	}
+	return (NErr);
+}
 
-	NErr = CreateWavOut(WavOutFile,0, WavOut_SamplingFq, WavOut_NChannels, WavOut_Bytes_per_sample);
-	if (NErr < 0) { goto DgvWavExit2; }
 
-	// Write Leader, a SyncBit and a StartByte (0x55), 3 Blocks and a Trailer 
+//-------------------------------------------------------------------------
+// WriteDaiLeader
+//-------------------------------------------------------------------------
+// Write Leader and SyncBit in WavOut_Edges
+int16_t WriteDaiLeader(uint32_t LeaderDaiBits, uint32_t SlackDaiBits)
+{
+	int16_t NErr = 0;
+
+	Glob_PosInFile = PosInFile_Leader;
+	Glob_BlockI = 0;
 	Glob_InterK7ReadDelay = EnterDaiBit_Delay;
-	NErr = WriteDaiTails(); if (NErr < 0) { goto DgvWavExit; }
-	Glob_InterK7ReadDelay = TailsCyclesPerLoop * DaiHW_Profile[Glob_DaiHw].DaiBitPeriods_MinLoops[DaiBitType_Leader][DaiBit_P3_TTLH]; // Delay of last Period (Low Level) of last Loop
+	NErr = WriteDaiTails(LeaderDaiBits, SlackDaiBits); if (NErr < 0) { return (NErr); }
+	Glob_InterK7ReadDelay = TailsCyclesPerLoop * WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType_Leader][DaiBit_P3_TTLH]; // Delay of last Period (Low Level) of last Loop
 	if (Glob_InterK7ReadDelay < LeaderLastBitToSyncBitDelayMin) 
 	{
 		Glob_InterK7ReadDelay = LeaderLastBitToSyncBitDelayMin;
 	}
-	NErr = WriteDaiBit(DaiBitType_SyncBit, Glob_InterK7ReadDelay); if (NErr < 0) { goto DgvWavExit; } // SyncBit, thefore no additional delay is required
+	NErr = WriteDaiBit(DaiBitType_SyncBit, Glob_InterK7ReadDelay); if (NErr < 0) { return (NErr); } // SyncBit, thefore no additional delay is required
 	Glob_InterK7ReadDelay = SyncBitExit_Delay + SyncBitDaiBit_Delay + EnterDaiBit_Delay; // XXX No margin added, No need to interrupt delays because there are allow only if error 
 	Glob_Debug_K7ReadTime = EnterDaiBit_Delay ; // XXXX
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_LeaderSchedule
+//-------------------------------------------------------------------------
+// Leader length and interrupt slack checked with the firmware model (WavIn ReadLeader), for every wav format
+// 'R' : slack is added to the first leader DaiBits, up to where ReadLeader waits with interrupts enabled (+ WavOut_IntSlackMargin)
+// 'L' : shortest leader which syncs from every entry phase within the first leader DaiBit (+ WavOut_MinLeaderMargin),
+//       with 'R' also when any interrupt lands in the slack DaiBits. Result is limited to the profile leader
+// Output : LeaderDaiBits, SlackDaiBits, 0 or negative error. WavOut_Edges is used
+int16_t WavOut_LeaderSchedule(uint16_t* LeaderDaiBits, uint16_t* SlackDaiBits)
+{
+	struct WavOutLeaderKey_Struct Key;
+	uint32_t EntryMax = 0;
+	uint32_t IntEnabledEnd;
+	uint16_t N;
+	uint16_t Slack = 0;
+	uint16_t SlackOld;
+	uint8_t Iter;
+	uint8_t Px;
+	bool Synced = false;
+	int16_t NErr;
+
+	memset(&Key, 0, sizeof(Key)); // Padding is compared too
+	Key.Cache = WavOutCache_Key; // Set by WavOutCache_Check
+	Key.MinLeader = WavOut_MinLeader;
+	Key.IntSlack = WavOut_IntSlack;
+	Key.PosSpeeds = WavOut_PosSpeeds;
+	Key.LoadDelays = WavOut_LoadDelays;
+	Key.FormatsCount = WavOut_FormatsCount;
+	memcpy(Key.Formats, WavOut_Formats, WavOut_FormatsCount * sizeof(struct WavFormat_Struct));
+	if ((WavOutLeader_DaiBits != 0) && (memcmp(&Key, &WavOutLeader_Key, sizeof(Key)) == 0))
+	{
+		*LeaderDaiBits = WavOutLeader_DaiBits;
+		*SlackDaiBits = WavOutLeader_SlackDaiBits;
+		return (0);
+	}
+
+	for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+	{
+		EntryMax += TailsCyclesPerLoop * WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType_Leader][Px];
+	}
+
+	// Slack up to the last wait with interrupts enabled, which moves with the slack itself
+	if (WavOut_IntSlack)
+	{
+		for (Iter = 0; Iter < WavOut_IntSlackIterMax; Iter++)
+		{
+			NErr = WavOut_LeaderTest(WavOut_LeaderDaiBits, Slack, EntryMax, TailsCyclesPerLoop, 0, &Synced, &IntEnabledEnd); if (NErr < 0) { return (NErr); }
+			SlackOld = Slack;
+			Slack = WavOut_LeaderDaiBitAt(IntEnabledEnd) + 1 + WavOut_IntSlackMargin;
+			if (Slack <= SlackOld) { Slack = SlackOld; break; }
+		}
+	}
+
+	N = WavOut_LeaderDaiBits;
+	if (WavOut_MinLeader)
+	{
+		Synced = false;
+		for (N = 1; (N < WavOut_LeaderDaiBits) && (!Synced); N++)
+		{
+			NErr = WavOut_LeaderTest(N, Slack, EntryMax, 1, 0, &Synced, &IntEnabledEnd); if (NErr < 0) { return (NErr); }
+			if ((Synced) && (WavOut_IntSlack))
+			{
+				NErr = WavOut_LeaderTest(N, Slack, EntryMax, TailsCyclesPerLoop, WavOut_LeaderCycles(Slack + 1), &Synced, &IntEnabledEnd); if (NErr < 0) { return (NErr); }
+			}
+		}
+		N = (Synced ? N - 1 + WavOut_MinLeaderMargin : WavOut_LeaderDaiBits);
+		if (N > WavOut_LeaderDaiBits) { N = WavOut_LeaderDaiBits; }
+	}
+	if (Slack > N) { Slack = N; }
+
+	WavOutLeader_Key = Key;
+	WavOutLeader_DaiBits = N;
+	WavOutLeader_SlackDaiBits = Slack;
+	*LeaderDaiBits = N;
+	*SlackDaiBits = Slack;
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_LeaderTest
+//-------------------------------------------------------------------------
+// Writes a leader of LeaderDaiBits (SlackDaiBits first ones with slack), SyncBit, Sync Byte and type byte in WavOut_Edges
+// and reads it back with the firmware model for every format, ReadLeader being entered every EntryStep cycles in [0, EntryMax)
+// If IntWindow != 0, each entry is also run with RST 7, RST 6 and both triggered every EntryStep cycles in [0, IntWindow)
+// Output : Synced if all runs read the Sync Byte, IntEnabledEnd (latest among runs), 0 or negative error
+int16_t WavOut_LeaderTest(uint16_t LeaderDaiBits, uint16_t SlackDaiBits, uint32_t EntryMax, uint16_t EntryStep, uint32_t IntWindow,
+	bool* Synced, uint32_t* IntEnabledEnd)
+{
+	struct WavInSync_Struct Sync;
+	uint32_t Len;
+	uint32_t IntDelay;
+	uint8_t FormatI;
+	uint8_t IntKind;
+	uint8_t* Wav;
+	int16_t NErr;
+
+	*Synced = true;
+	*IntEnabledEnd = 0;
+	WavOut_Edges.BitsCount = 0;
+	NErr = WriteDaiLeader(LeaderDaiBits, SlackDaiBits); if (NErr < 0) { return (NErr); }
 	Glob_PosInFile = PosInFile_SyncByte;
-	NErr = WriteDaiByte(0x55); if (NErr < 0) { goto DgvWavExit; }
-	NErr = WriteDaiCore(); if (NErr < 0) { goto DgvWavExit; }
-	Glob_PosInFile = PosInFile_Trailer;
-	NErr = WriteDaiTails(); if (NErr < 0) { goto DgvWavExit; }
-	NErr = UdpdateWavSize(WavOutFile, WavOut_SamplesCount, WavOut_Bytes_per_sample); if (NErr < 0) { goto DgvWavExit; }
+	NErr = WriteDaiByte(0x55); if (NErr < 0) { return (NErr); }
+	Glob_PosInFile = PosInFile_ProgByte; // A byte to end the last DaiBit
+	NErr = WriteDaiByte(Glob_ProgType); if (NErr < 0) { return (NErr); }
+	WavOut_Edges.Shapes = WavOutCache_Shapes;
+	WavOut_Edges.ShapesCount = WavOutCache_BitsCount;
+
+	for (FormatI = 0; (FormatI < WavOut_FormatsCount) && (*Synced); FormatI++)
+	{
+		NErr = WavRaster_Memory(&WavOut_Formats[FormatI], &WavOut_Edges, &Wav, &Len); if (NErr < 0) { return (NErr); }
+		for (Sync.EntryDelay = 0; (Sync.EntryDelay < EntryMax) && (*Synced); Sync.EntryDelay += EntryStep)
+		{
+			// IntKind 0 : no interrupt, 1 : RST 7, 2 : RST 6, 3 : both
+			for (IntKind = 0; (IntKind < 4) && (*Synced); IntKind++)
+			{
+				for (IntDelay = 0; ((IntDelay < IntWindow) || (IntKind == 0)) && (*Synced); IntDelay += EntryStep)
+				{
+					Sync.Interrupts = (IntKind != 0);
+					Sync.Rst7Delay = ((IntKind & 1) ? IntDelay : WavInSync_NoRst);
+					Sync.Rst6Delay = ((IntKind & 2) ? IntDelay : WavInSync_NoRst);
+					*Synced = (WavIn_SyncFromMemory(Wav, Len, &WavOut_Formats[FormatI], &Sync) == 0);
+					if (Sync.IntEnabledEnd > *IntEnabledEnd) { *IntEnabledEnd = Sync.IntEnabledEnd; }
+					if (IntKind == 0) { break; }
+				}
+				if (IntWindow == 0) { break; }
+			}
+		}
+		free(Wav);
+	}
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_LeaderDaiBitAt
+//-------------------------------------------------------------------------
+// Index of the leader DaiBit of WavOut_Edges being played CpuCycles after first sample
+uint16_t WavOut_LeaderDaiBitAt(uint32_t CpuCycles)
+{
+	uint32_t BitI;
+	uint32_t BitCycles;
+	uint8_t Px;
+
+	for (BitI = 0; BitI < WavOut_Edges.BitsCount; BitI++)
+	{
+		BitCycles = 0;
+		for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+		{
+			BitCycles += WavOut_Edges.Shapes[WavOut_Edges.Bits[BitI]].Cycles[Px];
+		}
+		if (CpuCycles < BitCycles) { break; }
+		CpuCycles -= BitCycles;
+	}
+	return ((uint16_t)BitI);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_LeaderCycles
+//-------------------------------------------------------------------------
+// Cpu cycles of the first LeaderDaiBits of WavOut_Edges
+uint32_t WavOut_LeaderCycles(uint16_t LeaderDaiBits)
+{
+	uint32_t BitI;
+	uint32_t Cycles = 0;
+	uint8_t Px;
+
+	for (BitI = 0; (BitI < LeaderDaiBits) && (BitI < WavOut_Edges.BitsCount); BitI++)
+	{
+		for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+		{
+			Cycles += WavOut_Edges.Shapes[WavOut_Edges.Bits[BitI]].Cycles[Px];
+		}
+	}
+	return (Cycles);
+}
+
 
-DgvWavExit:
-DgvWavExit2:
-	if (WavOutFile != NULL) { fclose(WavOutFile);	}
+//-------------------------------------------------------------------------
+// DgvWavOut
+//-------------------------------------------------------------------------
+// Reads a .dai file and convert it into a wav file, with main format (WavOut_Formats[0])
+// Resulting files is ONLY for MAME emulator
+// As the 750ms for starting the motor is not modelized, the LOAD or R functions has to be entered before opening the wav file
+// WavFileName = WavOut_StdoutName ("-") streams the wav to standard output, header first
+int16_t DgvWavOut(char* WavFileName)
+{
+	struct WavRaster_Struct Raster;
+
+	if (strlen(WavFileName) > MaxLenString) return (-WavOpenErr);
+	Raster.Format = WavOut_Formats[0];
+	strcpy(Raster.FileName, WavFileName);
+	return (DgvWavOutRasters(&Raster, 1));
+}
+
+
+//-------------------------------------------------------------------------
+// DgvWavOutRasters
+//-------------------------------------------------------------------------
+// Converts the program in memory into several wav files, one per raster (format and file name)
+// Timing pass is done once, rasters are then written concurrently from WavOut_Edges
+// Output : 0 or first negative error, error of each raster is in Rasters[i].NErr
+int16_t DgvWavOutRasters(struct WavRaster_Struct* Rasters, uint8_t NRasters)
+{
+	const struct DaiHardware_Struct* Profile = WavOut_Profile;
+	int16_t NErr;
+	uint8_t RasterI;
 
+	NErr = (WavOut_Turbo ? WavTurbo_TimingPass() : WavOut_TimingPass());
+	if (NErr >= 0)
+	{
+		NErr = WavRaster_Render(Rasters, NRasters, &WavOut_Edges);
+	}
+	else
+	{
+		for (RasterI = 0; RasterI < NRasters; RasterI++) { Rasters[RasterI].NErr = NErr; }
+	}
+	if (WavOut_Profile != Profile) { SetWavOutProfile(Profile); } // Next program is tuned from the same profile
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_TimingPass
+//-------------------------------------------------------------------------
+// Program in memory is written in WavOut_Edges, with the profile tuned for it ('T' option, WavOut_Profile is the tuned one)
+// With 'Q' option, fast DaiBits positions are used if they are read back by the firmware model
+// Output : 0 or negative error
+int16_t WavOut_TimingPass(void)
+{
+	int16_t NErr = 0;
+
+	WavOut_PosSpeeds = WavOut_FastPos;
+	if (WavOut_TuneMargin != WavOut_TuneOff)
+	{
+		NErr = DgvWavTune(WavOut_TuneMargin); // WavOut_Profile is the tuned one
+	}
+#if(WavOut_PosSpeedsCheck)
+	if ((NErr >= 0) && (WavOut_FastPos) && (WavOut_ReadBack(WavOut_CheckBlocks) < 0))
+	{
+		fprintf(stderr, "Fast DaiBits not read back by the firmware model, original positions are used\n");
+		WavOut_PosSpeeds = false;
+	}
+#endif
+	if (NErr >= 0) { NErr = WriteDaiProgram(); }
 	return (NErr);
 }
 
 
+//-------------------------------------------------------------------------
+// WavOut_Estimate
+//-------------------------------------------------------------------------
+// Closed form of the wav written for the program in memory with Format, nothing is written in WavOut_Edges
+// DaiBits of each shape are counted as in WriteDaiProgram, bytes of a block by their bits statistics (see WavOut_EstimateBytes),
+// samples of a shape do not depend on its position. Leader of 'L' and 'R' options (see WavOut_LeaderSchedule),
+// fast DaiBits positions of 'Q' option as when read back, no tuning
+// Output : Est, 0 or negative error
+int16_t WavOut_Estimate(const struct WavFormat_Struct* Format, struct WavOutEstimate_Struct* Est)
+{
+	uint32_t ShapeBits[WavOutCache_BitsMax]; // DaiBits of each shape of WavOutCache_Shapes
+	uint16_t ShapeI;
+	uint8_t DaiBitPeriod;
+	uint8_t Byte[3];
+	uint16_t LeaderDaiBits;
+	uint16_t SlackDaiBits = 0;
+	int16_t BitI;
+	int16_t NErr;
+
+	memset(Est, 0, sizeof(*Est));
+	memset(ShapeBits, 0, sizeof(ShapeBits));
+	if (Format->AutoRate != 0) return (-InvalidCmdOption); // Samples depend on the whole program
+	WavOutCache_Check();
+	WavOut_PosSpeeds = WavOut_FastPos; // As WavOut_TimingPass when read back
+
+	// Leader and SyncBit (see WriteDaiProgram and WriteDaiLeader)
+	LeaderDaiBits = WavOut_LeaderDaiBits;
+	if ((WavOut_MinLeader) || (WavOut_IntSlack))
+	{
+		NErr = WavOut_LeaderSchedule(&LeaderDaiBits, &SlackDaiBits); if (NErr < 0) { return (NErr); }
+	}
+	Glob_PosInFile = PosInFile_Leader;
+	Glob_BlockI = 0;
+	BitI = WavOutCache_GetBit(DaiBitType_Leader, 0); if (BitI < 0) { return (BitI); }
+	ShapeBits[BitI] += LeaderDaiBits - SlackDaiBits + WavOut_LeaderExtraDaiBits;
+	if (SlackDaiBits != 0)
+	{
+		BitI = WavOutCache_GetBit(DaiBitType_Leader, WavOut_IntSlackDelay); if (BitI < 0) { return (BitI); }
+		ShapeBits[BitI] += SlackDaiBits;
+	}
+	Glob_InterK7ReadDelay = TailsCyclesPerLoop * WavOut_Profile->DaiBitPeriods_MinLoops[DaiBitType_Leader][DaiBit_P3_TTLH];
+	if (Glob_InterK7ReadDelay < LeaderLastBitToSyncBitDelayMin) { Glob_InterK7ReadDelay = LeaderLastBitToSyncBitDelayMin; }
+	BitI = WavOutCache_GetBit(DaiBitType_SyncBit, Glob_InterK7ReadDelay); if (BitI < 0) { return (BitI); }
+	ShapeBits[BitI]++;
+	Glob_InterK7ReadDelay = SyncBitExit_Delay + SyncBitDaiBit_Delay + EnterDaiBit_Delay;
+
+	// Sync byte, type and blocks (see WriteDaiCore)
+	Glob_PosInFile = PosInFile_SyncByte;
+	Byte[0] = 0x55;
+	NErr = WavOut_EstimateBytes(Byte, 1, ShapeBits); if (NErr < 0) { return (NErr); }
+	Glob_PosInFile = PosInFile_ProgByte;
+	Byte[0] = Glob_ProgType;
+	NErr = WavOut_EstimateBytes(Byte, 1, ShapeBits); if (NErr < 0) { return (NErr); }
+	for (Glob_BlockI = 0; Glob_BlockI < DataBlock_Count; Glob_BlockI++)
+	{
+		Glob_PosInFile = PosInFile_InBlock;
+		Byte[0] = (uint8_t)(DaiBlocksInfo[Glob_BlockI].Len >> 8);
+		Byte[1] = (uint8_t)(DaiBlocksInfo[Glob_BlockI].Len & 0xFF);
+		Byte[2] = DaiBlocksInfo[Glob_BlockI].LenCS;
+		for (Glob_PosInBlock = PosInBlock_LenH; Glob_PosInBlock <= PosInBlock_LenCS; Glob_PosInBlock++)
+		{
+			NErr = WavOut_EstimateBytes(Byte + Glob_PosInBlock - PosInBlock_LenH, 1, ShapeBits); if (NErr < 0) { return (NErr); }
+		}
+		Glob_PosInBlock = (DaiBlocksInfo[Glob_BlockI].Len == 1 ? PosInBlock_LastByte : PosInBlock_InData); // As WriteDaiCore
+		NErr = WavOut_EstimateBytes((const uint8_t*)DaiBlocksInfo[Glob_BlockI].Block, DaiBlocksInfo[Glob_BlockI].Len, ShapeBits); if (NErr < 0) { return (NErr); }
+		Glob_PosInFile = (Glob_BlockI == 0 ? PosInFile_BlockCS0 : PosInFile_BlockCSN);
+		NErr = WavOut_EstimateBytes(&DaiBlocksInfo[Glob_BlockI].BlockCS, 1, ShapeBits); if (NErr < 0) { return (NErr); }
+	}
+	Est->LoadSamples = WavOut_EstimateSamples(ShapeBits, Format->SamplingFq);
+
+	// Trailer
+	Glob_PosInFile = PosInFile_Trailer;
+	BitI = WavOutCache_GetBit(DaiBitType_Trailer, 0); if (BitI < 0) { return (BitI); }
+	ShapeBits[BitI] += WavOut_TrailerDaiBits;
+	Est->Samples = WavOut_EstimateSamples(ShapeBits, Format->SamplingFq);
+
+	for (ShapeI = 0; ShapeI < WavOutCache_BitsCount; ShapeI++)
+	{
+		Est->DaiBits += ShapeBits[ShapeI];
+		for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+		{
+			Est->Cycles += (uint64_t)ShapeBits[ShapeI] * WavOutCache_Shapes[ShapeI].Cycles[DaiBitPeriod];
+		}
+	}
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_EstimateBytes
+//-------------------------------------------------------------------------
+// Adds the DaiBits of Len bytes written at current position to ShapeBits, as WriteDaiByte would write them
+// First byte follows the previous position, next ones follow a byte of the same position : each group only needs
+// the count of bytes, of ones in first DaiBits (MSB) and of ones in next DaiBits
+int16_t WavOut_EstimateBytes(const uint8_t* Data, uint32_t Len, uint32_t* ShapeBits)
+{
+	const struct WavOutCacheByte_Struct* Byte;
+	uint32_t Ones[2]; // Ones in first DaiBits, in next DaiBits
+	uint32_t DataI = 0;
+	uint32_t End;
+	uint32_t N;
+	int16_t ByteI;
+	uint8_t Bits;
+
+	while (DataI < Len)
+	{
+		End = (DataI == 0 ? 1 : Len);
+		ByteI = WavOutCache_GetByte(WavOut_ByteSpeed(), Glob_InterK7ReadDelay); if (ByteI < 0) return (ByteI);
+		Byte = &WavOutCache_Bytes[ByteI];
+		Ones[0] = 0;
+		Ones[1] = 0;
+		for (N = DataI; N < End; N++)
+		{
+			Ones[0] += Data[N] >> 7;
+			for (Bits = Data[N] & 0x7F; Bits != 0; Bits &= Bits - 1) { Ones[1]++; }
+		}
+		N = End - DataI;
+		ShapeBits[Byte->BitI[0][0]] += N - Ones[0];
+		ShapeBits[Byte->BitI[0][1]] += Ones[0];
+		ShapeBits[Byte->BitI[1][0]] += 7 * N - Ones[1];
+		ShapeBits[Byte->BitI[1][1]] += Ones[1];
+		WavOut_NextByteDelay();
+		DataI = End;
+	}
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_EstimateSamples
+//-------------------------------------------------------------------------
+// Samples (per channel) of the DaiBits counted in ShapeBits, as rendered by WavRaster
+uint64_t WavOut_EstimateSamples(const uint32_t* ShapeBits, uint32_t SamplingFq)
+{
+	uint64_t Samples = 0;
+	uint16_t ShapeI;
+	uint8_t DaiBitPeriod;
+
+	for (ShapeI = 0; ShapeI < WavOutCache_BitsCount; ShapeI++)
+	{
+		if (ShapeBits[ShapeI] == 0) continue;
+		for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+		{
+			Samples += (uint64_t)ShapeBits[ShapeI] * WavRaster_SamplesMin(WavOutCache_Shapes[ShapeI].Cycles[DaiBitPeriod], SamplingFq);
+		}
+	}
+	return (Samples);
+}
+
+
 //-------------------------------------------------------------------------
 // LoadProgOptionsArgument 
 //-------------------------------------------------------------------------
-// Update Wav out file options
-// Input : Partial list of Options (string starting by -- with groups of characters, see PrinHelp for more details)
+// Update Wav out file options of the encoder state of the calling thread (see WavOut_LoadOptions)
 // Output : parameters listed in Options, read from program argument, are set
 //			A flag corresponding to each option is coded in UpdatedOptionBits
 //
-uint16_t LoadProgOptionsArgument(char* Options)
+uint32_t LoadProgOptionsArgument(char* Options)
+{
+	struct WavOutConfig_Struct Config;
+	uint32_t UpdatedOptionBits;
+
+	WavOut_GetConfig(&Config);
+	UpdatedOptionBits = WavOut_LoadOptions(Options, &Config);
+	if (UpdatedOptionBits != 0) { WavOut_SetConfig(&Config); }
+	return (UpdatedOptionBits);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_LoadOptions 
+//-------------------------------------------------------------------------
+// Update the options of Config, encoder state is unchanged
+// Input : Partial list of Options (string starting by -- with groups of characters, see PrinHelp for more details)
+//		Additional wav formats, written from the same timing pass, can follow separated by '+' (ex: --V7MW+SBF44100)
+//		They start from the main format and only accept format options (M,S,B,W,N,I,A,E,F)
+// Output : parameters listed in Options are set in Config, a flag corresponding to each option is coded in UpdatedOptionBits
+uint32_t WavOut_LoadOptions(char* Options, struct WavOutConfig_Struct* Config)
 {
-	uint16_t UpdatedOptionBits = 0;
+	uint32_t UpdatedOptionBits = 0;
 	int64_t OptVal;
 	char* Opt2;
+	char* Group;
 	uint16_t LenOpt;
+	char MainOptions[OptionsLenMax + 1];
 
 	LenOpt = (uint16_t)strlen(Options);
 	if ((LenOpt < 3) || (LenOpt > OptionsLenMax) || (Options[0] != '-') || (Options[1] != '-')) // Option validated with at least 1 char ('--x')
@@ -518,43 +1237,134 @@ uint16_t LoadProgOptionsArgument(char* Options)
 	}
 	UpdatedOptionBits = OptionBit_OptionArgument ;
 
-	// Set Glob_DaiHw ?
-	Opt2 = strrchr(Options, 'V');
-	if ( (Opt2 != NULL) && (((uint8_t)(Opt2+1-Options))<=LenOpt) ) // If V exist and at least one char is present after 
+	// Main options, up to first additional format
+	strcpy(MainOptions, Options);
+	Group = strchr(Options, '+');
+	if (Group != NULL) { MainOptions[Group - Options] = '\0'; }
+	LenOpt = (uint16_t)strlen(MainOptions);
+
+	// Set hardware profile ?
+	Opt2 = strrchr(MainOptions, 'V');
+	if ( (Opt2 != NULL) && (((uint8_t)(Opt2+1-MainOptions))<=LenOpt) ) // If V exist and at least one char is present after 
 	{
 		OptVal = * (Opt2+1);
 		if ((OptVal >= '0') && (OptVal <= '9'))
 		{ 
-			Glob_DaiHw = (uint8_t) (OptVal - '0'); 
-			SetWavOutParameters(Glob_DaiHw);
+			WavOut_DefaultConfig((uint16_t)(OptVal - '0'), Config);
 			UpdatedOptionBits |= OptionBit_Hardware;
 
 		} // Ex 1 for DaiHW_DaiV7
 	}
+	if (strrchr(MainOptions, 'L') != NULL) { Config->MinLeader = true; UpdatedOptionBits |= OptionBit_MinLeader; }
+	if (strrchr(MainOptions, 'R') != NULL) { Config->IntSlack = true; UpdatedOptionBits |= OptionBit_IntSlack; }
+	if (strrchr(MainOptions, 'Q') != NULL) { Config->FastPos = true; UpdatedOptionBits |= OptionBit_FastPos; }
+	if (strrchr(MainOptions, 'U') != NULL)
+	{
+		if (WavTune_Load(WavTune_FileName, &Config->Profile) >= 0)
+		{
+			Config->LoadTuned = true;
+			WavOut_DefaultFormat(Config);
+			UpdatedOptionBits |= OptionBit_LoadTuned;
+		}
+		else { fprintf(stderr, "Tuned profile not loaded from %s\n", WavTune_FileName); }
+	}
+	if (strrchr(MainOptions, 'D') != NULL)
+	{
+		if (WavCalib_Load(WavCalib_FileName, Config->InBkInterCallsDelays, Config->OutBkInterCallsDelays) >= 0)
+		{
+			Config->LoadDelays = true;
+			UpdatedOptionBits |= OptionBit_LoadDelays;
+		}
+		else { fprintf(stderr, "Inter calls delays not loaded from %s\n", WavCalib_FileName); }
+	}
+	if (strrchr(MainOptions, 'J') != NULL) { Config->Playlist = true; UpdatedOptionBits |= OptionBit_Playlist; }
+	if (strrchr(MainOptions, 'K') != NULL) { Config->Turbo = true; UpdatedOptionBits |= OptionBit_Turbo; }
+	if (strrchr(MainOptions, 'G') != NULL)
+	{
+		if (WavGrid_Load(WavGrid_FileName) >= 0)
+		{
+			Config->Grid = true;
+			UpdatedOptionBits |= OptionBit_Grid;
+		}
+		else { fprintf(stderr, "Invalid margin grid in %s (up to %d variants)\n", WavGrid_FileName, WavGrid_VariantsMax); }
+	}
+	Opt2 = strrchr(MainOptions, 'T');
+	if (Opt2 != NULL)
+	{
+		OptVal = (((Opt2[1] >= '0') && (Opt2[1] <= '9')) ? GetFirstNumberInString(Opt2 + 1) : WavTune_MarginDefault);
+		if ((OptVal >= 0) && (OptVal <= WavTune_MarginMax))
+		{
+			Config->TuneMargin = (int16_t)OptVal;
+			UpdatedOptionBits |= OptionBit_Tune;
+		}
+	}
+	UpdatedOptionBits |= LoadFormatOptions(MainOptions, &Config->Formats[0]);
+
+	// Additional formats
+	Config->FormatsCount = 1;
+	while ((Group != NULL) && (Config->FormatsCount < WavOut_FormatsMax))
+	{
+		Group++;
+		strcpy(MainOptions, Group);
+		Opt2 = strchr(MainOptions, '+');
+		if (Opt2 != NULL) { *Opt2 = '\0'; }
+		Config->Formats[Config->FormatsCount] = Config->Formats[0];
+		LoadFormatOptions(MainOptions, &Config->Formats[Config->FormatsCount]);
+		Config->FormatsCount++;
+		Group = strchr(Group, '+');
+	}
+
+UpdateParamExit:
+
+	return (UpdatedOptionBits);
+}
+
+
+//-------------------------------------------------------------------------
+// LoadFormatOptions 
+//-------------------------------------------------------------------------
+// Update a wav format from a group of options
+// Input : Options without additional formats, M,S,B,W,N,I,A,E,F
+// Output : Format is updated, flags of updated options
+uint32_t LoadFormatOptions(char* Options, struct WavFormat_Struct* Format)
+{
+	uint32_t UpdatedOptionBits = 0;
+	int64_t OptVal;
+	char* Opt2;
+	uint16_t LenOpt;
+
+	LenOpt = (uint16_t)strlen(Options);
 
 	// Set Byte count per sample, Mono/Stereo, Inversed signal (parity)
-	if (strrchr(Options, 'M') != NULL) { WavOut_NChannels = 1;  UpdatedOptionBits |= OptionBit_NChannels; }
-	if (strrchr(Options, 'S') != NULL) { WavOut_NChannels = 2; UpdatedOptionBits |= OptionBit_NChannels; }
-	if (strrchr(Options, 'B') != NULL) { WavOut_Bytes_per_sample = 1; UpdatedOptionBits |= OptionBit_NBytes; }
-	if (strrchr(Options, 'W') != NULL) { WavOut_Bytes_per_sample = 2; UpdatedOptionBits |= OptionBit_NBytes; }
-	if (strrchr(Options, 'N') != NULL) { WavOut_InvertSignal = 0; UpdatedOptionBits |= OptionBit_Parity; }
-	if (strrchr(Options, 'I') != NULL) { WavOut_InvertSignal = 1; UpdatedOptionBits |= OptionBit_Parity; }
+	if (strrchr(Options, 'M') != NULL) { Format->NChannels = 1;  UpdatedOptionBits |= OptionBit_NChannels; }
+	if (strrchr(Options, 'S') != NULL) { Format->NChannels = 2; UpdatedOptionBits |= OptionBit_NChannels; }
+	if (strrchr(Options, 'B') != NULL) { Format->Bytes_per_sample = 1; UpdatedOptionBits |= OptionBit_NBytes; }
+	if (strrchr(Options, 'W') != NULL) { Format->Bytes_per_sample = 2; UpdatedOptionBits |= OptionBit_NBytes; }
+	if (strrchr(Options, 'N') != NULL) { Format->InvertSignal = 0; UpdatedOptionBits |= OptionBit_Parity; }
+	if (strrchr(Options, 'I') != NULL) { Format->InvertSignal = 1; UpdatedOptionBits |= OptionBit_Parity; }
+	if (strrchr(Options, 'A') != NULL) { Format->AutoRate = 1; UpdatedOptionBits |= OptionBit_AutoRate; }
+	Opt2 = strrchr(Options, 'E');
+	if ((Opt2 != NULL) && (Opt2[1] >= '0') && (Opt2[1] < '0' + WavOutEdge_Count))
+	{
+		Format->EdgeShape = (uint8_t)(Opt2[1] - '0');
+		UpdatedOptionBits |= OptionBit_EdgeShape;
+	}
 
 	// Sampling frequency option
 	Opt2 = strrchr(Options, 'F');
-	if (Opt2 == NULL) goto UpdateParamExit;
+	if (Opt2 == NULL) goto LoadFormatExit;
 	Opt2++;
-	if (((uint8_t)(Opt2+5 - Options)) <= LenOpt) // If V exist and at least 5 char is present after  
+	if (((uint8_t)(Opt2+5 - Options)) <= LenOpt) // If F exist and at least 5 char is present after  
 	{
 		OptVal = GetFirstNumberInString(Opt2);
 		if ((OptVal >=20000L) && (OptVal <= 1000000L)) 
 		{
-			WavOut_SamplingFq = (uint32_t)(OptVal);
+			Format->SamplingFq = (uint32_t)(OptVal);
 			UpdatedOptionBits |= OptionBit_Frequency;
 		}
 	}
 
-UpdateParamExit:
+LoadFormatExit:
 
 	return (UpdatedOptionBits);
 }
@@ -564,16 +1374,91 @@ UpdateParamExit:
 // Update_WavOut_NameOptions 
 //-------------------------------------------------------------------------
 // Creates an Options string corresponding to actual parameters (inverse of LoadProgOptionsArgument)
-// Output : Options is cleand to includes all parameters information
+// Output : Options is cleand to includes all parameters information of main format
 void Update_WavOut_NameOptions(char* Options)
+{
+	WavFormat_NameOptions(Options, &WavOut_Formats[0]);
+}
+
+
+//-------------------------------------------------------------------------
+// WavFormat_NameOptions 
+//-------------------------------------------------------------------------
+// Creates an Options string corresponding to hardware profile and a wav format, with the encoder state of the calling thread
+void WavFormat_NameOptions(char* Options, const struct WavFormat_Struct* Format)
+{
+	struct WavOutConfig_Struct Config;
+
+	WavOut_GetConfig(&Config);
+	WavOut_ConfigNameOptions(Options, &Config, Format);
+}
+
+
+//-------------------------------------------------------------------------
+// WavOut_ConfigNameOptions 
+//-------------------------------------------------------------------------
+// Creates an Options string corresponding to hardware profile and options of Config, and a wav format
+void WavOut_ConfigNameOptions(char* Options, const struct WavOutConfig_Struct* Config, const struct WavFormat_Struct* Format)
 {
 	strcpy(Options, (char*)"--Vx");
 
 	// Hardware type
-	if (Glob_DaiHw < DaiHW_Count) { Options[3] = Glob_DaiHw + '0'; }
+	if (Config->DaiHw < DaiHW_Count) { Options[3] = (char)(Config->DaiHw + '0'); }
+
+	// Shortest leader
+	if (Config->MinLeader)
+	{
+		strcat(Options, (char*)"L");
+	}
+
+	// Interrupt slack on leader
+	if (Config->IntSlack)
+	{
+		strcat(Options, (char*)"R");
+	}
+
+	// Fast DaiBits at every position
+	if (Config->FastPos)
+	{
+		strcat(Options, (char*)"Q");
+	}
+
+	// Learned inter calls delays
+	if (Config->LoadDelays)
+	{
+		strcat(Options, (char*)"D");
+	}
+
+	// Playlist
+	if (Config->Playlist)
+	{
+		strcat(Options, (char*)"J");
+	}
+
+	// Turbo loader
+	if (Config->Turbo)
+	{
+		strcat(Options, (char*)"K");
+	}
+
+	// Margin variants, grid coordinates are added to each file name
+	if (Config->Grid)
+	{
+		strcat(Options, (char*)"G");
+	}
+
+	// Tuned profile, loaded then tuned for the program
+	if (Config->LoadTuned)
+	{
+		strcat(Options, (char*)"U");
+	}
+	if (Config->TuneMargin != WavOut_TuneOff)
+	{
+		sprintf(Options + strlen(Options), "T%d", Config->TuneMargin);
+	}
 
 	// Mono or Stereo
-	if (WavOut_NChannels == 2)
+	if (Format->NChannels == 2)
 	{
 		strcat(Options, (char*)"S");
 	}
@@ -583,7 +1468,7 @@ void Update_WavOut_NameOptions(char* Options)
 	}
 
 	// 8 bits or 16 Bits per sample
-	if (WavOut_Bytes_per_sample == 2)
+	if (Format->Bytes_per_sample == 2)
 	{
 		strcat(Options, (char*)"W");
 	}
@@ -594,7 +1479,7 @@ void Update_WavOut_NameOptions(char* Options)
 
 
 	// Normal or inverted signal
-	if (WavOut_InvertSignal == 0)
+	if (Format->InvertSignal == 0)
 	{
 		strcat(Options, (char*)"N");
 	}
@@ -603,9 +1488,21 @@ void Update_WavOut_NameOptions(char* Options)
 		strcat(Options, (char*)"I");
 	}
 
+	// Automatic sample rate, frequency is the reference
+	if (Format->AutoRate != 0)
+	{
+		strcat(Options, (char*)"A");
+	}
+
+	// Edge shaping, only when set to keep default names
+	if (Format->EdgeShape != WavOutEdge_None)
+	{
+		sprintf(Options + strlen(Options), "E%d", Format->EdgeShape);
+	}
+
 	// Frequency
 	strcat(Options, (char*)"F");
-	sprintf(Options + strlen(Options), "%ld", WavOut_SamplingFq);
+	sprintf(Options + strlen(Options), "%lu", (unsigned long)Format->SamplingFq);
 }
 
 
@@ -621,7 +1518,7 @@ int64_t GetFirstNumberInString(char* StringWithNum)
 	int64_t Num;
 
 	StartChar = StringWithNum;
-	while (((*StartChar) != '\0') && (((*StartChar) < '0') || ((*StartChar) > '9'))) ;
+	while (((*StartChar) != '\0') && (((*StartChar) < '0') || ((*StartChar) > '9'))) { StartChar++; }
 	if ((*StartChar) == '\0') return (NumErri64);
 	Num = strtoll(StartChar, &EndChar, 10);
 
@@ -25,6 +25,7 @@
 #include <stdint.h> 
 #include "Const.h"
 #include "WavIO.h"
+#include "WavRaster.h"
 
 //-------------------------------------------------------------------------
 // USER Definitions
@@ -34,7 +35,30 @@
 // USER CHOICE
 
 // Margin to improve reliability (normally only for Geneting wav for a physical DAI)
-#define WavOut_SmoothSignal 0 // Smooth signal to limit transition spikes, requires input signal to be higher
+// Edge shaping ('Ex' format option), samples following each transition, for the analog input stage of a physical DAI
+//	E0: None, levels of WavLevels_*[0] only
+//	E1: Soft, first sample after a transition at the lower level of WavLevels_*[1], limits transition spikes, requires input signal to be higher
+//	E2: Band limited, raised cosine rise over WavOut_EdgeRise_us (samples before its end), limits slew of the input stage
+//	E3: Pre-emphasis, levels of WavLevels_*[1] boosted after each transition by WavOut_EdgeBoost % of the step, decaying in WavOut_EdgeDecay_us
+enum WavOutEdge { WavOutEdge_None, WavOutEdge_Soft, WavOutEdge_BandLimited, WavOutEdge_PreEmphasis, WavOutEdge_Count };
+#define WavOut_EdgeRise_us 8.0
+#define WavOut_EdgeBoost 25
+#define WavOut_EdgeDecay_us 5.0
+
+// Automatic sample rate ('A' option): maximum difference in Cpu cycles of any DaiBit period vs the profile sampling frequency
+#define WavOut_AutoRateMaxError 16 // Half a K7 read loop
+
+// Shortest leader ('L' option): DaiBits added to the shortest leader found with the firmware model
+#define WavOut_MinLeaderMargin 2
+
+// Interrupt slack on leader ('R' option): DaiBits added after the last one read with interrupts enabled
+#define WavOut_IntSlackMargin 1
+
+// Fast DaiBits at every position ('Q' option, see OutBkDaiBitSpeeds / InBkDaiBitSpeeds)
+// 1: each program is read back with the WavIn firmware model, original positions are used if it fails
+#define WavOut_PosSpeedsCheck 1
+#define WavOut_CheckLeaderDaiBits 64 // Leader of the program read back, shorter than profile one to save time
+#define WavOut_CheckBlocks 1 // Blocks read back: speeds of following blocks are the original ones
 
 //-------------------------------------------------------------------------
 // Global constants 
@@ -50,9 +74,38 @@
 #define OptionBit_Frequency 0x10
 #define OptionBit_Periods 0x20
 #define OptionBit_InterDelays 0x40
+#define OptionBit_AutoRate 0x100
+#define OptionBit_MinLeader 0x200
+#define OptionBit_IntSlack 0x400
+#define OptionBit_Tune 0x800
+#define OptionBit_LoadTuned 0x1000
+#define OptionBit_LoadDelays 0x2000
+#define OptionBit_Grid 0x4000
 #define OptionBit_OptionArgument 0x8000 // An Options argument is present. Argument can however be invalid
+#define OptionBit_Playlist 0x10000
+#define OptionBit_Turbo 0x20000
+#define OptionBit_EdgeShape 0x40000
+#define OptionBit_FastPos 0x80000
 #define OptionBits_Users (OptionBit_Hardware|OptionBit_NChannels|OptionBit_NBytes|OptionBit_Parity)
 
+#define WavOut_FormatsMax 4 // Wav files written from a single timing pass, main format and additional '+' formats of options argument
+#define WavOut_IntSlackDelay (Rst6B_Clock_Delay + Rst7_Clock_Delay) // Interrupts triggered together ('R' option)
+#define WavOut_IntSlackIterMax 4 // Slack DaiBits are searched again until they cover the last wait with interrupts enabled
+#define WavOut_TuneOff (-1) // WavOut_TuneMargin when profile is not tuned ('T' option)
+
+
+//---------------
+// DaiBits speed per position with 'Q' option : DaiBitType_LowFast or DaiBitType_LowNorm
+// Without it, fast DaiBits are used only in blocks 1 and 2. Positions below are not read by every profile for every program
+// (V6, V7), each program is read back by the WavIn firmware model before they are used
+// { Leader, SyncByte, ProgByte, InBlock (see InBkDaiBitSpeeds), BlockCS0, BlockCSN, Trailer }
+static const uint8_t OutBkDaiBitSpeeds[PosInFile_Count] =
+	{ DaiBitType_LowNorm, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowNorm };
+// DataBlock x { LenH, LenL, LenCS, 1stByte, InData, LastByte }
+static const uint8_t InBkDaiBitSpeeds[DataBlock_Count][PosInBlock_Count] =
+{ {DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast},
+  {DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast},
+  {DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast, DaiBitType_LowFast} };
 
 //---------------
 // DaiHardware_Struct
@@ -189,24 +242,87 @@ const uint16_t WavLevels_2B[2][2] = { {(uint16_t)-28835,28835}, {(uint16_t)-2621
 const uint16_t WavLevels_1B[2][2] = { {0,255}, {50,208} }; //  {15,240} {50,208} or {26,230} // When samples are uint8_t type
 
 
+//---------------
+// WavOutEstimate_Struct, closed form of the wav of a program (see WavOut_Estimate)
+//---------------
+struct WavOutEstimate_Struct
+{
+	uint64_t Samples; // Per channel
+	uint64_t LoadSamples; // Per channel, up to the end of the last block checksum (program loaded)
+	uint64_t Cycles; // Cpu cycles of all DaiBits
+	uint32_t DaiBits;
+};
+
+
+//---------------
+// WavOutConfig_Struct, resolved encoder configuration : profile, wav formats and options (see WavOut_Config)
+// Encoder state (DaiBits cache, edges list, position) is per thread : each render thread installs the configuration
+// in its own state with WavOut_SetConfig, renders with different configurations can then run at the same time
+//---------------
+struct WavOutConfig_Struct
+{
+	uint16_t DaiHw;
+	struct DaiHardware_Struct Profile; // Copy of DaiHW_Profile[DaiHw], of a loaded one ('U' option) or of the tuned one
+	struct WavFormat_Struct Formats[WavOut_FormatsMax];
+	uint8_t FormatsCount;
+	bool MinLeader;
+	bool IntSlack;
+	bool FastPos;
+	int16_t TuneMargin;
+	bool LoadTuned;
+	bool LoadDelays;
+	bool Grid;
+	bool Playlist;
+	bool Turbo;
+	uint16_t InBkInterCallsDelays[DataBlock_Count][PosInBlock_Count];
+	uint16_t OutBkInterCallsDelays[ProgType_Count][PosInFile_Count];
+	char NameOptions[OptionsLenMax + 2];
+};
+
+
 //-------------------------------------------------------------------------
 // Global variables 
 //-------------------------------------------------------------------------
-extern int16_t PeriodsOffset_Delay[DaiBitPeriod_Count];
-extern int16_t InBkInterCallsDelaysMargin[PosInBlock_Count] ;
-extern int16_t OutBkInterCallsDelaysMargin[PosInFile_Count] ;
+extern thread_local int16_t PeriodsOffset_Delay[DaiBitPeriod_Count];
+extern thread_local int16_t InBkInterCallsDelaysMargin[PosInBlock_Count] ;
+extern thread_local int16_t OutBkInterCallsDelaysMargin[PosInFile_Count] ;
 
-extern struct WavHeader_Struct WavOutHeader;
-extern struct WavSubchunk_Struct WavOutSubChunks[NChunkMax];
+extern thread_local struct WavFormat_Struct WavOut_Formats[WavOut_FormatsMax]; // [0] main format, set by profile and options
+extern thread_local uint8_t WavOut_FormatsCount;
+extern thread_local bool WavOut_MinLeader;
+extern thread_local bool WavOut_IntSlack;
+extern thread_local bool WavOut_FastPos;
+extern thread_local bool WavOut_PosSpeeds;
+extern thread_local int16_t WavOut_TuneMargin; // Cpu cycles, WavOut_TuneOff if profile is not tuned
+extern thread_local bool WavOut_LoadTuned;
+extern thread_local bool WavOut_LoadDelays;
+extern thread_local bool WavOut_Grid;
+extern thread_local bool WavOut_Playlist;
+extern thread_local bool WavOut_Turbo;
+extern thread_local uint16_t WavOut_LeaderExtraDaiBits;
+extern thread_local struct DaiEdges_Struct WavOut_Edges; // DaiBits of the last program written
+extern thread_local const struct DaiHardware_Struct* WavOut_Profile; // Profile in use, DaiHW_Profile[Glob_DaiHw] or a tuned one
 
-extern char WavOut_NameOptions[OptionsLenMax+2];
+extern thread_local char WavOut_NameOptions[OptionsLenMax+2];
 
 //-------------------------------------------------------------------------
 // Global functions 
 //-------------------------------------------------------------------------
 
 int16_t DgvWavOut(char* WavFileName);
+int16_t DgvWavOutRasters(struct WavRaster_Struct* Rasters, uint8_t NRasters);
+int16_t WavOut_TimingPass(void);
 void Update_WavOut_NameOptions(char* Options);
-uint16_t LoadProgOptionsArgument(char* Options);
+void WavFormat_NameOptions(char* Options, const struct WavFormat_Struct* Format);
+uint32_t LoadProgOptionsArgument(char* Options);
+uint32_t WavOut_Config(uint16_t Hw, char* Options, struct WavOutConfig_Struct* Config);
+void WavOut_DefaultConfig(uint16_t Hw, struct WavOutConfig_Struct* Config);
+uint32_t WavOut_LoadOptions(char* Options, struct WavOutConfig_Struct* Config);
+void WavOut_ConfigNameOptions(char* Options, const struct WavOutConfig_Struct* Config, const struct WavFormat_Struct* Format);
+void WavOut_GetConfig(struct WavOutConfig_Struct* Config);
+void WavOut_SetConfig(const struct WavOutConfig_Struct* Config);
+int16_t WavOut_ReadBack(uint8_t BlocksCount);
+int16_t WriteShapeDaiBit(const uint16_t* Cycles);
+int16_t WavOut_Estimate(const struct WavFormat_Struct* Format, struct WavOutEstimate_Struct* Est);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,750 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavRaster.cpp
+***********************************************************************************/
+// Convert an edges list (DaiBits produced by the timing pass of WavOut) into wav files
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <thread>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavOut.h"
+#include "WavRaster.h"
+#include "WavCsw.h"
+#ifdef _WIN32
+	#include <io.h> // for _setmode
+	#include <fcntl.h> // for _O_BINARY
+#endif
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavRaster_BufferLen 0x10000 // Bytes written to file at once
+#define WavRaster_StreamBufferLen 0x1000 // Bytes written at once to standard output, small to start playing quickly
+#define WavRaster_ParallelMin 0x400000 // Samples bytes above which a wav file is mapped in memory and written by several threads
+#define WavRaster_ThreadsMax 16 // Threads writing the same wav file
+#define WavRaster_EdgeMax 32 // Maximum samples shaped after a transition (see WavRaster_EdgeKernel)
+
+// Sampling frequencies tried by WavRaster_AutoRate, increasing
+static const uint32_t WavRaster_AutoRates[] = { 22050, 24000, 32000, 44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000 };
+
+// State of one rasterization, a thread only uses its own
+struct WavRasterRun_Struct
+{
+	struct WavRaster_Struct* Raster;
+	const struct DaiEdges_Struct* Edges;
+	FILE* File;
+	bool Stream; // Wav is written to standard output
+	bool Csw; // Pulses are written in a csw file instead of samples (see WavRaster_Csw)
+	uint16_t Levels[2][2]; // Samples levels definitions, Levels[Smoothed][TTL level], inversion already applied
+	uint16_t EdgeLevels[2][WavRaster_EdgeMax]; // Levels of the first samples after a transition to each TTL level
+	uint16_t EdgeLen; // Samples of EdgeLevels used, at least 1
+	uint8_t Steady; // Index in Levels of the level following EdgeLevels
+	uint16_t* ShapeNSamples; // Samples (per channel) of each period of each shape, [ShapeI * DaiBitPeriod_Count + Period]
+	uint32_t* ShapeWavLen; // Length in bytes of each shape
+	uint8_t** ShapeWav; // Pre-rendered samples of each shape, NULL until first written
+	uint8_t* Buffer;
+	uint32_t BufferPos;
+	uint32_t BufferMax; // WavRaster_BufferLen, or WavRaster_StreamBufferLen when streaming
+	uint8_t NThreads; // Threads available to write this wav file
+	uint8_t* Map; // Samples of the wav file mapped in memory, when written by several threads
+};
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+void WavRaster_Run(struct WavRaster_Struct* Raster, const struct DaiEdges_Struct* Edges, uint8_t NThreads);
+int16_t WavRaster_Parallel(struct WavRasterRun_Struct* Run, uint32_t DataLen);
+void WavRaster_CopyBits(struct WavRasterRun_Struct* Run, uint32_t BitStart, uint32_t BitEnd, uint32_t Offset);
+int16_t WavRaster_Shapes(struct WavRasterRun_Struct* Run);
+void WavRaster_EdgeKernel(struct WavRasterRun_Struct* Run);
+int16_t WavRaster_RenderShape(struct WavRasterRun_Struct* Run, uint16_t ShapeI);
+uint32_t WavRaster_RenderSamples(struct WavRasterRun_Struct* Run, uint8_t* Dest, uint16_t Samples, uint8_t DaiBitPeriod);
+int16_t WavRaster_Csw(struct WavRasterRun_Struct* Run);
+int16_t WavRaster_WritePulse(struct WavRasterRun_Struct* Run, uint32_t Samples);
+int16_t WavRaster_Write(struct WavRasterRun_Struct* Run, const uint8_t* Data, uint32_t Len);
+int16_t WavRaster_Flush(struct WavRasterRun_Struct* Run);
+void WavRaster_Free(struct WavRasterRun_Struct* Run);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// WavRaster_Render 
+//-------------------------------------------------------------------------
+// Write one wav file per raster from the same edges list
+// Rasters are independent, each one is written by its own thread when there are several
+// Output : 0 or first negative error of rasters, error of each raster is in Rasters[i].NErr
+int16_t WavRaster_Render(struct WavRaster_Struct* Rasters, uint8_t NRasters, const struct DaiEdges_Struct* Edges)
+{
+	std::thread* Threads[WavOut_FormatsMax];
+	uint8_t RasterI;
+	uint32_t NThreads;
+	int16_t NErr = 0;
+
+	if ((NRasters == 0) || (NRasters > WavOut_FormatsMax)) return (-InvalidCmdOption);
+	for (RasterI = 0; RasterI < NRasters; RasterI++)
+	{
+		if (Rasters[RasterI].Format.AutoRate != 0)
+		{
+			Rasters[RasterI].Format.SamplingFq = WavRaster_AutoRate(&Rasters[RasterI].Format, Edges);
+		}
+	}
+
+	// Cores are shared between rasters
+	NThreads = std::thread::hardware_concurrency() / NRasters; // 0 if unknown
+	if (NThreads < 1) { NThreads = 1; }
+	if (NThreads > WavRaster_ThreadsMax) { NThreads = WavRaster_ThreadsMax; }
+
+	if (NRasters == 1)
+	{
+		WavRaster_Run(&Rasters[0], Edges, (uint8_t)NThreads);
+	}
+	else
+	{
+		for (RasterI = 0; RasterI < NRasters; RasterI++)
+		{
+			Threads[RasterI] = NULL;
+			try
+			{
+				Threads[RasterI] = new std::thread(WavRaster_Run, &Rasters[RasterI], Edges, (uint8_t)NThreads);
+			}
+			catch (...)
+			{
+				WavRaster_Run(&Rasters[RasterI], Edges, 1); // No thread available, raster is written now
+			}
+		}
+		for (RasterI = 0; RasterI < NRasters; RasterI++)
+		{
+			if (Threads[RasterI] != NULL)
+			{
+				Threads[RasterI]->join();
+				delete Threads[RasterI];
+			}
+		}
+	}
+
+	for (RasterI = 0; RasterI < NRasters; RasterI++)
+	{
+		if ((Rasters[RasterI].NErr < 0) && (NErr == 0)) { NErr = Rasters[RasterI].NErr; }
+	}
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Run 
+//-------------------------------------------------------------------------
+// Write a wav file from an edges list
+// Samples count is known before writing, so that the header is written once with its final size
+// Raster->FileName = WavOut_StdoutName ("-") streams the wav to standard output, header first
+// Large files are mapped in memory and written by NThreads threads (see WavRaster_Parallel)
+// A file name with WavCsw_Ext gets the pulses of the wav file instead of its samples (see WavRaster_Csw)
+void WavRaster_Run(struct WavRaster_Struct* Raster, const struct DaiEdges_Struct* Edges, uint8_t NThreads)
+{
+	struct WavRasterRun_Struct Run;
+	uint32_t BitI;
+	uint32_t NSamples;
+	uint16_t ShapeI;
+	uint8_t DaiBitPeriod;
+	int16_t NErr = 0;
+
+	memset(&Run, 0, sizeof(Run));
+	Run.Raster = Raster;
+	Run.Edges = Edges;
+	Run.Stream = (strcmp(Raster->FileName, WavOut_StdoutName) == 0);
+	Run.Csw = ((!Run.Stream) && (IsSameStringEnd(Raster->FileName, WavCsw_Ext)));
+	Run.BufferMax = (Run.Stream ? WavRaster_StreamBufferLen : WavRaster_BufferLen);
+	Run.NThreads = NThreads;
+	NErr = WavRaster_Shapes(&Run); if (NErr < 0) { goto WavRasterExit; }
+
+	// Samples count of all channels
+	NSamples = 0;
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		ShapeI = Edges->Bits[BitI];
+		for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+		{
+			NSamples += Run.ShapeNSamples[ShapeI * DaiBitPeriod_Count + DaiBitPeriod] * Raster->Format.NChannels;
+		}
+	}
+	Raster->NSamples = NSamples;
+
+	if (Run.Stream)
+	{
+		Run.File = stdout;
+		#ifdef _WIN32
+			_setmode(_fileno(stdout), _O_BINARY); // No '\n' translation
+		#endif
+	}
+	else
+	{
+		Run.File = fopen(Raster->FileName, "w+b"); // Read access is required to map the file
+	}
+	if (Run.File == NULL) { NErr = -WavOpenErr; goto WavRasterExit; }
+	if (Run.Csw)
+	{
+		NErr = WavRaster_Csw(&Run);
+		goto WavRasterExit;
+	}
+
+	NErr = CreateWavOut(Run.File, NSamples, Raster->Format.SamplingFq, Raster->Format.NChannels, Raster->Format.Bytes_per_sample);
+	if (NErr < 0) { goto WavRasterExit; }
+	if (Run.Stream)
+	{
+		if (fflush(Run.File) != 0) { NErr = -WavWriteErr; goto WavRasterExit; } // Player can start with the header
+	}
+	else if (PreallocateWavOut(Run.File, NSamples, Raster->Format.Bytes_per_sample) == 0) // Not mandatory, error is ignored
+	{
+		if ((Run.NThreads > 1) && (NSamples * Raster->Format.Bytes_per_sample >= WavRaster_ParallelMin))
+		{
+			NErr = WavRaster_Parallel(&Run, NSamples * Raster->Format.Bytes_per_sample);
+			if (NErr <= 0) { goto WavRasterExit; } // Written, or error
+			NErr = 0; // File can't be mapped, written sequentially
+		}
+	}
+
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		ShapeI = Edges->Bits[BitI];
+		if (Run.ShapeWav[ShapeI] == NULL)
+		{
+			NErr = WavRaster_RenderShape(&Run, ShapeI); if (NErr < 0) { goto WavRasterExit; }
+		}
+		NErr = WavRaster_Write(&Run, Run.ShapeWav[ShapeI], Run.ShapeWavLen[ShapeI]); if (NErr < 0) { goto WavRasterExit; }
+	}
+	NErr = WavRaster_Flush(&Run);
+
+WavRasterExit:
+	if (Run.Stream) { fflush(Run.File); }
+	else if (Run.File != NULL) { fclose(Run.File); }
+	WavRaster_Free(&Run);
+	Raster->NErr = NErr;
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Parallel 
+//-------------------------------------------------------------------------
+// Write samples of a wav file with several threads
+// Offset of each DaiBit in file is the sum of lengths of previous DaiBits, so DaiBits are split in ranges of same length
+// and each thread copies its range directly in the file mapped in memory
+// Input : header written, file size preallocated, DataLen = samples bytes
+// Output : 0, negative error, or 1 if the file can't be mapped (nothing written)
+int16_t WavRaster_Parallel(struct WavRasterRun_Struct* Run, uint32_t DataLen)
+{
+	const struct DaiEdges_Struct* Edges = Run->Edges;
+	std::thread* Threads[WavRaster_ThreadsMax];
+	uint32_t BitStart[WavRaster_ThreadsMax + 1];
+	uint32_t Offset[WavRaster_ThreadsMax + 1];
+	uint32_t HeaderLen = sizeof(WavHeader_Struct) + sizeof(WavSubchunk_Struct);
+	uint32_t BitI;
+	uint32_t Pos;
+	uint16_t ShapeI;
+	uint8_t ThreadI;
+	uint8_t NRanges;
+	void* MapHandle;
+	int16_t NErr = 0;
+
+	// Shapes are rendered before, threads only copy them
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		ShapeI = Edges->Bits[BitI];
+		if (Run->ShapeWav[ShapeI] == NULL)
+		{
+			NErr = WavRaster_RenderShape(Run, ShapeI); if (NErr < 0) { return (NErr); }
+		}
+	}
+
+	// Prefix sums : first DaiBit and its offset of each range
+	NRanges = 0;
+	Pos = 0;
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		if ((NRanges < Run->NThreads) && (Pos >= (uint64_t)DataLen * NRanges / Run->NThreads))
+		{
+			BitStart[NRanges] = BitI;
+			Offset[NRanges] = Pos;
+			NRanges++;
+		}
+		Pos += Run->ShapeWavLen[Edges->Bits[BitI]];
+	}
+	if (Pos != DataLen) return (-WavWriteErr); // Header would be wrong
+	BitStart[NRanges] = Edges->BitsCount;
+
+	Run->Map = MapWavOut(Run->File, HeaderLen + DataLen, &MapHandle);
+	if (Run->Map == NULL) return (1);
+
+	for (ThreadI = 0; ThreadI < NRanges; ThreadI++)
+	{
+		Threads[ThreadI] = NULL;
+		try
+		{
+			Threads[ThreadI] = new std::thread(WavRaster_CopyBits, Run, BitStart[ThreadI], BitStart[ThreadI + 1], HeaderLen + Offset[ThreadI]);
+		}
+		catch (...)
+		{
+			WavRaster_CopyBits(Run, BitStart[ThreadI], BitStart[ThreadI + 1], HeaderLen + Offset[ThreadI]); // No thread available, range is written now
+		}
+	}
+	for (ThreadI = 0; ThreadI < NRanges; ThreadI++)
+	{
+		if (Threads[ThreadI] != NULL)
+		{
+			Threads[ThreadI]->join();
+			delete Threads[ThreadI];
+		}
+	}
+
+	NErr = UnmapWavOut(Run->Map, HeaderLen + DataLen, MapHandle);
+	Run->Map = NULL;
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_CopyBits 
+//-------------------------------------------------------------------------
+// Copy samples of DaiBits [BitStart, BitEnd[ in the mapped file, from Offset
+void WavRaster_CopyBits(struct WavRasterRun_Struct* Run, uint32_t BitStart, uint32_t BitEnd, uint32_t Offset)
+{
+	uint32_t BitI;
+	uint16_t ShapeI;
+
+	for (BitI = BitStart; BitI < BitEnd; BitI++)
+	{
+		ShapeI = Run->Edges->Bits[BitI];
+		memcpy(Run->Map + Offset, Run->ShapeWav[ShapeI], Run->ShapeWavLen[ShapeI]);
+		Offset += Run->ShapeWavLen[ShapeI];
+	}
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Memory 
+//-------------------------------------------------------------------------
+// Render samples of an edges list in memory, without header (used to check timing with WavIn model)
+// Output : Wav allocated with samples (to be freed by caller), Len in bytes, 0 or negative error
+int16_t WavRaster_Memory(const struct WavFormat_Struct* Format, const struct DaiEdges_Struct* Edges, uint8_t** Wav, uint32_t* Len)
+{
+	struct WavRaster_Struct Raster;
+	struct WavRasterRun_Struct Run;
+	uint32_t BitI;
+	uint16_t ShapeI;
+	int16_t NErr;
+
+	*Wav = NULL;
+	*Len = 0;
+	memset(&Run, 0, sizeof(Run));
+	Raster.Format = *Format;
+	Raster.FileName[0] = '\0';
+	Run.Raster = &Raster;
+	Run.Edges = Edges;
+	Run.BufferMax = 1; // Not used
+	NErr = WavRaster_Shapes(&Run); if (NErr < 0) { goto WavMemoryExit; }
+
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		*Len += Run.ShapeWavLen[Edges->Bits[BitI]];
+	}
+	*Wav = (uint8_t*)malloc(*Len + 1);
+	if (*Wav == NULL) { NErr = -MemAllocErr; goto WavMemoryExit; }
+	*Len = 0;
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		ShapeI = Edges->Bits[BitI];
+		if (Run.ShapeWav[ShapeI] == NULL)
+		{
+			NErr = WavRaster_RenderShape(&Run, ShapeI); if (NErr < 0) { goto WavMemoryExit; }
+		}
+		memcpy(*Wav + *Len, Run.ShapeWav[ShapeI], Run.ShapeWavLen[ShapeI]);
+		*Len += Run.ShapeWavLen[ShapeI];
+	}
+
+WavMemoryExit:
+	if ((NErr < 0) && (*Wav != NULL)) { free(*Wav); *Wav = NULL; }
+	WavRaster_Free(&Run);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Shapes 
+//-------------------------------------------------------------------------
+// Allocate raster buffers, set levels, and samples count of each period of each shape
+int16_t WavRaster_Shapes(struct WavRasterRun_Struct* Run)
+{
+	const struct WavFormat_Struct* Format = &Run->Raster->Format;
+	uint16_t ShapesCount = Run->Edges->ShapesCount;
+	uint16_t ShapeI;
+	uint16_t Samples;
+	uint8_t DaiBitPeriod;
+	uint8_t Smoothed;
+	uint8_t TTL;
+
+	if ((Format->NChannels < 1) || (Format->NChannels > 2) || (Format->Bytes_per_sample < 1) || (Format->Bytes_per_sample > 2)) return (-InvalidCmdOption);
+
+	// Levels to change depending of type of wav file
+	for (Smoothed = 0; Smoothed < 2; Smoothed++)
+	{
+		for (TTL = 0; TTL < 2; TTL++)
+		{
+			Run->Levels[Smoothed][TTL ^ (Format->InvertSignal != 0)] = (Format->Bytes_per_sample == 2 ? WavLevels_2B[Smoothed][TTL] : WavLevels_1B[Smoothed][TTL]);
+		}
+	}
+	WavRaster_EdgeKernel(Run);
+
+	Run->Buffer = (uint8_t*)malloc(Run->BufferMax);
+	Run->ShapeNSamples = (uint16_t*)malloc(((size_t)ShapesCount + 1) * DaiBitPeriod_Count * sizeof(uint16_t));
+	Run->ShapeWavLen = (uint32_t*)malloc(((size_t)ShapesCount + 1) * sizeof(uint32_t));
+	Run->ShapeWav = (uint8_t**)calloc((size_t)ShapesCount + 1, sizeof(uint8_t*));
+	if ((Run->Buffer == NULL) || (Run->ShapeNSamples == NULL) || (Run->ShapeWavLen == NULL) || (Run->ShapeWav == NULL)) return (-MemAllocErr);
+
+	for (ShapeI = 0; ShapeI < ShapesCount; ShapeI++)
+	{
+		Run->ShapeWavLen[ShapeI] = 0;
+		for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+		{
+			Samples = WavRaster_SamplesMin(Run->Edges->Shapes[ShapeI].Cycles[DaiBitPeriod], Format->SamplingFq);
+			Run->ShapeNSamples[ShapeI * DaiBitPeriod_Count + DaiBitPeriod] = Samples;
+			Run->ShapeWavLen[ShapeI] += Samples * Format->NChannels * Format->Bytes_per_sample;
+		}
+	}
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_EdgeKernel 
+//-------------------------------------------------------------------------
+// Levels of the samples following a transition, computed once per raster from Format->EdgeShape (see WavOutEdge)
+// Sample k is taken at its center, (k + 0.5) / SamplingFq after the transition. Previous level is the steady one of the other TTL level
+void WavRaster_EdgeKernel(struct WavRasterRun_Struct* Run)
+{
+	const struct WavFormat_Struct* Format = &Run->Raster->Format;
+	bool Signed = (Format->Bytes_per_sample == 2);
+	double LevelMin = (Signed ? -32768.0 : 0.0);
+	double LevelMax = (Signed ? 32767.0 : 255.0);
+	double Prev;
+	double New;
+	double Time; // us
+	double Level;
+	uint16_t Sample;
+	uint16_t Len;
+	uint8_t TTL;
+
+	Run->Steady = (Format->EdgeShape == WavOutEdge_PreEmphasis);
+	Run->EdgeLen = 1;
+	for (TTL = 0; TTL < 2; TTL++)
+	{
+		Prev = (Signed ? (double)(int16_t)Run->Levels[Run->Steady][TTL ^ 1] : (double)Run->Levels[Run->Steady][TTL ^ 1]);
+		New = (Signed ? (double)(int16_t)Run->Levels[Run->Steady][TTL] : (double)Run->Levels[Run->Steady][TTL]);
+		Len = 0;
+		for (Sample = 0; Sample < WavRaster_EdgeMax; Sample++)
+		{
+			Time = (Sample + 0.5) * 1000000.0 / Format->SamplingFq;
+			if (Format->EdgeShape == WavOutEdge_Soft)
+			{
+				if (Sample != 0) break;
+				Level = (Signed ? (double)(int16_t)Run->Levels[1][TTL] : (double)Run->Levels[1][TTL]);
+			}
+			else if (Format->EdgeShape == WavOutEdge_BandLimited)
+			{
+				if (Time >= WavOut_EdgeRise_us) break;
+				Level = Prev + (New - Prev) * (0.5 - 0.5 * cos(3.14159265358979 * Time / WavOut_EdgeRise_us));
+			}
+			else if (Format->EdgeShape == WavOutEdge_PreEmphasis)
+			{
+				Level = (New - Prev) * WavOut_EdgeBoost / 100.0 * exp(-Time / WavOut_EdgeDecay_us);
+				if ((Level < 1.0) && (Level > -1.0)) break; // Boost below 1 LSB
+				Level += New;
+			}
+			else break;
+			Level = floor(Level + 0.5);
+			if (Level < LevelMin) { Level = LevelMin; }
+			if (Level > LevelMax) { Level = LevelMax; }
+			Run->EdgeLevels[TTL][Sample] = (uint16_t)(int32_t)Level;
+			Len++;
+		}
+		if (Len > Run->EdgeLen) { Run->EdgeLen = Len; }
+		for (Sample = Len; Sample < WavRaster_EdgeMax; Sample++)
+		{
+			Run->EdgeLevels[TTL][Sample] = Run->Levels[Run->Steady][TTL];
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_RenderShape 
+//-------------------------------------------------------------------------
+// Render samples of a DaiBit shape, done once per raster
+int16_t WavRaster_RenderShape(struct WavRasterRun_Struct* Run, uint16_t ShapeI)
+{
+	uint8_t DaiBitPeriod;
+	uint32_t WavLen;
+	uint8_t* Wav;
+
+	Wav = (uint8_t*)malloc(Run->ShapeWavLen[ShapeI] + 1); // + 1, a shape can't be empty but malloc(0) may return NULL
+	if (Wav == NULL) return (-MemAllocErr);
+	WavLen = 0;
+	for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+	{
+		WavLen += WavRaster_RenderSamples(Run, Wav + WavLen, Run->ShapeNSamples[ShapeI * DaiBitPeriod_Count + DaiBitPeriod], DaiBitPeriod);
+	}
+	Run->ShapeWav[ShapeI] = Wav;
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_AutoRate 
+//-------------------------------------------------------------------------
+// Select the lowest sampling frequency of WavRaster_AutoRates keeping the timing obtained with Format->SamplingFq
+// Each period of each DaiBit shape used by the program is rounded to samples with both frequencies,
+// durations must not differ by more than WavOut_AutoRateMaxError Cpu cycles. Nothing is rendered
+// Output : selected frequency, Format->SamplingFq if no lower one is valid
+uint32_t WavRaster_AutoRate(const struct WavFormat_Struct* Format, const struct DaiEdges_Struct* Edges)
+{
+	bool* Used;
+	uint64_t RefFq = Format->SamplingFq;
+	uint64_t Fq;
+	uint64_t RefSamples;
+	uint64_t Samples;
+	int64_t Diff;
+	uint32_t BitI;
+	uint16_t ShapeI;
+	uint16_t Cycles;
+	uint8_t DaiBitPeriod;
+	uint8_t RateI;
+	bool Valid = false;
+
+	Used = (bool*)calloc((size_t)Edges->ShapesCount + 1, sizeof(bool));
+	if (Used == NULL) return (Format->SamplingFq);
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		Used[Edges->Bits[BitI]] = true;
+	}
+
+	for (RateI = 0; (RateI < sizeof(WavRaster_AutoRates) / sizeof(WavRaster_AutoRates[0])) && (!Valid); RateI++)
+	{
+		Fq = WavRaster_AutoRates[RateI];
+		if (Fq >= RefFq) break;
+		Valid = true;
+		for (ShapeI = 0; (ShapeI < Edges->ShapesCount) && (Valid); ShapeI++)
+		{
+			if (!Used[ShapeI]) continue;
+			for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+			{
+				// |Samples / Fq - RefSamples / RefFq| * CpuFq <= WavOut_AutoRateMaxError
+				Cycles = Edges->Shapes[ShapeI].Cycles[DaiBitPeriod];
+				Samples = WavRaster_SamplesMin(Cycles, (uint32_t)Fq);
+				RefSamples = WavRaster_SamplesMin(Cycles, (uint32_t)RefFq);
+				Diff = (int64_t)(Samples * RefFq) - (int64_t)(RefSamples * Fq);
+				if (Diff < 0) { Diff = -Diff; }
+				if ((uint64_t)Diff * CpuFq > WavOut_AutoRateMaxError * Fq * RefFq)
+				{
+					Valid = false;
+					break;
+				}
+			}
+		}
+	}
+	free(Used);
+	return (Valid ? (uint32_t)Fq : Format->SamplingFq);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_SamplesMin
+//-------------------------------------------------------------------------
+// Calculates how many Samples should be written to catch start of next DaiBitPeriod
+uint16_t WavRaster_SamplesMin(uint16_t CyclesMin, uint32_t SamplingFq)
+{
+	uint64_t Samples;
+	Samples = ((uint64_t)CyclesMin * SamplingFq) / CpuFq;
+	if (((Samples * CpuFq) != ((uint64_t)CyclesMin * SamplingFq))||(Samples==0))
+	{
+		Samples++ ;
+	}
+	return ((uint16_t) Samples);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_RenderSamples 
+//-------------------------------------------------------------------------
+// Render samples of a DaiBit period (all channels) in memory
+// TTL level is Low for periods 0 and 2, High for periods 1 and 3
+// First EdgeLen samples after the transition are the shaped ones of WavRaster_EdgeKernel, following ones
+// are copied from the first steady sample, doubling the copied length each time
+// Output : count of bytes written in Dest
+uint32_t WavRaster_RenderSamples(struct WavRasterRun_Struct* Run, uint8_t* Dest, uint16_t Samples, uint8_t DaiBitPeriod)
+{
+	uint8_t NChannels = Run->Raster->Format.NChannels;
+	uint8_t Bytes_per_sample = Run->Raster->Format.Bytes_per_sample;
+	uint8_t TTL = DaiBitPeriod & 1;
+	uint16_t Sample;
+	int16_t WavLevel;
+	uint8_t Ch;
+	uint32_t Len = 0;
+	uint32_t Steady; // Position in Dest of the first steady sample
+	uint32_t Part;
+
+	for (Sample = 0; (Sample < Samples) && (Sample <= Run->EdgeLen); Sample++)
+	{
+		WavLevel = (Sample < Run->EdgeLen ? Run->EdgeLevels[TTL][Sample] : Run->Levels[Run->Steady][TTL]);
+		for (Ch = 0; Ch < NChannels; Ch++)
+		{
+			memcpy(Dest + Len, &WavLevel, Bytes_per_sample); // Little endian, as in wav files
+			Len += Bytes_per_sample;
+		}
+	}
+	if (Sample < Samples)
+	{
+		Steady = Len - NChannels * Bytes_per_sample;
+		Samples -= Sample;
+		while (Samples != 0)
+		{
+			Part = (Len - Steady) / (NChannels * Bytes_per_sample);
+			if (Part > Samples) { Part = Samples; }
+			memcpy(Dest + Len, Dest + Steady, Part * NChannels * Bytes_per_sample);
+			Len += Part * NChannels * Bytes_per_sample;
+			Samples -= (uint16_t)Part;
+		}
+	}
+	return (Len);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Csw 
+//-------------------------------------------------------------------------
+// Write a csw file from an edges list, at the sampling frequency of the format (see WavCsw)
+// Each period is one pulse of the samples count it has in the wav file. Channels, sample size and edge shaping do not apply
+int16_t WavRaster_Csw(struct WavRasterRun_Struct* Run)
+{
+	const struct DaiEdges_Struct* Edges = Run->Edges;
+	uint32_t BitI;
+	uint16_t ShapeI;
+	uint8_t DaiBitPeriod;
+	int16_t NErr;
+
+	// First period is TTL Low
+	NErr = WavCsw_WriteHeader(Run->File, Run->Raster->Format.SamplingFq, Edges->BitsCount * DaiBitPeriod_Count, Run->Raster->Format.InvertSignal != 0);
+	if (NErr < 0) return (NErr);
+	for (BitI = 0; BitI < Edges->BitsCount; BitI++)
+	{
+		ShapeI = Edges->Bits[BitI];
+		for (DaiBitPeriod = 0; DaiBitPeriod < DaiBitPeriod_Count; DaiBitPeriod++)
+		{
+			NErr = WavRaster_WritePulse(Run, Run->ShapeNSamples[ShapeI * DaiBitPeriod_Count + DaiBitPeriod]); if (NErr < 0) return (NErr);
+		}
+	}
+	return (WavRaster_Flush(Run));
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_WritePulse 
+//-------------------------------------------------------------------------
+// Adds a pulse of Samples to the output buffer of a csw file
+int16_t WavRaster_WritePulse(struct WavRasterRun_Struct* Run, uint32_t Samples)
+{
+	uint8_t Code[5];
+
+	return (WavRaster_Write(Run, Code, WavCsw_PulseCode(Samples, Code)));
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Write 
+//-------------------------------------------------------------------------
+// Adds samples to the output buffer, written to file when full
+int16_t WavRaster_Write(struct WavRasterRun_Struct* Run, const uint8_t* Data, uint32_t Len)
+{
+	uint32_t Part;
+
+	while (Len != 0)
+	{
+		if (Run->BufferPos >= Run->BufferMax)
+		{
+			if (WavRaster_Flush(Run) < 0) return (-WavWriteErr);
+		}
+		Part = Run->BufferMax - Run->BufferPos;
+		if (Part > Len) { Part = Len; }
+		memcpy(Run->Buffer + Run->BufferPos, Data, Part);
+		Run->BufferPos += Part;
+		Data += Part;
+		Len -= Part;
+	}
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Flush 
+//-------------------------------------------------------------------------
+// Write output buffer to file, and to the reading process when streaming
+int16_t WavRaster_Flush(struct WavRasterRun_Struct* Run)
+{
+	if ((Run->BufferPos != 0) && (fwrite(Run->Buffer, 1, Run->BufferPos, Run->File) != Run->BufferPos))
+	{
+		Run->BufferPos = 0;
+		return (-WavWriteErr);
+	}
+	Run->BufferPos = 0;
+	if ((Run->Stream) && (fflush(Run->File) != 0)) return (-WavWriteErr);
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavRaster_Free 
+//-------------------------------------------------------------------------
+// Release buffers of a raster
+void WavRaster_Free(struct WavRasterRun_Struct* Run)
+{
+	uint16_t ShapeI;
+
+	if (Run->ShapeWav != NULL)
+	{
+		for (ShapeI = 0; ShapeI < Run->Edges->ShapesCount; ShapeI++)
+		{
+			free(Run->ShapeWav[ShapeI]);
+		}
+	}
+	free(Run->ShapeWav);
+	free(Run->ShapeWavLen);
+	free(Run->ShapeNSamples);
+	free(Run->Buffer);
+}
@@ -0,0 +1,74 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVRASTER_H
+#define WAVRASTER_H
+#include <stdint.h> 
+#include "Const.h"
+#include "WavIO.h"
+
+
+//-------------------------------------------------------------------------
+// Edges list
+//-------------------------------------------------------------------------
+// The timing pass of the encoder (see WavOut) does not write samples, it produces a list of DaiBits
+// Each DaiBit refers to a DaiBit shape, which gives the minimum Cpu cycles of its 4 periods (see DaiBitPeriod)
+// TTL level is Low during periods 0 and 2, High during periods 1 and 3, a transition ends each period
+// Transition time is therefore the sum of all previous periods cycles, and does not depend on wav format
+//
+// A rasterizer converts an edges list into a wav file of a given format (WavFormat_Struct)
+// Several rasterizers can process the same edges list concurrently
+//
+#define WavOut_StdoutName "-" // Output file name to stream wav to standard output
+
+struct DaiBitShape_Struct
+{
+	uint16_t Cycles[DaiBitPeriod_Count]; // RequiredPeriodMinDelay of each period
+};
+
+struct DaiEdges_Struct
+{
+	const struct DaiBitShape_Struct* Shapes;
+	uint16_t ShapesCount;
+	uint16_t* Bits;		// Shape index of each DaiBit, in time order
+	uint32_t BitsCount;
+	uint32_t BitsMax;	// Allocated count of Bits
+};
+
+struct WavRaster_Struct
+{
+	struct WavFormat_Struct Format;
+	char FileName[MaxLenString + 1]; // WavOut_StdoutName to stream to standard output
+	uint32_t NSamples;	// Output : samples count of all channels
+	int16_t NErr;		// Output : 0 or negative error
+};
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t WavRaster_Render(struct WavRaster_Struct* Rasters, uint8_t NRasters, const struct DaiEdges_Struct* Edges);
+uint16_t WavRaster_SamplesMin(uint16_t CyclesMin, uint32_t SamplingFq);
+uint32_t WavRaster_AutoRate(const struct WavFormat_Struct* Format, const struct DaiEdges_Struct* Edges);
+int16_t WavRaster_Memory(const struct WavFormat_Struct* Format, const struct DaiEdges_Struct* Edges, uint8_t** Wav, uint32_t* Len);
+
+#endif
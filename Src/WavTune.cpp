@@ -0,0 +1,400 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavTune.cpp
+***********************************************************************************/
+// Tune the DaiBits timing of a profile for the program in memory, with the WavIn firmware model
+//
+// A candidate is rendered with each period shifted by +/- margin (WavTune_Shifts), margin stands for the hardware
+// differences to the firmware model (audio player, Dai input stage)
+// Candidates are the starting profile with one MinLoops decreased (offset of its period unchanged or increased), 
+// or one offset decreased. All of them are evaluated concurrently, the fastest one read back in all shifts is kept,
+// and candidates are generated again from it until none is faster
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavOut.h"
+#include "WavRaster.h"
+#include "DgvBatch.h"
+#include "WavTune.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavTune_Types (DaiBitType_HighNorm + 1) // DaiBitTypes tuned, data DaiBits only (timing of tails is approximative)
+#define WavTune_CandidatesMax (2 * WavTune_Types * DaiBitPeriod_Count + DaiBitPeriod_Count)
+#define WavTune_ValuesCount (DaiBitType_Count * DaiBitPeriod_Count + DaiBitPeriod_Count + 6) // Numbers of a DaiHW_Profile[] initializer
+
+// Shift of each period (x margin) the candidate must be read back with, first one is the nominal timing
+static const int8_t WavTune_Shifts[][DaiBitPeriod_Count] = { {0,0,0,0}, {1,-1,1,-1}, {-1,1,-1,1}, {1,1,1,1}, {-1,-1,-1,-1} };
+#define WavTune_ShiftsCount (sizeof(WavTune_Shifts) / sizeof(WavTune_Shifts[0]))
+
+struct WavTuneRun_Struct // Program and encoder configuration, copied by each candidate thread
+{
+	const struct DaiHardware_Struct* Base; // Profile tuning starts from
+	struct WavOutConfig_Struct Config;
+	struct DaiBlock_Struct Blocks[DataBlock_Count];
+	uint8_t ProgType;
+	int16_t Margin;
+};
+
+struct WavTuneJob_Struct
+{
+	const struct WavTuneRun_Struct* Run;
+	struct DaiHardware_Struct Profile;
+	uint64_t Cycles; // Output : Cpu cycles of the program with nominal timing
+	int16_t NErr; // Output : 0 if read back in all shifts
+};
+
+thread_local struct DaiHardware_Struct WavTune_Tuned;
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+int16_t WavTune_Margin(struct WavTuneRun_Struct* Run, struct WavTuneJob_Struct* Job);
+uint8_t WavTune_Candidates(const struct DaiHardware_Struct* From, const struct WavTuneRun_Struct* Run, struct WavTuneJob_Struct* Jobs);
+int16_t WavTune_Jobs(struct WavTuneJob_Struct* Jobs, uint8_t NJobs);
+int16_t WavTune_Job(const void* Context, uint32_t JobI);
+void WavTune_Eval(struct WavTuneJob_Struct* Job);
+uint64_t WavTune_Cycles(void);
+void WavTune_Print(FILE* File, const struct DaiHardware_Struct* Profile, int16_t Margin);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// DgvWavTune 
+//-------------------------------------------------------------------------
+// Tune WavOut_Profile for the program in memory and wav formats, read back with every period shifted by +/- Margin Cpu cycles
+// Tuned profile is printed, written in WavTune_FileName and set as WavOut_Profile (formats from WavOut_Formats[0])
+// If the profile is not read back with Margin, it is tuned with the largest margin it is read back with
+// Profile is unchanged if it is not read back even without margin
+// Output : 0 or negative error
+int16_t DgvWavTune(int16_t Margin)
+{
+	struct WavTuneRun_Struct Run;
+	struct WavTuneJob_Struct Best;
+	struct WavTuneJob_Struct* Jobs;
+	uint64_t BaseCycles;
+	uint8_t NJobs;
+	uint8_t JobI;
+	uint8_t Iter;
+	int16_t BestI;
+	int16_t NErr = 0;
+	FILE* File;
+
+	Jobs = (struct WavTuneJob_Struct*)malloc(WavTune_CandidatesMax * sizeof(struct WavTuneJob_Struct));
+	if (Jobs == NULL) return (-MemAllocErr);
+
+	Run.Base = WavOut_Profile;
+	WavOut_GetConfig(&Run.Config);
+	Run.Config.TuneMargin = WavOut_TuneOff;
+	memcpy(Run.Blocks, DaiBlocksInfo, sizeof(Run.Blocks));
+	Run.ProgType = Glob_ProgType;
+	Run.Margin = Margin;
+
+	Jobs[0].Run = &Run;
+	Jobs[0].Profile = *WavOut_Profile;
+	NErr = WavTune_Jobs(Jobs, 1); if (NErr < 0) { goto TuneExit; }
+	if (Jobs[0].NErr < 0)
+	{
+		NErr = WavTune_Margin(&Run, &Jobs[0]);
+		if (NErr < 0) { goto TuneExit; }
+		if (Run.Margin < 0)
+		{
+			fprintf(stderr, "Profile %s not read back by the firmware model, it is not tuned\n", WavOut_Profile->ProfileName);
+			goto TuneExit;
+		}
+		fprintf(stderr, "Profile %s not read back by the firmware model with a margin of %d Cpu cycles, tuned with a margin of %d\n",
+			WavOut_Profile->ProfileName, Margin, Run.Margin);
+	}
+	Best = Jobs[0];
+	BaseCycles = Best.Cycles;
+
+	for (Iter = 0; Iter < WavTune_IterMax; Iter++)
+	{
+		NJobs = WavTune_Candidates(&Best.Profile, &Run, Jobs);
+		NErr = WavTune_Jobs(Jobs, NJobs); if (NErr < 0) { goto TuneExit; }
+		BestI = -1;
+		for (JobI = 0; JobI < NJobs; JobI++)
+		{
+			if ((Jobs[JobI].NErr >= 0) && (Jobs[JobI].Cycles < (BestI < 0 ? Best.Cycles : Jobs[BestI].Cycles))) { BestI = JobI; }
+		}
+		if (BestI < 0) break;
+		Best = Jobs[BestI];
+		fprintf(stderr, "Generation %d of %d candidates, %.2fs shorter\n", Iter + 1, NJobs, (double)(BaseCycles - Best.Cycles) / CpuFq);
+	}
+
+	WavTune_Tuned = Best.Profile;
+	WavTune_Tuned.NChannels = WavOut_Formats[0].NChannels;
+	WavTune_Tuned.Bytes_per_sample = WavOut_Formats[0].Bytes_per_sample;
+	WavTune_Tuned.InvertSignal = WavOut_Formats[0].InvertSignal;
+	WavTune_Tuned.SamplingFq = WavOut_Formats[0].SamplingFq;
+	SetWavOutProfile(&WavTune_Tuned);
+
+	fprintf(stderr, "Tuned profile, %.2fs shorter (%d generations):\n", (double)(BaseCycles - Best.Cycles) / CpuFq, Iter);
+	WavTune_Print(stderr, &WavTune_Tuned, Run.Margin);
+	File = fopen(WavTune_FileName, "w");
+	if (File == NULL) { NErr = -FileParamErr; goto TuneExit; }
+	WavTune_Print(File, &WavTune_Tuned, Run.Margin);
+	fclose(File);
+
+TuneExit:
+	free(Jobs);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Margin 
+//-------------------------------------------------------------------------
+// Largest margin below Run->Margin the profile of Job is read back with (binary search)
+// Output : 0 or negative error, Run->Margin (-1 if not read back without margin) and Job evaluated with it
+int16_t WavTune_Margin(struct WavTuneRun_Struct* Run, struct WavTuneJob_Struct* Job)
+{
+	struct WavTuneJob_Struct Passed = *Job;
+	int16_t Low = -1; // Largest margin read back
+	int16_t High = Run->Margin; // Smallest margin not read back
+	int16_t NErr;
+
+	while (High - Low > 1)
+	{
+		Run->Margin = (Low + High) / 2;
+		NErr = WavTune_Jobs(Job, 1); if (NErr < 0) { return (NErr); }
+		if (Job->NErr < 0) { High = Run->Margin; continue; }
+		Low = Run->Margin;
+		Passed = *Job;
+	}
+	Run->Margin = Low;
+	*Job = Passed;
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Candidates 
+//-------------------------------------------------------------------------
+// Profiles one step faster than From, offsets stay within WavTune_OffsetMax of the starting profile
+// Output : count of candidates in Jobs
+uint8_t WavTune_Candidates(const struct DaiHardware_Struct* From, const struct WavTuneRun_Struct* Run, struct WavTuneJob_Struct* Jobs)
+{
+	uint8_t NJobs = 0;
+	uint8_t Type;
+	uint8_t Px;
+	int16_t Offset;
+
+	for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+	{
+		for (Type = 0; Type < WavTune_Types; Type++)
+		{
+			if (From->DaiBitPeriods_MinLoops[Type][Px] <= WavTune_LoopsMin) continue;
+			Jobs[NJobs].Profile = *From;
+			Jobs[NJobs].Profile.DaiBitPeriods_MinLoops[Type][Px]--;
+			NJobs++;
+			Offset = From->PeriodsOffset_HwDelay[Px] + WavTune_OffsetStep;
+			if (abs(Offset - Run->Base->PeriodsOffset_HwDelay[Px]) <= WavTune_OffsetMax)
+			{
+				Jobs[NJobs] = Jobs[NJobs - 1];
+				Jobs[NJobs].Profile.PeriodsOffset_HwDelay[Px] = Offset;
+				NJobs++;
+			}
+		}
+		Offset = From->PeriodsOffset_HwDelay[Px] - WavTune_OffsetStep;
+		if (abs(Offset - Run->Base->PeriodsOffset_HwDelay[Px]) <= WavTune_OffsetMax)
+		{
+			Jobs[NJobs].Profile = *From;
+			Jobs[NJobs].Profile.PeriodsOffset_HwDelay[Px] = Offset;
+			NJobs++;
+		}
+	}
+	for (uint8_t JobI = 0; JobI < NJobs; JobI++) { Jobs[JobI].Run = Run; }
+	return (NJobs);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Jobs 
+//-------------------------------------------------------------------------
+// Evaluate candidates on the threads of DgvBatch_Jobs, as many at once as cores (or DgvBatch_Threads)
+// Candidates have their own encoder and firmware model state. The calling thread can evaluate some of them,
+// its encoder configuration and edges list are restored
+// Output : 0 or negative error, result of each candidate is in Jobs[i].NErr and Jobs[i].Cycles
+int16_t WavTune_Jobs(struct WavTuneJob_Struct* Jobs, uint8_t NJobs)
+{
+	struct WavOutConfig_Struct Caller;
+	struct DaiEdges_Struct Edges;
+	uint64_t Sizes[WavTune_CandidatesMax];
+	uint8_t JobI;
+	int16_t NErr;
+
+	for (JobI = 0; JobI < NJobs; JobI++) { Sizes[JobI] = 1; } // Same cost, candidates keep their order
+	WavOut_GetConfig(&Caller);
+	Edges = WavOut_Edges;
+	memset(&WavOut_Edges, 0, sizeof(WavOut_Edges));
+	NErr = DgvBatch_Jobs(NJobs, Sizes, WavTune_Job, Jobs);
+	WavOut_Edges = Edges;
+	WavOut_SetConfig(&Caller);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Job 
+//-------------------------------------------------------------------------
+// Candidate JobI of Context (WavTune_Jobs candidates), on a thread of DgvBatch_Jobs
+// Output : 0, result of the candidate is in its NErr
+int16_t WavTune_Job(const void* Context, uint32_t JobI)
+{
+	struct WavTuneJob_Struct* Job = &((struct WavTuneJob_Struct*)Context)[JobI];
+
+	WavTune_Eval(Job);
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Eval 
+//-------------------------------------------------------------------------
+// Thread of a candidate: program is written with the candidate profile and read back with each shift of periods
+void WavTune_Eval(struct WavTuneJob_Struct* Job)
+{
+	const struct WavTuneRun_Struct* Run = Job->Run;
+	uint8_t ShiftI;
+	uint8_t Px;
+
+	memcpy(DaiBlocksInfo, Run->Blocks, sizeof(Run->Blocks));
+	Glob_ProgType = Run->ProgType;
+	WavOut_SetConfig(&Run->Config);
+	SetWavOutProfile(&Job->Profile);
+
+	Job->NErr = 0;
+	Job->Cycles = 0;
+	for (ShiftI = 0; (ShiftI < WavTune_ShiftsCount) && (Job->NErr >= 0); ShiftI++)
+	{
+		for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+		{
+			PeriodsOffset_Delay[Px] = Job->Profile.PeriodsOffset_HwDelay[Px] + WavTune_Shifts[ShiftI][Px] * Run->Margin;
+		}
+		Job->NErr = WavOut_ReadBack(DataBlock_Count);
+		if (ShiftI == 0) { Job->Cycles = WavTune_Cycles(); }
+	}
+	free(WavOut_Edges.Bits); // Edges of this thread, next candidate of the thread starts a new list
+	memset(&WavOut_Edges, 0, sizeof(WavOut_Edges));
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Cycles 
+//-------------------------------------------------------------------------
+// Cpu cycles of all DaiBits of WavOut_Edges
+uint64_t WavTune_Cycles(void)
+{
+	uint64_t Cycles = 0;
+	uint32_t BitI;
+	uint8_t Px;
+
+	for (BitI = 0; BitI < WavOut_Edges.BitsCount; BitI++)
+	{
+		for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+		{
+			Cycles += WavOut_Edges.Shapes[WavOut_Edges.Bits[BitI]].Cycles[Px];
+		}
+	}
+	return (Cycles);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Print 
+//-------------------------------------------------------------------------
+// Profile as a DaiHW_Profile[] initializer, read back by WavTune_Load
+void WavTune_Print(FILE* File, const struct DaiHardware_Struct* Profile, int16_t Margin)
+{
+	uint8_t Type;
+
+	fprintf(File, "\t{\t// Tuned by Dgv from V%d, margin of %d Cpu cycles\n", Glob_DaiHw, Margin);
+	fprintf(File, "\t\t\"%s\",\n\t\t{", Profile->ProfileName);
+	for (Type = 0; Type < DaiBitType_Count; Type++)
+	{
+		fprintf(File, "%s{%d,%d,%d,%d}", (Type == 0 ? "" : ((Type & 1) == 0 ? ", " : ",")),
+			Profile->DaiBitPeriods_MinLoops[Type][0], Profile->DaiBitPeriods_MinLoops[Type][1],
+			Profile->DaiBitPeriods_MinLoops[Type][2], Profile->DaiBitPeriods_MinLoops[Type][3]);
+	}
+	fprintf(File, "}, // DaiBitPeriods_MinLoops\n");
+	fprintf(File, "\t\t{%d,%d,%d,%d}, // PeriodsOffset_HwDelay\n", Profile->PeriodsOffset_HwDelay[0], Profile->PeriodsOffset_HwDelay[1],
+		Profile->PeriodsOffset_HwDelay[2], Profile->PeriodsOffset_HwDelay[3]);
+	fprintf(File, "\t\t%d,%d,%d,%lu, // NChannels, Bytes_per_sample, InvertSignal, SamplingFq\n", Profile->NChannels, Profile->Bytes_per_sample,
+		Profile->InvertSignal, (unsigned long)Profile->SamplingFq);
+	fprintf(File, "\t\t%d,%d // Leader_ms, Trailer_ms\n\t},\n", Profile->Leader_ms, Profile->Trailer_ms);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTune_Load 
+//-------------------------------------------------------------------------
+// Read a profile written by DgvWavTune (comments and name are skipped, name is the one of Profile)
+// Output : 0 or negative error, Profile is unchanged on error
+int16_t WavTune_Load(const char* FileName, struct DaiHardware_Struct* LoadedProfile)
+{
+	struct DaiHardware_Struct Profile;
+	long Values[WavTune_ValuesCount];
+	uint8_t ValueI = 0;
+	uint8_t Type;
+	uint8_t Px;
+
+	if (ReadNumbersFile(FileName, Values, WavTune_ValuesCount) < WavTune_ValuesCount) return (-FileParamErr);
+
+	Profile.ProfileName = LoadedProfile->ProfileName;
+	for (Type = 0; Type < DaiBitType_Count; Type++)
+	{
+		for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+		{
+			if ((Values[ValueI] < 0) || (Values[ValueI] > 255)) return (-FileParamErr); // DaiHW_Profile[] can hold periods without loops
+			Profile.DaiBitPeriods_MinLoops[Type][Px] = (uint8_t)Values[ValueI++];
+		}
+	}
+	for (Px = DaiBit_P0_TTLL; Px <= DaiBit_P3_TTLH; Px++)
+	{
+		Profile.PeriodsOffset_HwDelay[Px] = (int16_t)Values[ValueI++];
+	}
+	Profile.NChannels = (uint8_t)Values[ValueI++];
+	Profile.Bytes_per_sample = (uint8_t)Values[ValueI++];
+	Profile.InvertSignal = (uint8_t)Values[ValueI++];
+	Profile.SamplingFq = (uint32_t)Values[ValueI++];
+	Profile.Leader_ms = (uint16_t)Values[ValueI++];
+	Profile.Trailer_ms = (uint16_t)Values[ValueI++];
+	if ((Profile.NChannels < 1) || (Profile.NChannels > 2) || (Profile.Bytes_per_sample < 1) || (Profile.Bytes_per_sample > 2)
+		|| (Profile.SamplingFq < 20000) || (Profile.SamplingFq > 1000000) || (Profile.Leader_ms == 0)) return (-FileParamErr);
+
+	*LoadedProfile = Profile;
+	return (0);
+}
@@ -0,0 +1,50 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVTUNE_H
+#define WAVTUNE_H
+#include <stdint.h> 
+#include "Const.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Profile tuning ('T' option): DaiBitPeriods_MinLoops and PeriodsOffset_HwDelay of data DaiBits are decreased
+// while the program is still read back by the WavIn firmware model with every period shifted by +/- margin
+#define WavTune_MarginDefault 16 // Cpu cycles, when no value follows 'T' (half a K7 read loop), lowered to the one the profile is read back with
+#define WavTune_MarginMax 200
+#define WavTune_OffsetStep 7 // Cpu cycles tried on each period offset
+#define WavTune_OffsetMax 70 // Maximum change of a period offset vs the profile one
+#define WavTune_LoopsMin 1
+#define WavTune_IterMax 100 // Candidates generations, each one keeps the fastest candidate
+
+#define WavTune_FileName "DgvTuned.txt" // Tuned profile, written by 'T' and read by 'U', as a DaiHW_Profile[] initializer
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t DgvWavTune(int16_t Margin);
+int16_t WavTune_Load(const char* FileName, struct DaiHardware_Struct* LoadedProfile);
+
+#endif
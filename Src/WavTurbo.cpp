@@ -0,0 +1,585 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavTurbo.cpp
+***********************************************************************************/
+// Turbo loader output (see WavTurbo.h)
+// The loader is written by the normal encoder (WriteDaiProgram), the payload is appended to WavOut_Edges by WavTurbo_AddBit
+// Two bits of the payload make a DaiBit shape: periods 0 and 1 for the first bit, 2 and 3 for the second one
+// The payload is checked by an emulation of the 8080 instructions of the loader (WavTurbo_Emulate), from the rendered samples
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavOut.h"
+#include "WavRaster.h"
+#include "WavTurbo.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+// Loader, addresses are relative to the loader and relocated (WavTurbo_Relocs)
+// Each bit is counted down in C from the threshold, once per K7 read until TTL High then TTL Low are seen
+// Bit is 1 if C is negative (more reads than the threshold), it is shifted in B from the right
+static const uint8_t WavTurbo_LoaderCode[WavTurbo_LoaderSize] =
+{
+	0xF3,				// 00 DI
+	0x21,0x00,0xFD,		// 01 LXI H,K7Port
+	0x11,0x00,0x00,		// 04 LXI D,Start
+	0xAF,				// 07 XRA A
+	0x32,0x70,0x00,		// 08 STA CSum
+	0x47,				// 0B MOV B,A
+	0x0E,0x00,			// 0C SBIT: MVI C,Threshold
+	0x0D,				// 0E SLOW: DCR C
+	0x7E,				// 0F MOV A,M
+	0xB7,				// 10 ORA A
+	0xF2,0x0E,0x00,		// 11 JP SLOW
+	0x0D,				// 14 SHIGH: DCR C
+	0x7E,				// 15 MOV A,M
+	0xB7,				// 16 ORA A
+	0xFA,0x14,0x00,		// 17 JM SHIGH
+	0x79,				// 1A MOV A,C
+	0x17,				// 1B RAL
+	0x78,				// 1C MOV A,B
+	0x17,				// 1D RAL
+	0x47,				// 1E MOV B,A
+	0xFE,0x00,			// 1F CPI SyncByte
+	0xC2,0x0C,0x00,		// 21 JNZ SBIT
+	0x06,0x01,			// 24 BYTE: MVI B,1
+	0x0E,0x00,			// 26 DBIT: MVI C,Threshold
+	0x0D,				// 28 DLOW: DCR C
+	0x7E,				// 29 MOV A,M
+	0xB7,				// 2A ORA A
+	0xF2,0x28,0x00,		// 2B JP DLOW
+	0x0D,				// 2E DHIGH: DCR C
+	0x7E,				// 2F MOV A,M
+	0xB7,				// 30 ORA A
+	0xFA,0x2E,0x00,		// 31 JM DHIGH
+	0x79,				// 34 MOV A,C
+	0x17,				// 35 RAL
+	0x78,				// 36 MOV A,B
+	0x17,				// 37 RAL
+	0x47,				// 38 MOV B,A
+	0xD2,0x26,0x00,		// 39 JNC DBIT
+	0x12,				// 3C STAX D
+	0x13,				// 3D INX D
+	0x21,0x70,0x00,		// 3E LXI H,CSum
+	0x86,				// 41 ADD M
+	0x77,				// 42 MOV M,A
+	0x21,0x00,0xFD,		// 43 LXI H,K7Port
+	0x7B,				// 46 MOV A,E
+	0xFE,0x00,			// 47 CPI End & 0xFF
+	0xC2,0x24,0x00,		// 49 JNZ BYTE
+	0x7A,				// 4C MOV A,D
+	0xFE,0x00,			// 4D CPI End >> 8
+	0xC2,0x24,0x00,		// 4F JNZ BYTE
+	0x06,0x01,			// 52 MVI B,1
+	0x0E,0x00,			// 54 CBIT: MVI C,Threshold
+	0x0D,				// 56 CLOW: DCR C
+	0x7E,				// 57 MOV A,M
+	0xB7,				// 58 ORA A
+	0xF2,0x56,0x00,		// 59 JP CLOW
+	0x0D,				// 5C CHIGH: DCR C
+	0x7E,				// 5D MOV A,M
+	0xB7,				// 5E ORA A
+	0xFA,0x5C,0x00,		// 5F JM CHIGH
+	0x79,				// 62 MOV A,C
+	0x17,				// 63 RAL
+	0x78,				// 64 MOV A,B
+	0x17,				// 65 RAL
+	0x47,				// 66 MOV B,A
+	0xD2,0x54,0x00,		// 67 JNC CBIT
+	0x3A,0x70,0x00,		// 6A LDA CSum
+	0x90,				// 6D SUB B, A=0 if checksum is correct
+	0xFB,				// 6E EI
+	0xC9,				// 6F RET
+	0x00				// 70 CSum: sum of bytes
+};
+static const uint8_t WavTurbo_Relocs[] = { 0x09, 0x12, 0x18, 0x22, 0x2C, 0x32, 0x3A, 0x3F, 0x4A, 0x50, 0x5A, 0x60, 0x68, 0x6B };
+static const uint8_t WavTurbo_Thresholds[] = { 0x0D, 0x27, 0x55 };
+#define WavTurboLd_Start 0x05
+#define WavTurboLd_Sync 0x20
+#define WavTurboLd_EndL 0x48
+#define WavTurboLd_EndH 0x4E
+
+#define WavTurbo_PilotBitsMin 16
+#define WavTurbo_StackTop 0xF000 // Stack of the emulation, loader returns when it is back to it
+
+struct WavTurboCpu_Struct // Emulated 8080, only flags used by the loader
+{
+	uint8_t A, B, C, D, E, H, L;
+	bool S, Z, CY;
+	uint16_t PC, SP;
+	uint64_t Time; // Cpu cycles since first sample
+	uint8_t* Mem;
+	const uint8_t* Samples;
+	uint32_t NSamples; // Per channel
+	const struct WavFormat_Struct* Format;
+	bool EndOfSamples;
+};
+
+
+//-------------------------------------------------------------------------
+// Local variables
+//-------------------------------------------------------------------------
+thread_local char WavTurbo_Loader[WavTurbo_LoaderSize]; // Block 2 of the loader program
+thread_local char WavTurbo_Addr[2]; // Block 1 of the loader program
+thread_local uint16_t WavTurbo_Pending[2]; // Periods of a bit waiting for the second bit of its DaiBit shape
+thread_local bool WavTurbo_HasPending;
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+int16_t WavTurbo_Place(uint16_t Start, uint16_t Len, uint16_t* LoaderAddr);
+void WavTurbo_Loops(uint8_t Margin, uint8_t Loops[2][2], uint8_t* Threshold);
+void WavTurbo_SetLoader(uint16_t Start, uint16_t Len, uint16_t LoaderAddr, uint8_t Threshold);
+uint8_t WavTurbo_BlockCS(const char* Block, uint16_t Len);
+int16_t WavTurbo_WritePayload(const uint8_t* Data, uint16_t Start, uint16_t Len, const uint8_t Loops[2][2]);
+int16_t WavTurbo_WriteByte(uint8_t DataByte, uint16_t FirstCycles, const uint8_t Loops[2][2]);
+int16_t WavTurbo_AddBit(uint16_t ProcessCycles, uint8_t BitVal, const uint8_t Loops[2][2]);
+int16_t WavTurbo_Check(uint32_t FirstBit, const uint8_t* Data, uint16_t Start, uint16_t Len, uint16_t LoaderAddr);
+int16_t WavTurbo_Emulate(struct WavTurboCpu_Struct* Cpu);
+uint8_t WavTurbo_Read(struct WavTurboCpu_Struct* Cpu, uint16_t Addr);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// WavTurbo_TimingPass 
+//-------------------------------------------------------------------------
+// Timing pass of a binary program with its turbo loader, in WavOut_Edges (see WavOut_TimingPass)
+// Other programs are written normally. Program in memory is unchanged
+// Output : 0 or negative error
+int16_t WavTurbo_TimingPass(void)
+{
+	struct DaiBlock_Struct Program[DataBlock_Count];
+	const struct DaiHardware_Struct* Profile = WavOut_Profile;
+	uint8_t ProgType = Glob_ProgType;
+	uint8_t Loops[2][2];
+	uint8_t Threshold;
+	uint8_t Margin;
+	uint16_t Start;
+	uint16_t Len;
+	uint16_t LoaderAddr;
+	uint32_t FirstBit;
+	int16_t NErr = 0;
+
+	if ((Glob_ProgType != WavTurbo_ProgType) || (DaiBlocksInfo[1].Len < 2) || (DaiBlocksInfo[2].Len == 0))
+	{
+		fprintf(stderr, "Turbo loader only for binary programs, program is written normally\n");
+		return (WavOut_TimingPass());
+	}
+	Start = (uint16_t)((uint8_t)DaiBlocksInfo[1].Block[0] | ((uint8_t)DaiBlocksInfo[1].Block[1] << 8));
+	Len = DaiBlocksInfo[2].Len;
+	if ((uint32_t)Start + Len > 0x10000) { return (-InvalidDaiDataErr); }
+	NErr = WavTurbo_Place(Start, Len, &LoaderAddr); if (NErr < 0) { return (NErr); }
+
+	memcpy(Program, DaiBlocksInfo, sizeof(Program));
+	for (Margin = WavTurbo_MarginLoops; Margin <= WavTurbo_MarginLoops + WavTurbo_RetryMax; Margin++)
+	{
+		if (WavOut_Profile != Profile) { SetWavOutProfile(Profile); } // Tuned again with the new loader
+		WavTurbo_Loops(Margin, Loops, &Threshold);
+		WavTurbo_SetLoader(Start, Len, LoaderAddr, Threshold);
+		NErr = WavOut_TimingPass(); if (NErr < 0) { break; }
+		FirstBit = WavOut_Edges.BitsCount;
+		NErr = WavTurbo_WritePayload((const uint8_t*)Program[2].Block, Start, Len, Loops); if (NErr < 0) { break; }
+		NErr = WavTurbo_Check(FirstBit, (const uint8_t*)Program[2].Block, Start, Len, LoaderAddr);
+		if (NErr >= 0) { break; }
+		fprintf(stderr, "Turbo payload not read back by the loader model (%d), margin of %d loops\n", NErr, Margin + 1);
+	}
+	memcpy(DaiBlocksInfo, Program, sizeof(Program));
+	Glob_ProgType = ProgType;
+	if (NErr >= 0)
+	{
+		fprintf(stderr, "Turbo loader at 0x%04X, to be started during the %d ms pilot, program at 0x%04X-0x%04X\n",
+			LoaderAddr, WavTurbo_Pilot_ms, Start, Start + Len - 1);
+	}
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_Place 
+//-------------------------------------------------------------------------
+// Loader address, WavTurbo_LoaderAddr unless it overlaps the program, then just after or just before it
+// Output : 0 or negative error if loader does not fit in WavTurbo_RamMin - WavTurbo_RamMax
+int16_t WavTurbo_Place(uint16_t Start, uint16_t Len, uint16_t* LoaderAddr)
+{
+	uint32_t End = (uint32_t)Start + Len;
+
+	if ((WavTurbo_LoaderAddr + WavTurbo_LoaderSize <= Start) || (WavTurbo_LoaderAddr >= End))
+	{
+		*LoaderAddr = WavTurbo_LoaderAddr;
+	}
+	else if (End + WavTurbo_LoaderSize <= WavTurbo_RamMax)
+	{
+		*LoaderAddr = (uint16_t)End;
+	}
+	else if (Start >= WavTurbo_RamMin + WavTurbo_LoaderSize)
+	{
+		*LoaderAddr = (uint16_t)(Start - WavTurbo_LoaderSize);
+	}
+	else
+	{
+		return (-InvalidDaiDataErr);
+	}
+	return (0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_Loops 
+//-------------------------------------------------------------------------
+// Loops of each bit value Loops[BitVal][TTL Low / TTL High], and threshold of the loader
+// A bit of 0 is read in 2 K7 reads (Low, then High and Low). Each edge can be seen up to LateReads reads late,
+// as a period may be longer by a sample (lowest sampling frequency of wav formats), and the next bit reads are counted from it
+// Bits of 1 are read in 2*LateReads+1 more reads than bits of 0, plus twice the margin loops
+void WavTurbo_Loops(uint8_t Margin, uint8_t Loops[2][2], uint8_t* Threshold)
+{
+	uint32_t SamplingFq = UINT32_MAX;
+	uint32_t SampleCycles;
+	uint8_t LateReads;
+	uint8_t FormatI;
+
+	for (FormatI = 0; FormatI < WavOut_FormatsCount; FormatI++)
+	{
+		if (WavOut_Formats[FormatI].SamplingFq < SamplingFq) { SamplingFq = WavOut_Formats[FormatI].SamplingFq; }
+	}
+	SampleCycles = (uint32_t)((CpuFq + SamplingFq - 1) / SamplingFq);
+	LateReads = 1;
+	if (2 * SampleCycles > WavTurbo_ReadPhase + WavTurbo_LoopCycles)
+	{
+		LateReads = (uint8_t)((2 * SampleCycles - WavTurbo_ReadPhase + WavTurbo_LoopCycles - 1) / WavTurbo_LoopCycles);
+	}
+	LateReads += Margin;
+	Loops[0][0] = 0;
+	Loops[0][1] = 0;
+	Loops[1][0] = LateReads;
+	Loops[1][1] = LateReads + 1;
+	*Threshold = 2 + LateReads;
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_SetLoader 
+//-------------------------------------------------------------------------
+// Loader program in DaiBlocksInfo (name of the program is kept) and Glob_ProgType
+void WavTurbo_SetLoader(uint16_t Start, uint16_t Len, uint16_t LoaderAddr, uint8_t Threshold)
+{
+	uint16_t End = (uint16_t)(Start + Len);
+	uint16_t Addr;
+	uint8_t I;
+
+	memcpy(WavTurbo_Loader, WavTurbo_LoaderCode, WavTurbo_LoaderSize);
+	for (I = 0; I < sizeof(WavTurbo_Relocs); I++)
+	{
+		Addr = (uint16_t)((uint8_t)WavTurbo_Loader[WavTurbo_Relocs[I]] | ((uint8_t)WavTurbo_Loader[WavTurbo_Relocs[I] + 1] << 8)) + LoaderAddr;
+		WavTurbo_Loader[WavTurbo_Relocs[I]] = (char)(Addr & 0xFF);
+		WavTurbo_Loader[WavTurbo_Relocs[I] + 1] = (char)(Addr >> 8);
+	}
+	for (I = 0; I < sizeof(WavTurbo_Thresholds); I++) { WavTurbo_Loader[WavTurbo_Thresholds[I]] = (char)Threshold; }
+	WavTurbo_Loader[WavTurboLd_Start] = (char)(Start & 0xFF);
+	WavTurbo_Loader[WavTurboLd_Start + 1] = (char)(Start >> 8);
+	WavTurbo_Loader[WavTurboLd_Sync] = (char)WavTurbo_SyncByte;
+	WavTurbo_Loader[WavTurboLd_EndL] = (char)(End & 0xFF);
+	WavTurbo_Loader[WavTurboLd_EndH] = (char)(End >> 8);
+
+	WavTurbo_Addr[0] = (char)(LoaderAddr & 0xFF);
+	WavTurbo_Addr[1] = (char)(LoaderAddr >> 8);
+	DaiBlocksInfo[1].Len = sizeof(WavTurbo_Addr);
+	DaiBlocksInfo[1].LenCS = DaiWordCheckSum(DaiBlocksInfo[1].Len);
+	DaiBlocksInfo[1].Block = WavTurbo_Addr;
+	DaiBlocksInfo[1].BlockCS = WavTurbo_BlockCS(WavTurbo_Addr, DaiBlocksInfo[1].Len);
+	DaiBlocksInfo[2].Len = WavTurbo_LoaderSize;
+	DaiBlocksInfo[2].LenCS = DaiWordCheckSum(DaiBlocksInfo[2].Len);
+	DaiBlocksInfo[2].Block = WavTurbo_Loader;
+	DaiBlocksInfo[2].BlockCS = WavTurbo_BlockCS(WavTurbo_Loader, DaiBlocksInfo[2].Len);
+	Glob_ProgType = WavTurbo_ProgType;
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_BlockCS 
+//-------------------------------------------------------------------------
+// DAI checksum of a block (see ReadBinDataAndCheck)
+uint8_t WavTurbo_BlockCS(const char* Block, uint16_t Len)
+{
+	uint8_t ChkSum = 0x56;
+	uint16_t DataI;
+
+	for (DataI = 0; DataI < Len; DataI++) { ChkSum = DaiByteCheckSum((uint8_t)Block[DataI], ChkSum); }
+	return (ChkSum);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_WritePayload 
+//-------------------------------------------------------------------------
+// Append pilot, SyncByte, program bytes, checksum (sum of bytes) and 2 tail bits to WavOut_Edges
+// Delay before the first bit of each byte depends on the path taken by the loader (see WavTurbo_LoaderCode)
+// Output : 0 or negative error
+int16_t WavTurbo_WritePayload(const uint8_t* Data, uint16_t Start, uint16_t Len, const uint8_t Loops[2][2])
+{
+	uint32_t PilotBits;
+	uint32_t BitI;
+	uint16_t End = (uint16_t)(Start + Len);
+	uint16_t Addr;
+	uint16_t FirstCycles = WavTurbo_DataStartCycles;
+	uint8_t Sum = 0;
+	int16_t NErr = 0;
+
+	WavTurbo_HasPending = false;
+	PilotBits = (uint32_t)((uint64_t)WavTurbo_Pilot_ms * CpuFq / 1000 / (WavTurbo_SyncCycles + WavTurbo_LoopCycles * (Loops[0][0] + Loops[0][1] + 1)));
+	if (PilotBits < WavTurbo_PilotBitsMin) { PilotBits = WavTurbo_PilotBitsMin; }
+	PilotBits &= ~(uint32_t)1; // Pilot and SyncByte fill whole DaiBit shapes
+	for (BitI = 0; (BitI < PilotBits) && (NErr >= 0); BitI++)
+	{
+		NErr = WavTurbo_AddBit(WavTurbo_SyncCycles, 0, Loops);
+	}
+	for (BitI = 0; (BitI < 8) && (NErr >= 0); BitI++)
+	{
+		NErr = WavTurbo_AddBit(WavTurbo_SyncCycles, (WavTurbo_SyncByte >> (7 - BitI)) & 1, Loops);
+	}
+	for (Addr = Start; (Addr != End) && (NErr >= 0); )
+	{
+		NErr = WavTurbo_WriteByte(Data[Addr - Start], FirstCycles, Loops);
+		Sum += Data[Addr - Start];
+		Addr++;
+		FirstCycles = ((Addr & 0xFF) != (End & 0xFF) ? WavTurbo_NextByteCycles : WavTurbo_NextPageCycles);
+	}
+	if (NErr >= 0) { NErr = WavTurbo_WriteByte(Sum, FirstCycles, Loops); }
+	if (NErr >= 0) { NErr = WavTurbo_AddBit(WavTurbo_InByteCycles, 0, Loops); } // Last edge of the checksum
+	if (NErr >= 0) { NErr = WavTurbo_AddBit(WavTurbo_InByteCycles, 0, Loops); }
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_WriteByte 
+//-------------------------------------------------------------------------
+// Bits of a byte, bit 7 first
+int16_t WavTurbo_WriteByte(uint8_t DataByte, uint16_t FirstCycles, const uint8_t Loops[2][2])
+{
+	uint8_t BitMask;
+	int16_t NErr = 0;
+
+	for (BitMask = 0x80; (BitMask != 0) && (NErr >= 0); BitMask = BitMask >> 1)
+	{
+		NErr = WavTurbo_AddBit(FirstCycles, (DataByte & BitMask) != 0, Loops);
+		FirstCycles = WavTurbo_InByteCycles;
+	}
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_AddBit 
+//-------------------------------------------------------------------------
+// A bit is a TTL Low period then a TTL High period, written with the next bit as a DaiBit shape
+// The loader reads the K7 port ProcessCycles after the previous TTL Low is seen, then every WavTurbo_LoopCycles
+// Each edge is placed WavTurbo_ReadPhase before the read which has to see it, after Loops[BitVal][0] reads of TTL Low
+// and Loops[BitVal][1] reads of TTL High. Profile offsets are not added: the loader only counts reads between TTL Low edges
+// Output : 0 or negative error
+int16_t WavTurbo_AddBit(uint16_t ProcessCycles, uint8_t BitVal, const uint8_t Loops[2][2])
+{
+	uint16_t Cycles[DaiBitPeriod_Count];
+	uint16_t Period[2];
+
+	Period[0] = ProcessCycles + WavTurbo_LoopCycles * Loops[BitVal][0];
+	Period[1] = WavTurbo_LoopCycles * (Loops[BitVal][1] + 1);
+	if (!WavTurbo_HasPending)
+	{
+		WavTurbo_Pending[0] = Period[0];
+		WavTurbo_Pending[1] = Period[1];
+		WavTurbo_HasPending = true;
+		return (0);
+	}
+	Cycles[DaiBit_P0_TTLL] = WavTurbo_Pending[0];
+	Cycles[DaiBit_P1_TTLH] = WavTurbo_Pending[1];
+	Cycles[DaiBit_P2_TTLL] = Period[0];
+	Cycles[DaiBit_P3_TTLH] = Period[1];
+	WavTurbo_HasPending = false;
+	return (WriteShapeDaiBit(Cycles));
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_Check 
+//-------------------------------------------------------------------------
+// Payload (from DaiBit FirstBit of WavOut_Edges) is rendered for every wav format, and read by the loader emulation
+// started at the beginning of the pilot
+// Output : 0 if the program is loaded with a correct checksum for every format, negative error otherwise
+int16_t WavTurbo_Check(uint32_t FirstBit, const uint8_t* Data, uint16_t Start, uint16_t Len, uint16_t LoaderAddr)
+{
+	struct WavTurboCpu_Struct Cpu;
+	struct WavFormat_Struct Format;
+	struct DaiEdges_Struct Edges;
+	uint8_t* Wav = NULL;
+	uint8_t* Mem;
+	uint32_t WavLen;
+	uint8_t FormatI;
+	int16_t NErr = 0;
+
+	Mem = (uint8_t*)malloc(0x10000);
+	if (Mem == NULL) { return (-MemAllocErr); }
+	Edges = WavOut_Edges;
+	Edges.Bits = WavOut_Edges.Bits + FirstBit;
+	Edges.BitsCount = WavOut_Edges.BitsCount - FirstBit;
+	Edges.BitsMax = Edges.BitsCount;
+
+	for (FormatI = 0; (FormatI < WavOut_FormatsCount) && (NErr >= 0); FormatI++)
+	{
+		Format = WavOut_Formats[FormatI];
+		if (Format.AutoRate != 0)
+		{
+			Format.SamplingFq = WavRaster_AutoRate(&Format, &WavOut_Edges);
+			Format.AutoRate = 0;
+		}
+		NErr = WavRaster_Memory(&Format, &Edges, &Wav, &WavLen); if (NErr < 0) { break; }
+
+		memset(Mem, 0, 0x10000);
+		memcpy(Mem + LoaderAddr, WavTurbo_Loader, WavTurbo_LoaderSize);
+		memset(&Cpu, 0, sizeof(Cpu));
+		Cpu.PC = LoaderAddr;
+		Cpu.SP = WavTurbo_StackTop;
+		Cpu.Mem = Mem;
+		Cpu.Samples = Wav;
+		Cpu.NSamples = WavLen / (Format.NChannels * Format.Bytes_per_sample);
+		Cpu.Format = &Format;
+		NErr = WavTurbo_Emulate(&Cpu);
+		if ((NErr >= 0) && (Cpu.A != 0)) { NErr = -WavInBlockCSErr; }
+		if ((NErr >= 0) && (memcmp(Mem + Start, Data, Len) != 0)) { NErr = -WavReadBlockErr; }
+		free(Wav);
+	}
+	free(Mem);
+	return (NErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_Emulate 
+//-------------------------------------------------------------------------
+// Run the loader on an emulated 8080 until it returns, with the instructions it uses only
+// K7 port is read at the end of the instruction, from the sample at Cpu->Time
+// Output : 0 when loader has returned, negative error otherwise
+int16_t WavTurbo_Emulate(struct WavTurboCpu_Struct* Cpu)
+{
+	uint8_t* Mem = Cpu->Mem;
+	uint8_t Op;
+	uint8_t Val;
+	uint16_t Addr;
+	uint16_t Res;
+
+	while (!Cpu->EndOfSamples)
+	{
+		Op = Mem[Cpu->PC++];
+		Addr = (uint16_t)(Mem[Cpu->PC] | (Mem[(uint16_t)(Cpu->PC + 1)] << 8)); // Operand of 3 bytes instructions
+		switch (Op)
+		{
+		case 0x00: Cpu->Time += 4; break; // NOP
+		case 0xF3: case 0xFB: Cpu->Time += 4; break; // DI, EI
+		case 0x21: Cpu->Time += 10; Cpu->H = (uint8_t)(Addr >> 8); Cpu->L = (uint8_t)Addr; Cpu->PC += 2; break; // LXI H
+		case 0x11: Cpu->Time += 10; Cpu->D = (uint8_t)(Addr >> 8); Cpu->E = (uint8_t)Addr; Cpu->PC += 2; break; // LXI D
+		case 0x32: Cpu->Time += 13; Mem[Addr] = Cpu->A; Cpu->PC += 2; break; // STA
+		case 0x3A: Cpu->Time += 13; Cpu->A = WavTurbo_Read(Cpu, Addr); Cpu->PC += 2; break; // LDA
+		case 0x06: Cpu->Time += 7; Cpu->B = Mem[Cpu->PC++]; break; // MVI B
+		case 0x0E: Cpu->Time += 7; Cpu->C = Mem[Cpu->PC++]; break; // MVI C
+		case 0x0D: Cpu->Time += 5; Cpu->C--; Cpu->S = ((Cpu->C & 0x80) != 0); Cpu->Z = (Cpu->C == 0); break; // DCR C
+		case 0x47: Cpu->Time += 5; Cpu->B = Cpu->A; break; // MOV B,A
+		case 0x78: Cpu->Time += 5; Cpu->A = Cpu->B; break; // MOV A,B
+		case 0x79: Cpu->Time += 5; Cpu->A = Cpu->C; break; // MOV A,C
+		case 0x7A: Cpu->Time += 5; Cpu->A = Cpu->D; break; // MOV A,D
+		case 0x7B: Cpu->Time += 5; Cpu->A = Cpu->E; break; // MOV A,E
+		case 0x7E: Cpu->Time += 7; Cpu->A = WavTurbo_Read(Cpu, (uint16_t)((Cpu->H << 8) | Cpu->L)); break; // MOV A,M
+		case 0x77: Cpu->Time += 7; Mem[(uint16_t)((Cpu->H << 8) | Cpu->L)] = Cpu->A; break; // MOV M,A
+		case 0x12: Cpu->Time += 7; Mem[(uint16_t)((Cpu->D << 8) | Cpu->E)] = Cpu->A; break; // STAX D
+		case 0x13: Cpu->Time += 5; if (++Cpu->E == 0) { Cpu->D++; } break; // INX D
+		case 0x17: // RAL
+			Cpu->Time += 4;
+			Val = (uint8_t)((Cpu->A << 1) | (Cpu->CY ? 1 : 0));
+			Cpu->CY = ((Cpu->A & 0x80) != 0);
+			Cpu->A = Val;
+			break;
+		case 0xAF: case 0xB7: case 0x86: case 0x90: case 0xFE: // XRA A, ORA A, ADD M, SUB B, CPI
+			if (Op == 0xAF) { Cpu->Time += 4; Res = 0; }
+			else if (Op == 0xB7) { Cpu->Time += 4; Res = Cpu->A; }
+			else if (Op == 0x86) { Cpu->Time += 7; Res = Cpu->A + WavTurbo_Read(Cpu, (uint16_t)((Cpu->H << 8) | Cpu->L)); }
+			else if (Op == 0x90) { Cpu->Time += 4; Res = (uint16_t)(Cpu->A - Cpu->B); }
+			else { Cpu->Time += 7; Res = (uint16_t)(Cpu->A - Mem[Cpu->PC++]); }
+			Cpu->CY = ((Res & 0x100) != 0);
+			Cpu->S = ((Res & 0x80) != 0);
+			Cpu->Z = ((Res & 0xFF) == 0);
+			if (Op != 0xFE) { Cpu->A = (uint8_t)Res; }
+			break;
+		case 0xC2: case 0xD2: case 0xF2: case 0xFA: // JNZ, JNC, JP, JM
+			Cpu->Time += 10;
+			if (((Op == 0xC2) && (!Cpu->Z)) || ((Op == 0xD2) && (!Cpu->CY)) || ((Op == 0xF2) && (!Cpu->S)) || ((Op == 0xFA) && (Cpu->S))) { Cpu->PC = Addr; }
+			else { Cpu->PC += 2; }
+			break;
+		case 0xC9: // RET, loader is done when stack is back to its initial value
+			Cpu->Time += 10;
+			if (Cpu->SP == WavTurbo_StackTop) { return (0); }
+			Cpu->PC = (uint16_t)(Mem[Cpu->SP] | (Mem[(uint16_t)(Cpu->SP + 1)] << 8));
+			Cpu->SP += 2;
+			break;
+		default:
+			return (-InvalidDaiDataErr);
+		}
+	}
+	return (-EndOfFileErr);
+}
+
+
+//-------------------------------------------------------------------------
+// WavTurbo_Read 
+//-------------------------------------------------------------------------
+// Memory read, K7 port gives TTL level of the first channel at Cpu->Time (WavTurbo_K7Mask set if TTL High)
+uint8_t WavTurbo_Read(struct WavTurboCpu_Struct* Cpu, uint16_t Addr)
+{
+	const struct WavFormat_Struct* Format = Cpu->Format;
+	uint64_t SampleI;
+	int16_t WavSignal;
+
+	if (Addr != WavTurbo_K7Port) { return (Cpu->Mem[Addr]); }
+	SampleI = Cpu->Time * Format->SamplingFq / CpuFq;
+	if (SampleI >= Cpu->NSamples) { Cpu->EndOfSamples = true; return (0); }
+	SampleI *= (uint64_t)Format->NChannels * Format->Bytes_per_sample;
+	if (Format->Bytes_per_sample == 1)
+	{
+		WavSignal = Cpu->Samples[SampleI];
+	}
+	else
+	{
+		WavSignal = (int16_t)(Cpu->Samples[SampleI] | (Cpu->Samples[SampleI + 1] << 8)) / 256 + 128; // Back to 0-255
+	}
+	if (Format->InvertSignal != 0) { WavSignal = 255 - WavSignal; }
+	return (WavSignal >= 128 ? WavTurbo_K7Mask : 0);
+}
@@ -0,0 +1,71 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVTURBO_H
+#define WAVTURBO_H
+#include <stdint.h> 
+#include "Const.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Turbo loader ('K' option), binary programs only (ProgType 0x31)
+// A small loader is written as a normal binary program (read by the firmware), then after a pilot the program itself
+// in a denser encoding read by the loader: one TTL Low + TTL High pulse per bit, its length (loops of the loader) gives the bit
+// The user loads the loader, and starts it at its address (printed) while the pilot is played
+// The payload is read back by an emulation of the loader on the rendered samples of every format, margin is increased if it fails
+#define WavTurbo_Pilot_ms 3000 // Pilot of 0 bits, for the user to start the loader
+#define WavTurbo_SyncByte 0xA5 // Ends the pilot, bit 7 must be 1
+#define WavTurbo_MarginLoops 0 // Loops added to the difference between 0 and 1 bits (analog signal of a physical DAI)
+#define WavTurbo_RetryMax 3 // Payload written again with one more margin loop when not read back by the loader model
+#define WavTurbo_LoaderAddr 0x0300 // Loader address, moved after or before the program if they overlap
+#define WavTurbo_RamMin 0x0300 // Free Ram for the loader
+#define WavTurbo_RamMax 0xA000
+
+
+//-------------------------------------------------------------------------
+// Global constants 
+//-------------------------------------------------------------------------
+// Block 1 of a binary program is its load address (low byte first), block 2 is its content
+#define WavTurbo_ProgType 0x31
+#define WavTurbo_K7Port 0xFD00 // Read by the firmware for K7 input, bit 7 is the TTL level
+#define WavTurbo_K7Mask 0x80
+#define WavTurbo_LoaderSize 0x71 // Bytes of the loader (block 2 of the loader program)
+
+// Loader timing, Cpu cycles (see WavTurbo_LoaderCode). Loops read the K7 port every WavTurbo_LoopCycles
+// Other delays are from the K7 read which ends a bit (TTL Low seen) to the first K7 read of the next bit
+#define WavTurbo_LoopCycles 26
+#define WavTurbo_SyncCycles 73 // Pilot and SyncByte bits
+#define WavTurbo_DataStartCycles 80 // First bit after the SyncByte
+#define WavTurbo_InByteCycles 66 // Next bit in a byte
+#define WavTurbo_NextByteCycles 141 // First bit of a byte
+#define WavTurbo_NextPageCycles 163 // First bit of a byte when low byte of address equals the one of end address (and checksum byte)
+#define WavTurbo_ReadPhase 13 // An edge is written half a loop before the K7 read expected to see it
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t WavTurbo_TimingPass(void);
+
+#endif
@@ -0,0 +1,232 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/***********************************************************************************
+* Filename : WavValid.cpp
+***********************************************************************************/
+// Validate a wav file: the whole program is read with the WavIn firmware model in many conditions
+// Program read from the wav file in nominal conditions is the reference of all trials
+// Trials are independent, they are shared between one thread per core
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <thread>
+#include "Const.h"
+#include "FilesIO.h"
+#include "DgvMain.h"
+#include "WavIn.h"
+#include "WavOut.h"
+#include "WavValid.h"
+
+
+//-------------------------------------------------------------------------
+// Definitions
+//-------------------------------------------------------------------------
+#define WavValid_ThreadsMax 64
+
+struct WavValidRun_Struct // Shared by threads, each trial has its own result
+{
+	const uint8_t* Samples;
+	uint32_t Len;
+	struct WavFormat_Struct Format;
+	struct DaiBlock_Struct Blocks[DataBlock_Count]; // Reference program
+	uint8_t ProgType;
+	struct WavOutConfig_Struct Config; // Inter calls delays read with
+	struct WavInTrial_Struct* Trials;
+	int16_t* NErrs;
+	uint32_t NTrials;
+	uint32_t NThreads;
+};
+
+
+//-------------------------------------------------------------------------
+// Local functions
+//-------------------------------------------------------------------------
+void WavValid_Thread(struct WavValidRun_Struct* Run, uint32_t ThreadI);
+uint32_t WavValid_Random(uint32_t* State);
+
+
+//=========================================================================
+// FUNCTIONS
+//=========================================================================
+
+//-------------------------------------------------------------------------
+// DgvWavValid 
+//-------------------------------------------------------------------------
+// Validate a wav file (see WavValid.h), report is printed and appended to ReportName
+// Output : 0 or negative error (not an error if some trials fail)
+int16_t DgvWavValid(char* WavFileName, const char* ReportName)
+{
+	struct WavValidRun_Struct Run;
+	struct Wav_Struct Wav;
+	std::thread* Threads[WavValid_ThreadsMax];
+	uint8_t* Samples = NULL;
+	FILE* File;
+	char Report[2 * MaxLenString];
+	uint32_t Phases;
+	uint32_t TrialI;
+	uint32_t ThreadI;
+	uint32_t State = 0x2545F491;
+	uint32_t PhasesOk = 0;
+	uint32_t RandomOk = 0;
+	int16_t MinMargin = INT16_MAX;
+	uint8_t Parity = 1;
+	int16_t NErr;
+
+	Run.Trials = NULL;
+	Run.NErrs = NULL;
+
+	// Reference program, nominal read
+	NErr = DgvWavIn(WavFileName, 1);
+	if (NErr != 0) { Parity = 0; NErr = DgvWavIn(WavFileName, 0); }
+	if (NErr < 0)
+	{
+		sprintf(Report, "%s: not read by the firmware model (error %d)\n", WavFileName, NErr);
+		goto ValidReport;
+	}
+
+	// Samples of the wav file
+	if (ReadWavHeader(WavFileName, &Wav) < 0) { NErr = -WavInHeaderErr; goto ValidExit; }
+	if ((Wav.SampleLen < 1) || (Wav.SampleLen > 2)) { NErr = -WavInHeaderErr; goto ValidExit; }
+	Run.Len = (uint32_t)Wav.SamplesPerChannel * Wav.Head.BlockAlign;
+	Samples = (uint8_t*)malloc(Run.Len);
+	if (Samples == NULL) { NErr = -MemAllocErr; goto ValidExit; }
+	File = fopen(WavFileName, "rb");
+	if (File == NULL) { NErr = -WavOpenErr; goto ValidExit; }
+	if ((fseek(File, Wav.DataPos, SEEK_SET) != 0) || (fread(Samples, 1, Run.Len, File) != Run.Len)) { NErr = -WavInReadErr; }
+	fclose(File);
+	if (NErr < 0) { goto ValidExit; }
+
+	Run.Samples = Samples;
+	Run.Format.NChannels = (uint8_t)Wav.Head.NumChannels;
+	Run.Format.Bytes_per_sample = (uint8_t)Wav.SampleLen;
+	Run.Format.InvertSignal = Parity;
+	Run.Format.SamplingFq = Wav.Head.SampleRate;
+	Run.Format.AutoRate = 0;
+	Run.Format.EdgeShape = WavOutEdge_None;
+	memcpy(Run.Blocks, DaiBlocksInfo, sizeof(Run.Blocks));
+	Run.ProgType = Glob_ProgType;
+	WavOut_GetConfig(&Run.Config);
+
+	// Trials : every phase within a sample period, then random ones
+	Phases = (uint32_t)((CpuFq + Run.Format.SamplingFq - 1) / Run.Format.SamplingFq);
+	Run.NTrials = Phases + WavValid_RandomTrials;
+	Run.Trials = (struct WavInTrial_Struct*)calloc(Run.NTrials, sizeof(struct WavInTrial_Struct));
+	Run.NErrs = (int16_t*)calloc(Run.NTrials, sizeof(int16_t));
+	if ((Run.Trials == NULL) || (Run.NErrs == NULL)) { NErr = -MemAllocErr; goto ValidExit; }
+	for (TrialI = 0; TrialI < Run.NTrials; TrialI++)
+	{
+		if (TrialI < Phases)
+		{
+			Run.Trials[TrialI].EntryDelay = TrialI;
+			Run.Trials[TrialI].Interrupts = false;
+			continue;
+		}
+		Run.Trials[TrialI].EntryDelay = WavValid_Random(&State) % Phases;
+		Run.Trials[TrialI].Interrupts = true;
+		Run.Trials[TrialI].Rst6Delay = WavValid_Random(&State) % Rst6Period_Delay;
+		Run.Trials[TrialI].Rst7Delay = WavValid_Random(&State) % Rst7Period_Delay;
+		Run.Trials[TrialI].Noise = WavValid_Noise;
+		Run.Trials[TrialI].SpeedPpm = (int32_t)(WavValid_Random(&State) % (2 * WavValid_SpeedPpm + 1)) - WavValid_SpeedPpm;
+		Run.Trials[TrialI].Seed = WavValid_Random(&State);
+	}
+
+	Run.NThreads = std::thread::hardware_concurrency(); // 0 if unknown
+	if (Run.NThreads < 1) { Run.NThreads = 1; }
+	if (Run.NThreads > WavValid_ThreadsMax) { Run.NThreads = WavValid_ThreadsMax; }
+	for (ThreadI = 0; ThreadI < Run.NThreads; ThreadI++)
+	{
+		Threads[ThreadI] = NULL;
+		try
+		{
+			Threads[ThreadI] = new std::thread(WavValid_Thread, &Run, ThreadI);
+		}
+		catch (...)
+		{
+			WavValid_Thread(&Run, ThreadI); // No thread available, trials are run now
+		}
+	}
+	for (ThreadI = 0; ThreadI < Run.NThreads; ThreadI++)
+	{
+		if (Threads[ThreadI] != NULL)
+		{
+			Threads[ThreadI]->join();
+			delete Threads[ThreadI];
+		}
+	}
+
+	for (TrialI = 0; TrialI < Run.NTrials; TrialI++)
+	{
+		if (Run.NErrs[TrialI] < 0) continue;
+		if (TrialI < Phases) { PhasesOk++; } else { RandomOk++; }
+		if (Run.Trials[TrialI].BitMargin < MinMargin) { MinMargin = Run.Trials[TrialI].BitMargin; }
+	}
+	sprintf(Report, "%s: %.1f%% read, %u/%u phases, %u/%u random trials (noise %d, speed +/-%dppm, interrupts), minimum margin %d K7 read loops\n",
+		WavFileName, 100.0 * (PhasesOk + RandomOk) / Run.NTrials, PhasesOk, Phases, RandomOk, (uint32_t)WavValid_RandomTrials,
+		WavValid_Noise, WavValid_SpeedPpm, (MinMargin == INT16_MAX ? -1 : MinMargin));
+
+ValidReport:
+	printf("%s", Report);
+	File = fopen(ReportName, "a");
+	if (File == NULL) { NErr = -FileParamErr; goto ValidExit; }
+	fputs(Report, File);
+	fclose(File);
+
+ValidExit:
+	free(Samples);
+	free(Run.Trials);
+	free(Run.NErrs);
+	return (NErr < 0 ? NErr : 0);
+}
+
+
+//-------------------------------------------------------------------------
+// WavValid_Thread 
+//-------------------------------------------------------------------------
+// Run trials ThreadI, ThreadI + NThreads, ... with the reference program as program in memory of the thread
+void WavValid_Thread(struct WavValidRun_Struct* Run, uint32_t ThreadI)
+{
+	uint32_t TrialI;
+
+	memcpy(DaiBlocksInfo, Run->Blocks, sizeof(Run->Blocks));
+	Glob_ProgType = Run->ProgType;
+	WavOut_SetConfig(&Run->Config);
+	for (TrialI = ThreadI; TrialI < Run->NTrials; TrialI += Run->NThreads)
+	{
+		Run->NErrs[TrialI] = WavIn_TrialFromMemory(Run->Samples, Run->Len, &Run->Format, &Run->Trials[TrialI]);
+	}
+}
+
+
+//-------------------------------------------------------------------------
+// WavValid_Random 
+//-------------------------------------------------------------------------
+// Trials are the same from one run to the next (xorshift)
+uint32_t WavValid_Random(uint32_t* State)
+{
+	*State ^= *State << 13;
+	*State ^= *State >> 17;
+	*State ^= *State << 5;
+	return (*State);
+}
@@ -0,0 +1,46 @@
+// MIT License
+
+// Copyright(c) 2024 cstereo
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef WAVVALID_H
+#define WAVVALID_H
+#include <stdint.h> 
+#include "Const.h"
+
+
+//-------------------------------------------------------------------------
+// USER Definitions
+//-------------------------------------------------------------------------
+// Validation of a wav file ('Dgv File.wav *.val'), whole program read with the WavIn firmware model
+//	1) from every Cpu phase within one sample period, without interrupt
+//	2) WavValid_RandomTrials times with random phase, RST 6 / RST 7 timing, sample noise and playing speed error
+#define WavValid_RandomTrials 256
+#define WavValid_Noise 4 // Maximum noise added to each sample, on the 0-255 scale (trigger levels are 55 and 200, smoothed levels 50 and 208)
+#define WavValid_SpeedPpm 5000 // Maximum playing speed error (ppm)
+#define WavValid_Ext ".val" // Extension of report files
+
+
+//-------------------------------------------------------------------------
+// Global functions 
+//-------------------------------------------------------------------------
+int16_t DgvWavValid(char* WavFileName, const char* ReportName);
+
+#endif
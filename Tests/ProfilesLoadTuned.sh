@@ -0,0 +1,32 @@
+#!/bin/bash
+# Render the profiles of DaiHwI_BitMask with a tuned profile loaded ('Dgv --U')
+# Each profile must keep its own name and write the same wav as a single profile render ('--VxU')
+# Usage : Tests/ProfilesLoadTuned.sh <Dgv executable>
+Dgv=$(realpath "${1:-./Dgv}")
+Dir=$(mktemp -d)
+trap 'rm -rf "$Dir"' EXIT
+cp "$(dirname "$0")/../In/Envahisseurs.dai" "$Dir"
+cd "$Dir" || exit 1
+
+# DgvTuned.txt from V7 ('T' option)
+"$Dgv" Envahisseurs.dai '*.wav' --V7T > /dev/null 2>&1 || { echo "FAIL tuning"; exit 1; }
+[ -f DgvTuned.txt ] || { echo "FAIL DgvTuned.txt not written"; exit 1; }
+rm -f *.wav Dgv.cache
+
+# All profiles, then V3 and V7 alone
+"$Dgv" --U > /dev/null || { echo "FAIL Dgv --U"; exit 1; }
+mkdir V3 V7 && cp Envahisseurs.dai DgvTuned.txt V3 && cp Envahisseurs.dai DgvTuned.txt V7
+(cd V3 && "$Dgv" Envahisseurs.dai '*.wav' --V3U > /dev/null)
+(cd V7 && "$Dgv" Envahisseurs.dai '*.wav' --V7U > /dev/null)
+
+Fail=0
+for Wav in V3/Envahisseurs_DgvDaiV7B--V3UMBNF96000.wav V7/Envahisseurs_DgvMameA--V7UMBNF96000.wav
+do
+	if ! cmp -s "$Wav" "$(basename "$Wav")"; then echo "FAIL $(basename "$Wav")"; Fail=1; fi
+done
+if [ "$(ls Envahisseurs_*--V*U*.wav | wc -l)" != "$(ls Envahisseurs_*--V*U*.wav | sed 's/--.*//' | sort -u | wc -l)" ]
+then
+	echo "FAIL profiles written with the same name"; Fail=1
+fi
+[ $Fail == 0 ] && echo "OK"
+exit $Fail